@@ -21,32 +21,13 @@
 #include <errno.h>
 #include <assert.h>
 #include <math.h>
-#include "dmtx.h"
-#include "dmtxstatic.h"
 
 #ifdef HAVE_CONFIG_H
 #include "config.h"
 #endif
 
-#ifndef CALLBACK_POINT_PLOT
-#define CALLBACK_POINT_PLOT(a,b,c,d)
-#endif
-
-#ifndef CALLBACK_POINT_XFRM
-#define CALLBACK_POINT_XFRM(a,b,c,d)
-#endif
-
-#ifndef CALLBACK_MODULE
-#define CALLBACK_MODULE(a,b,c,d,e)
-#endif
-
-#ifndef CALLBACK_MATRIX
-#define CALLBACK_MATRIX(a)
-#endif
-
-#ifndef CALLBACK_FINAL
-#define CALLBACK_FINAL(a,b)
-#endif
+#include "dmtx.h"
+#include "dmtxstatic.h"
 
 /**
  * Use #include to merge the individual .c source files into a single combined
@@ -60,6 +41,12 @@
 #include "dmtxencodestream.c"
 #include "dmtxencodescheme.c"
 #include "dmtxencodeoptimize.c"
+#include "dmtxencodelookahead.c"
+#include "dmtxencodetemplate.c"
+#include "dmtxencodebatch.c"
+#include "dmtxencodesheet.c"
+#include "dmtxencodewrite.c"
+#include "dmtxencodecache.c"
 #include "dmtxencodeascii.c"
 #include "dmtxencodec40textx12.c"
 #include "dmtxencodeedifact.c"
@@ -67,6 +54,7 @@
 
 #include "dmtxdecode.c"
 #include "dmtxdecodescheme.c"
+#include "dmtxdecodegs1.c"
 
 #include "dmtxmessage.c"
 #include "dmtxregion.c"
@@ -77,6 +65,8 @@
 
 #include "dmtximage.c"
 #include "dmtxbytelist.c"
+#include "dmtxarena.c"
+#include "dmtxalloc.c"
 #include "dmtxtime.c"
 #include "dmtxvector2.c"
 #include "dmtxmatrix3.c"
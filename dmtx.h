@@ -65,6 +65,7 @@ extern "C" {
 
 #define DmtxSymbolSquareCount         24
 #define DmtxSymbolRectCount            6
+#define DmtxSymbolMaxBlocks           10
 
 #define DmtxModuleOff               0x00
 #define DmtxModuleOnRed             0x01
@@ -79,6 +80,10 @@ extern "C" {
 
 #define DMTX_CHECK_BOUNDS(l,i) (assert((i) >= 0 && (i) < (l)->length && (l)->length <= (l)->capacity))
 
+/* Unchecked push/pop for callers that already verified capacity or length */
+#define DMTX_BYTELIST_PUSH(l,v) (assert((l)->length < (l)->capacity), (l)->b[(l)->length++] = (v))
+#define DMTX_BYTELIST_POP(l)    (assert((l)->length > 0), (l)->b[--((l)->length)])
+
 typedef enum {
    DmtxStatusEncoding, /* Encoding is currently underway */
    DmtxStatusComplete, /* Encoding is done and everything went well */
@@ -182,6 +187,7 @@ typedef enum {
    DmtxPropSquareDevn,
    DmtxPropSymbolSize,
    DmtxPropEdgeThresh,
+   DmtxPropStats,
    /* Image properties */
    DmtxPropWidth             = 300,
    DmtxPropHeight,
@@ -233,8 +239,64 @@ typedef enum {
   DmtxFlipY                  = 0x01 << 1
 } DmtxFlip;
 
+typedef enum {
+   DmtxFormatPbm,
+   DmtxFormatPgm,
+   DmtxFormatPng
+} DmtxImageFormat;
+
+typedef enum {
+   DmtxStatsNone             = 0x00,
+   DmtxStatsCount            = 0x01 << 0,
+   DmtxStatsTime             = 0x01 << 1
+} DmtxStatsFlag;
+
+typedef enum {
+   DmtxStageSeekEdge,
+   DmtxStageOrientation,
+   DmtxStageAlignCalibEdge,
+   DmtxStageFindSize,
+   DmtxStageReadModules,
+   DmtxStageRsDecode,
+   DmtxStageDecodeData,
+   DmtxStageCount
+} DmtxDecodeStage;
+
+typedef enum {
+   DmtxTraceSeed             = 0x01 << 0,
+   DmtxTraceTrail            = 0x01 << 1,
+   DmtxTraceLine             = 0x01 << 2,
+   DmtxTraceRegion           = 0x01 << 3,
+   DmtxTraceSize             = 0x01 << 4,
+   DmtxTraceStage            = 0x01 << 5
+} DmtxTraceType;
+
+typedef enum {
+   DmtxSegmentData,
+   DmtxSegmentMacroHeader,
+   DmtxSegmentMacroTrailer,
+   DmtxSegmentFnc1,
+   DmtxSegmentEci
+} DmtxSegmentType;
+
 typedef double DmtxMatrix3[3][3];
 
+/**
+ * @struct DmtxAllocator
+ * @brief DmtxAllocator
+ * Memory functions used by the library. Memory from callocFunc and alignedFunc
+ * is released with freeFunc, and either one may be NULL to fall back on
+ * mallocFunc.
+ */
+typedef struct DmtxAllocator_struct {
+   void         *(*mallocFunc)(size_t size, void *userData);
+   void         *(*callocFunc)(size_t count, size_t size, void *userData);
+   void         *(*reallocFunc)(void *ptr, size_t size, void *userData);
+   void          (*freeFunc)(void *ptr, void *userData);
+   void         *(*alignedFunc)(size_t alignment, size_t size, void *userData);
+   void          *userData;
+} DmtxAllocator;
+
 /**
  * @struct DmtxPixelLoc
  * @brief DmtxPixelLoc
@@ -244,6 +306,18 @@ typedef struct DmtxPixelLoc_struct {
    int Y;
 } DmtxPixelLoc;
 
+/**
+ * @struct DmtxModuleRect
+ * @brief DmtxModuleRect
+ * Filled area of dark modules, in module units from the symbol's top-left
+ */
+typedef struct DmtxModuleRect_struct {
+   int             x;
+   int             y;
+   int             width;
+   int             height;
+} DmtxModuleRect;
+
 /**
  * @struct DmtxVector2
  * @brief DmtxVector2
@@ -311,8 +385,33 @@ typedef struct DmtxImage_struct {
    int             channelStart[4];
    int             bitsPerChannel[4];
    unsigned char  *pxl;
+   DmtxAllocator   allocator;     /* Allocator holding this struct (not pxl) */
 } DmtxImage;
 
+/**
+ * @struct DmtxSymbolInfo
+ * @brief DmtxSymbolInfo
+ * Constant attributes of one symbol size, packed into a single cache line so
+ * callers can fetch them once with dmtxGetSymbolInfo() and pass them along
+ */
+typedef struct DmtxSymbolInfo_struct {
+   short           symbolRows;
+   short           symbolCols;
+   short           dataRegionRows;
+   short           dataRegionCols;
+   short           horizDataRegions;
+   short           vertDataRegions;
+   short           mappingRows;
+   short           mappingCols;
+   short           interleavedBlocks;
+   short           blockErrorWords;
+   short           blockMaxCorrectable;
+   short           symbolDataWords;
+   short           symbolErrorWords;
+   short           symbolMaxCorrectable;
+   short           blockDataWords[DmtxSymbolMaxBlocks]; /* Data words in each interleaved block */
+} DmtxSymbolInfo;
+
 /**
  * @struct DmtxPointFlow
  * @brief DmtxPointFlow
@@ -343,6 +442,17 @@ typedef struct DmtxBestLine_struct {
    DmtxPixelLoc    locNeg;
 } DmtxBestLine;
 
+/**
+ * @struct DmtxArena
+ * @brief DmtxArena
+ */
+typedef struct DmtxArena_struct {
+   unsigned char  *storage;       /* Memory handed out to regions and messages */
+   size_t          size;          /* Size of storage in bytes */
+   size_t          used;          /* Bytes handed out so far */
+   DmtxBoolean     ownStorage;    /* Storage was allocated by the library */
+} DmtxArena;
+
 /**
  * @struct DmtxRegion
  * @brief DmtxRegion
@@ -394,6 +504,9 @@ typedef struct DmtxRegion_struct {
    /* Transform values */
    DmtxMatrix3     raw2fit;       /* 3x3 transformation from raw image to fitted barcode grid */
    DmtxMatrix3     fit2raw;       /* 3x3 transformation from fitted barcode grid to raw image */
+
+   DmtxArena      *arena;         /* Arena holding this struct, or NULL if on heap */
+   DmtxAllocator   allocator;     /* Allocator holding this struct if on heap */
 } DmtxRegion;
 
 /**
@@ -409,8 +522,40 @@ typedef struct DmtxMessage_struct {
    unsigned char  *array;         /* Pointer to internal representation of Data Matrix modules */
    unsigned char  *code;          /* Pointer to internal storage of code words (data and error) */
    unsigned char  *output;        /* Pointer to internal storage of decoded output */
+   DmtxArena      *arena;         /* Arena holding this message, or NULL if on heap */
+   DmtxAllocator   allocator;     /* Allocator holding this message if on heap */
 } DmtxMessage;
 
+/**
+ * @struct DmtxDecodeSegment
+ * @brief DmtxDecodeSegment
+ * Piece of a decoded message, pointing into the output buffer
+ */
+typedef struct DmtxDecodeSegment_struct {
+   int             type;          /* DmtxSegmentType */
+   int             scheme;        /* Encodation scheme in effect */
+   const unsigned char *data;     /* First byte of segment within output */
+   int             offset;        /* Position of data within output */
+   int             length;        /* Output bytes covered by segment (may be 0) */
+   int             eci;           /* ECI in effect (or designated), or DmtxUndefined */
+   int             macro;         /* 5 or 6 for Macro 05/06 messages, else DmtxUndefined */
+} DmtxDecodeSegment;
+
+typedef DmtxPassFail (*DmtxSegmentCallback)(const DmtxDecodeSegment *segment, void *userData);
+
+/**
+ * @struct DmtxGs1Field
+ * @brief DmtxGs1Field
+ * Application Identifier and its value within a decoded GS1 message
+ */
+typedef struct DmtxGs1Field_struct {
+   int             ai;            /* Application Identifier, e.g., 17 or 3103 */
+   int             aiLength;      /* Digits in AI, counting leading zeros */
+   const unsigned char *data;     /* Value within output */
+   int             offset;        /* Position of value within output */
+   int             length;        /* Length of value, excluding any GS */
+} DmtxGs1Field;
+
 /**
  * @struct DmtxScanGrid
  * @brief DmtxScanGrid
@@ -448,6 +593,44 @@ typedef struct DmtxTime_struct {
    unsigned long   usec;
 } DmtxTime;
 
+/**
+ * @struct DmtxDecodeStageStats
+ * @brief DmtxDecodeStageStats
+ */
+typedef struct DmtxDecodeStageStats_struct {
+   long            calls;      /* Times stage ran */
+   long            fails;      /* Times stage rejected its candidate */
+   double          nsec;       /* Cumulative time in stage (DmtxStatsTime only) */
+} DmtxDecodeStageStats;
+
+/**
+ * @struct DmtxDecodeStats
+ * @brief DmtxDecodeStats
+ */
+typedef struct DmtxDecodeStats_struct {
+   long            gridLocations;  /* Locations taken from scan grid */
+   long            visitedSkips;   /* Locations skipped for lying on an earlier trail */
+   long            regionsFound;   /* Regions passing every stage of detection */
+   DmtxDecodeStageStats stage[DmtxStageCount];
+} DmtxDecodeStats;
+
+/**
+ * @struct DmtxTraceEvent
+ * @brief DmtxTraceEvent
+ * Step of region detection or decoding, reported while it happens
+ */
+typedef struct DmtxTraceEvent_struct {
+   int             type;      /* DmtxTraceType */
+   DmtxPixelLoc    loc;       /* Seed and trail events: pixel location */
+   const DmtxBestLine *line;  /* Line events: fitted line, else NULL */
+   const DmtxRegion *reg;     /* Region and size events: region, else NULL */
+   int             stage;     /* Stage events: DmtxDecodeStage */
+   int             passFail;  /* Stage events: stage outcome */
+   double          nsec;      /* Stage events: time spent in stage */
+} DmtxTraceEvent;
+
+typedef void (*DmtxTraceCallback)(const DmtxTraceEvent *event, void *userData);
+
 /**
  * @struct DmtxDecode
  * @brief DmtxDecode
@@ -473,6 +656,13 @@ typedef struct DmtxDecode_struct {
    unsigned char  *cache;
    DmtxImage      *image;
    DmtxScanGrid    grid;
+   DmtxArena       arena;
+   DmtxAllocator   allocator;
+   int             statsFlags;
+   DmtxDecodeStats stats;
+   DmtxTraceCallback trace;   /* NULL unless tracing */
+   int             traceMask;
+   void           *traceUserData;
 } DmtxDecode;
 
 /**
@@ -490,11 +680,85 @@ typedef struct DmtxEncode_struct {
    int             rowPadBytes;
    DmtxMessage    *message;
    DmtxImage      *image;
+   size_t          arrayCapacity; /* Allocated size of message->array */
+   size_t          codeCapacity;  /* Allocated size of message->code */
+   size_t          pxlCapacity;   /* Allocated size of image->pxl */
+   DmtxAllocator   allocator;
    DmtxRegion      region;
    DmtxMatrix3     xfrm;  /* XXX still necessary? */
    DmtxMatrix3     rxfrm; /* XXX still necessary? */
 } DmtxEncode;
 
+/**
+ * @struct DmtxEncodeTemplate
+ * @brief DmtxEncodeTemplate
+ * Cached encoder state for labels sharing a fixed prefix
+ */
+typedef struct DmtxEncodeTemplate_struct {
+   DmtxEncode     *enc;          /* Settings, plus message and image of latest label */
+   DmtxByteList    input;        /* Prefix followed by variable part of latest label */
+   DmtxByteList    prefixOutput; /* Codewords of prefix chunks unaffected by variable part */
+   DmtxEncodeStream prefixStream; /* Stream state following those chunks */
+   int             prefixSize;
+   int             sizeIdx;      /* Symbol size of cached tables and image */
+   int            *placement;    /* Mapping matrix position of each codeword bit */
+   DmtxByte       *parity;       /* Error word contribution of each block position */
+} DmtxEncodeTemplate;
+
+/**
+ * @struct DmtxEncodeJob
+ * @brief DmtxEncodeJob
+ * One payload of a batch and the image it is rendered into
+ */
+typedef struct DmtxEncodeJob_struct {
+   int             inputSize;
+   unsigned char  *inputString;
+   unsigned char  *pxl;          /* Destination pixels, or NULL to allocate with enc allocator
+                                    (free those with dmtxEncodeJobRelease(), not free()) */
+   int             pxlSize;      /* Size of destination in bytes */
+   int             width;        /* Receives image width */
+   int             height;       /* Receives image height */
+   int             rowSizeBytes; /* Receives distance between starts of rows in bytes */
+   DmtxPassFail    passFail;     /* Receives result of encoding */
+} DmtxEncodeJob;
+
+typedef DmtxPassFail (*DmtxEncodeJobCallback)(DmtxEncodeJob *job, int jobIdx, void *userData);
+
+/**
+ * @struct DmtxSheetLayout
+ * @brief DmtxSheetLayout
+ * Grid of equally spaced label cells on a sheet, in pixels
+ */
+typedef struct DmtxSheetLayout_struct {
+   int             columns;    /* Cells per grid row */
+   int             rows;       /* Grid rows */
+   int             pitchX;     /* Distance between left edges of neighboring cells */
+   int             pitchY;     /* Distance between top edges of neighboring cells */
+   int             marginLeft; /* Left edge of first cell column */
+   int             marginTop;  /* Top edge of first cell row */
+} DmtxSheetLayout;
+
+typedef DmtxPassFail (*DmtxWriteCallback)(const unsigned char *data, int size, void *userData);
+
+/**
+ * @struct DmtxEncodeCache
+ * @brief DmtxEncodeCache
+ * Bounded cache of encoded symbols (contents private to dmtxencodecache.c)
+ */
+typedef struct DmtxEncodeCache_struct DmtxEncodeCache;
+
+/**
+ * @struct DmtxEncodeCacheStats
+ * @brief DmtxEncodeCacheStats
+ */
+typedef struct DmtxEncodeCacheStats_struct {
+   long            hits;       /* Lookups answered from cache */
+   long            misses;     /* Lookups that had to encode */
+   long            imageHits;  /* Images copied from cache instead of rendered */
+   long            evictions;  /* Entries dropped to make room */
+   int             entryCount; /* Entries currently held */
+} DmtxEncodeCacheStats;
+
 /**
  * @struct DmtxChannel
  * @brief DmtxChannel
@@ -535,6 +799,10 @@ typedef struct DmtxQuadruplet_struct {
    unsigned char   value[4];
 } DmtxQuadruplet;
 
+/* dmtxalloc.c */
+DMTX_DECL DmtxPassFail dmtxSetAllocator(const DmtxAllocator *allocator);
+DMTX_DECL DmtxAllocator dmtxGetAllocator(void);
+
 /* dmtxtime.c */
 DMTX_DECL DmtxTime dmtxTimeNow(void);
 DMTX_DECL DmtxTime dmtxTimeAdd(DmtxTime t, long msec);
@@ -542,20 +810,58 @@ DMTX_DECL int dmtxTimeExceeded(DmtxTime timeout);
 
 /* dmtxencode.c */
 DMTX_DECL DmtxEncode *dmtxEncodeCreate(void);
+DMTX_DECL DmtxEncode *dmtxEncodeCreateWithAllocator(const DmtxAllocator *allocator);
 DMTX_DECL DmtxPassFail dmtxEncodeDestroy(DmtxEncode **enc);
+DMTX_DECL DmtxPassFail dmtxEncodeReset(DmtxEncode *enc);
 DMTX_DECL DmtxPassFail dmtxEncodeSetProp(DmtxEncode *enc, int prop, int value);
 DMTX_DECL int dmtxEncodeGetProp(DmtxEncode *enc, int prop);
 DMTX_DECL DmtxPassFail dmtxEncodeDataMatrix(DmtxEncode *enc, int n, unsigned char *s);
+DMTX_DECL DmtxPassFail dmtxEncodeMeasure(DmtxEncode *enc, int n, unsigned char *s, /*@out@*/ int *width, /*@out@*/ int *height, /*@out@*/ int *rowSizeBytes);
+DMTX_DECL DmtxPassFail dmtxEncodeDataMatrixBuffer(DmtxEncode *enc, int n, unsigned char *s, unsigned char *pxl, int width, int height, int rowSizeBytes);
+DMTX_DECL DmtxPassFail dmtxEncodeModules(DmtxEncode *enc, int n, unsigned char *s, /*@out@*/ unsigned char *modules, int modulesSize, /*@out@*/ int *rows, /*@out@*/ int *cols);
+DMTX_DECL int dmtxEncodeModuleRects(const unsigned char *modules, int rows, int cols, /*@out@*/ DmtxModuleRect *rects, int maxRects);
 DMTX_DECL DmtxPassFail dmtxEncodeDataMosaic(DmtxEncode *enc, int n, unsigned char *s);
 
+/* dmtxencodetemplate.c */
+DMTX_DECL DmtxEncodeTemplate *dmtxEncodeTemplateCreate(DmtxEncode *enc, int n, unsigned char *s);
+DMTX_DECL DmtxPassFail dmtxEncodeTemplateDestroy(DmtxEncodeTemplate **tpl);
+DMTX_DECL DmtxPassFail dmtxEncodeTemplateDataMatrix(DmtxEncodeTemplate *tpl, int n, unsigned char *s);
+
+/* dmtxencodebatch.c */
+DMTX_DECL DmtxPassFail dmtxEncodeBatch(DmtxEncode *enc, DmtxEncodeJob *jobs, int jobCount, int threadCount, DmtxEncodeJobCallback callback, void *userData);
+DMTX_DECL DmtxPassFail dmtxEncodeJobRelease(DmtxEncode *enc, DmtxEncodeJob *job);
+
+/* dmtxencodesheet.c */
+DMTX_DECL DmtxPassFail dmtxEncodeSheet(DmtxEncode *enc, const DmtxSheetLayout *layout, int *n, unsigned char **s, unsigned char *pxl, int width, int height, int rowSizeBytes);
+
+/* dmtxencodewrite.c */
+DMTX_DECL DmtxPassFail dmtxEncodeWrite(DmtxEncode *enc, int n, unsigned char *s, int format, DmtxWriteCallback callback, void *userData);
+DMTX_DECL DmtxPassFail dmtxEncodeWriteFile(DmtxEncode *enc, int n, unsigned char *s, int format, const char *path);
+
+/* dmtxencodecache.c */
+DMTX_DECL DmtxEncodeCache *dmtxEncodeCacheCreate(int maxEntries, DmtxBoolean keepImages);
+DMTX_DECL DmtxEncodeCache *dmtxEncodeCacheCreateWithAllocator(int maxEntries, DmtxBoolean keepImages, const DmtxAllocator *allocator);
+DMTX_DECL DmtxPassFail dmtxEncodeCacheDestroy(DmtxEncodeCache **cache);
+DMTX_DECL DmtxPassFail dmtxEncodeCacheGetStats(DmtxEncodeCache *cache, /*@out@*/ DmtxEncodeCacheStats *stats);
+DMTX_DECL DmtxPassFail dmtxEncodeCacheModules(DmtxEncodeCache *cache, DmtxEncode *enc, int n, unsigned char *s, /*@out@*/ unsigned char *modules, int modulesSize, /*@out@*/ int *rows, /*@out@*/ int *cols);
+DMTX_DECL DmtxPassFail dmtxEncodeCacheImage(DmtxEncodeCache *cache, DmtxEncode *enc, int n, unsigned char *s, unsigned char *pxl, int pxlSize, /*@out@*/ int *width, /*@out@*/ int *height, /*@out@*/ int *rowSizeBytes);
+
 /* dmtxdecode.c */
 DMTX_DECL DmtxDecode *dmtxDecodeCreate(DmtxImage *img, int scale);
+DMTX_DECL DmtxDecode *dmtxDecodeCreateWithAllocator(DmtxImage *img, int scale, const DmtxAllocator *allocator);
 DMTX_DECL DmtxPassFail dmtxDecodeDestroy(DmtxDecode **dec);
+DMTX_DECL DmtxPassFail dmtxDecodeSetArena(DmtxDecode *dec, unsigned char *storage, size_t size);
 DMTX_DECL DmtxPassFail dmtxDecodeSetProp(DmtxDecode *dec, int prop, int value);
 DMTX_DECL int dmtxDecodeGetProp(DmtxDecode *dec, int prop);
+DMTX_DECL DmtxPassFail dmtxDecodeGetStats(DmtxDecode *dec, /*@out@*/ DmtxDecodeStats *stats);
+DMTX_DECL DmtxPassFail dmtxDecodeResetStats(DmtxDecode *dec);
+DMTX_DECL DmtxPassFail dmtxDecodeSetTrace(DmtxDecode *dec, DmtxTraceCallback callback, int mask, void *userData);
 DMTX_DECL /*@exposed@*/ unsigned char *dmtxDecodeGetCache(DmtxDecode *dec, int x, int y);
 DMTX_DECL DmtxPassFail dmtxDecodeGetPixelValue(DmtxDecode *dec, int x, int y, int channel, /*@out@*/ int *value);
 DMTX_DECL DmtxMessage *dmtxDecodeMatrixRegion(DmtxDecode *dec, DmtxRegion *reg, int fix);
+DMTX_DECL DmtxPassFail dmtxDecodeMatrixRegionBuffer(DmtxDecode *dec, DmtxRegion *reg, int fix, unsigned char *output, int outputSize, /*@out@*/ int *outputLength);
+DMTX_DECL DmtxPassFail dmtxDecodeMatrixRegionSegments(DmtxDecode *dec, DmtxRegion *reg, int fix, unsigned char *output, int outputSize, /*@out@*/ int *outputLength, DmtxSegmentCallback callback, void *userData);
+DMTX_DECL DmtxPassFail dmtxDecodeMatrixRegionGs1(DmtxDecode *dec, DmtxRegion *reg, int fix, unsigned char *output, int outputSize, /*@out@*/ int *outputLength, /*@out@*/ DmtxGs1Field *field, int fieldSize, /*@out@*/ int *fieldCount);
 DMTX_DECL DmtxMessage *dmtxDecodeMosaicRegion(DmtxDecode *dec, DmtxRegion *reg, int fix);
 DMTX_DECL unsigned char *dmtxDecodeCreateDiagnostic(DmtxDecode *dec, /*@out@*/ int *totalBytes, /*@out@*/ int *headerBytes, int style);
 
@@ -574,6 +880,7 @@ DMTX_DECL DmtxPassFail dmtxMessageDestroy(DmtxMessage **msg);
 
 /* dmtximage.c */
 DMTX_DECL DmtxImage *dmtxImageCreate(unsigned char *pxl, int width, int height, int pack);
+DMTX_DECL DmtxImage *dmtxImageCreateWithAllocator(unsigned char *pxl, int width, int height, int pack, const DmtxAllocator *allocator);
 DMTX_DECL DmtxPassFail dmtxImageDestroy(DmtxImage **img);
 DMTX_DECL DmtxPassFail dmtxImageSetChannel(DmtxImage *img, int channelStart, int bitsPerChannel);
 DMTX_DECL DmtxPassFail dmtxImageSetProp(DmtxImage *img, int prop, int value);
@@ -619,6 +926,7 @@ DMTX_DECL void dmtxMatrix3Print(DmtxMatrix3 m);
 
 /* dmtxsymbol.c */
 DMTX_DECL int dmtxSymbolModuleStatus(DmtxMessage *mapping, int sizeIdx, int row, int col);
+DMTX_DECL const DmtxSymbolInfo *dmtxGetSymbolInfo(int sizeIdx);
 DMTX_DECL int dmtxGetSymbolAttribute(int attribute, int sizeIdx);
 DMTX_DECL int dmtxGetBlockDataSize(int sizeIdx, int blockIdx);
 
@@ -628,6 +936,8 @@ DMTX_DECL void dmtxByteListInit(DmtxByteList *list, int length, DmtxByte value,
 DMTX_DECL void dmtxByteListClear(DmtxByteList *list);
 DMTX_DECL DmtxBoolean dmtxByteListHasCapacity(DmtxByteList *list);
 DMTX_DECL void dmtxByteListCopy(DmtxByteList *dst, const DmtxByteList *src, DmtxPassFail *passFail);
+DMTX_DECL void dmtxByteListAppend(DmtxByteList *list, const DmtxByte *values, int count, DmtxPassFail *passFail);
+DMTX_DECL DmtxByte *dmtxByteListReserve(DmtxByteList *list, int count, DmtxPassFail *passFail);
 DMTX_DECL void dmtxByteListPush(DmtxByteList *list, DmtxByte value, DmtxPassFail *passFail);
 DMTX_DECL DmtxByte dmtxByteListPop(DmtxByteList *list, DmtxPassFail *passFail);
 DMTX_DECL void dmtxByteListPrint(DmtxByteList *list, char *prefix);
@@ -0,0 +1,200 @@
+/**
+ * libdmtx - Data Matrix Encoding/Decoding Library
+ * Copyright 2011 Mike Laughton. All rights reserved.
+ *
+ * See LICENSE file in the main project directory for full
+ * terms of use and distribution.
+ *
+ * Contact: Mike Laughton <mike@dragonflylogic.com>
+ *
+ * \file dmtxalloc.c
+ * \brief Routing library allocations through replaceable functions
+ */
+
+static DmtxAllocator globalAllocator = {
+   DefaultMalloc, NULL, DefaultRealloc, DefaultFree, NULL, NULL
+};
+
+/**
+ * \brief  Replace allocator used by objects created from now on
+ *
+ * Each object keeps a copy of the allocator it was created with and releases
+ * its memory through that copy, so objects created before the change are
+ * unaffected. This is not synchronized with other threads and is meant to be
+ * called once at startup.
+ *
+ * \param  allocator New allocator, or NULL to restore the C library's
+ * \return DmtxPass | DmtxFail (mallocFunc, reallocFunc, or freeFunc missing)
+ */
+DmtxPassFail
+dmtxSetAllocator(const DmtxAllocator *allocator)
+{
+   static const DmtxAllocator defaultAllocator = {
+      DefaultMalloc, NULL, DefaultRealloc, DefaultFree, NULL, NULL
+   };
+
+   if(allocator == NULL) {
+      globalAllocator = defaultAllocator;
+      return DmtxPass;
+   }
+
+   if(allocator->mallocFunc == NULL || allocator->reallocFunc == NULL ||
+         allocator->freeFunc == NULL)
+      return DmtxFail;
+
+   globalAllocator = *allocator;
+
+   return DmtxPass;
+}
+
+/**
+ * \brief  Get allocator used by objects created from now on
+ * \return Copy of global allocator
+ */
+DmtxAllocator
+dmtxGetAllocator(void)
+{
+   return globalAllocator;
+}
+
+/**
+ * \brief  Resolve allocator for a new object
+ * \param  allocator Caller's allocator, or NULL for global allocator
+ * \return Allocator to copy into the object
+ */
+static const DmtxAllocator *
+AllocSelect(const DmtxAllocator *allocator)
+{
+   if(allocator == NULL || allocator->mallocFunc == NULL ||
+         allocator->reallocFunc == NULL || allocator->freeFunc == NULL)
+      return &globalAllocator;
+
+   return allocator;
+}
+
+/**
+ * \brief  Allocate memory through allocator
+ * \param  allocator Allocator, or NULL for global allocator
+ * \param  size
+ * \return Uninitialized memory, or NULL
+ */
+static void *
+AllocMalloc(const DmtxAllocator *allocator, size_t size)
+{
+   allocator = AllocSelect(allocator);
+
+   return (*allocator->mallocFunc)(size, allocator->userData);
+}
+
+/**
+ * \brief  Allocate zeroed memory through allocator
+ * \param  allocator Allocator, or NULL for global allocator
+ * \param  count
+ * \param  size
+ * \return Zeroed memory, or NULL
+ */
+static void *
+AllocCalloc(const DmtxAllocator *allocator, size_t count, size_t size)
+{
+   void *ptr;
+
+   allocator = AllocSelect(allocator);
+
+   if(allocator->callocFunc != NULL)
+      return (*allocator->callocFunc)(count, size, allocator->userData);
+
+   if(size > 0 && count > (size_t)-1 / size)
+      return NULL;
+
+   ptr = (*allocator->mallocFunc)(count * size, allocator->userData);
+   if(ptr != NULL)
+      memset(ptr, 0x00, count * size);
+
+   return ptr;
+}
+
+/**
+ * \brief  Resize memory through allocator
+ * \param  allocator Allocator, or NULL for global allocator
+ * \param  ptr Memory from the same allocator, or NULL
+ * \param  size
+ * \return Resized memory, or NULL (ptr left as is)
+ */
+static void *
+AllocRealloc(const DmtxAllocator *allocator, void *ptr, size_t size)
+{
+   allocator = AllocSelect(allocator);
+
+   return (*allocator->reallocFunc)(ptr, size, allocator->userData);
+}
+
+/**
+ * \brief  Allocate memory for pixel data, aligned to DmtxAllocAlign if the
+ *         allocator supports it
+ * \param  allocator Allocator, or NULL for global allocator
+ * \param  size
+ * \return Uninitialized memory, or NULL
+ */
+static void *
+AllocAligned(const DmtxAllocator *allocator, size_t size)
+{
+   allocator = AllocSelect(allocator);
+
+   if(allocator->alignedFunc != NULL)
+      return (*allocator->alignedFunc)(DmtxAllocAlign, size, allocator->userData);
+
+   return (*allocator->mallocFunc)(size, allocator->userData);
+}
+
+/**
+ * \brief  Free memory through allocator
+ * \param  allocator Allocator, or NULL for global allocator
+ * \param  ptr Memory from the same allocator, or NULL
+ * \return void
+ */
+static void
+AllocFree(const DmtxAllocator *allocator, void *ptr)
+{
+   if(ptr == NULL)
+      return;
+
+   allocator = AllocSelect(allocator);
+
+   (*allocator->freeFunc)(ptr, allocator->userData);
+}
+
+/**
+ *
+ *
+ */
+static void *
+DefaultMalloc(size_t size, void *userData)
+{
+   (void)userData;
+
+   return malloc(size);
+}
+
+/**
+ *
+ *
+ */
+static void *
+DefaultRealloc(void *ptr, size_t size, void *userData)
+{
+   (void)userData;
+
+   return realloc(ptr, size);
+}
+
+/**
+ *
+ *
+ */
+static void
+DefaultFree(void *ptr, void *userData)
+{
+   (void)userData;
+
+   free(ptr);
+}
@@ -0,0 +1,100 @@
+/**
+ * libdmtx - Data Matrix Encoding/Decoding Library
+ * Copyright 2011 Mike Laughton. All rights reserved.
+ *
+ * See LICENSE file in the main project directory for full
+ * terms of use and distribution.
+ *
+ * Contact: Mike Laughton <mike@dragonflylogic.com>
+ *
+ * \file dmtxarena.c
+ * \brief Bump allocator backing a decode session
+ */
+
+#define DmtxArenaAlign            16 /* Enough for any struct field type */
+#define DmtxArenaRound(s)         (((s) + DmtxArenaAlign - 1) & ~(size_t)(DmtxArenaAlign - 1))
+
+/**
+ * \brief  Set up arena over storage
+ *
+ * Caller storage may start anywhere, so used begins at the first aligned
+ * address. Blocks are rounded up to the alignment from there on, which keeps
+ * every block start aligned and lets ArenaFree() rewind without leaving
+ * padding behind.
+ *
+ * \param  arena
+ * \param  storage
+ * \param  size Size of storage in bytes
+ * \return void
+ */
+static void
+ArenaInit(DmtxArena *arena, unsigned char *storage, size_t size)
+{
+   arena->storage = storage;
+   arena->size = size;
+   arena->used = (DmtxArenaAlign - ((size_t)storage % DmtxArenaAlign)) % DmtxArenaAlign;
+   if(arena->used > size)
+      arena->used = size;
+}
+
+/**
+ * \brief  Hand out memory from arena
+ * \param  arena Arena, or NULL
+ * \param  size Bytes requested
+ * \return Uninitialized memory, or NULL if arena is NULL, unused, or full
+ */
+static void *
+ArenaAlloc(DmtxArena *arena, size_t size)
+{
+   size_t offset;
+
+   if(arena == NULL || arena->storage == NULL)
+      return NULL;
+
+   offset = arena->used;
+   if(size > arena->size - offset || DmtxArenaRound(size) > arena->size - offset)
+      return NULL;
+
+   arena->used = offset + DmtxArenaRound(size);
+
+   return arena->storage + offset;
+}
+
+/**
+ * \brief  Return memory to arena
+ *
+ * A block that ends where the arena's used space ends is reclaimed, so
+ * blocks released in reverse order of allocation (scratch buffers, then a
+ * message, then its region) all go back. Anything else stays in use until
+ * the arena itself is released.
+ *
+ * \param  arena
+ * \param  ptr Memory from ArenaAlloc()
+ * \param  size Bytes requested when ptr was allocated
+ * \return void
+ */
+static void
+ArenaFree(DmtxArena *arena, void *ptr, size_t size)
+{
+   unsigned char *start;
+
+   start = (unsigned char *)ptr;
+   size = DmtxArenaRound(size);
+   if(start >= arena->storage && start + size == arena->storage + arena->used)
+      arena->used = (size_t)(start - arena->storage);
+}
+
+/**
+ * \brief  Release arena storage and leave arena unused
+ * \param  arena
+ * \param  allocator Allocator that provided storage, if library owned
+ * \return void
+ */
+static void
+ArenaRelease(DmtxArena *arena, const DmtxAllocator *allocator)
+{
+   if(arena->ownStorage == DmtxTrue)
+      AllocFree(allocator, arena->storage);
+
+   memset(arena, 0x00, sizeof(DmtxArena));
+}
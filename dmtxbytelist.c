@@ -73,23 +73,67 @@ dmtxByteListHasCapacity(DmtxByteList *list)
 void
 dmtxByteListCopy(DmtxByteList *dst, const DmtxByteList *src, DmtxPassFail *passFail)
 {
-   int length;
-
    if(dst->capacity < src->length)
    {
       *passFail = DmtxFail; /* dst must be large enough to hold src data */
    }
    else
    {
-      /* Copy as many bytes as dst can hold or src can provide (smaller of two) */
-      length = (dst->capacity < src->capacity) ? dst->capacity : src->capacity;
-
+      /* Only the used portion of src carries data */
       dst->length = src->length;
-      memcpy(dst->b, src->b, sizeof(unsigned char) * length);
+      memcpy(dst->b, src->b, sizeof(DmtxByte) * src->length);
+      *passFail = DmtxPass;
+   }
+}
+
+/**
+ * \brief  Append several values to end of list in one step
+ * \param  list
+ * \param  values
+ * \param  count
+ * \param  passFail Set to DmtxFail (list unchanged) if values don't fit
+ * \return void
+ */
+void
+dmtxByteListAppend(DmtxByteList *list, const DmtxByte *values, int count, DmtxPassFail *passFail)
+{
+   if(count < 0 || count > list->capacity - list->length)
+   {
+      *passFail = DmtxFail;
+   }
+   else
+   {
+      memcpy(list->b + list->length, values, sizeof(DmtxByte) * count);
+      list->length += count;
       *passFail = DmtxPass;
    }
 }
 
+/**
+ * \brief  Extend list by count values for the caller to fill in directly
+ * \param  list
+ * \param  count
+ * \param  passFail Set to DmtxFail (list unchanged) if there is no room
+ * \return Pointer to first reserved value, or NULL on failure
+ */
+DmtxByte *
+dmtxByteListReserve(DmtxByteList *list, int count, DmtxPassFail *passFail)
+{
+   DmtxByte *reserved;
+
+   if(count < 0 || count > list->capacity - list->length)
+   {
+      *passFail = DmtxFail;
+      return NULL;
+   }
+
+   reserved = list->b + list->length;
+   list->length += count;
+   *passFail = DmtxPass;
+
+   return reserved;
+}
+
 /**
  *
  *
@@ -19,14 +19,32 @@
  */
 DmtxDecode *
 dmtxDecodeCreate(DmtxImage *img, int scale)
+{
+   return dmtxDecodeCreateWithAllocator(img, scale, NULL);
+}
+
+/**
+ * \brief  Initialize decode struct that allocates through its own allocator
+ * \param  img
+ * \param  scale
+ * \param  allocator Used for the decoder and the regions and messages it
+ *         returns, or NULL for the global allocator
+ * \return Initialized DmtxDecode struct
+ */
+DmtxDecode *
+dmtxDecodeCreateWithAllocator(DmtxImage *img, int scale, const DmtxAllocator *allocator)
 {
    DmtxDecode *dec;
    int width, height;
 
-   dec = (DmtxDecode *)calloc(1, sizeof(DmtxDecode));
+   allocator = AllocSelect(allocator);
+
+   dec = (DmtxDecode *)AllocCalloc(allocator, 1, sizeof(DmtxDecode));
    if(dec == NULL)
       return NULL;
 
+   dec->allocator = *allocator;
+
    width = dmtxImageGetProp(img, DmtxPropWidth) / scale;
    height = dmtxImageGetProp(img, DmtxPropHeight) / scale;
 
@@ -43,11 +61,12 @@ dmtxDecodeCreate(DmtxImage *img, int scale)
    dec->yMax = height - 1;
    dec->scale = scale;
 
-   dec->cache = (unsigned char *)calloc(width * height, sizeof(unsigned char));
+   dec->cache = (unsigned char *)AllocAligned(allocator, width * height);
    if(dec->cache == NULL) {
-      free(dec);
+      AllocFree(allocator, dec);
       return NULL;
    }
+   memset(dec->cache, 0x00, width * height);
 
    dec->image = img;
    dec->grid = InitScanGrid(dec);
@@ -66,16 +85,59 @@ dmtxDecodeDestroy(DmtxDecode **dec)
    if(dec == NULL || *dec == NULL)
       return DmtxFail;
 
-   if((*dec)->cache != NULL)
-      free((*dec)->cache);
+   AllocFree(&((*dec)->allocator), (*dec)->cache);
+
+   ArenaRelease(&((*dec)->arena), &((*dec)->allocator));
 
-   free(*dec);
+   AllocFree(&((*dec)->allocator), *dec);
 
    *dec = NULL;
 
    return DmtxPass;
 }
 
+/**
+ * \brief  Draw regions, messages, and scratch memory from a single arena
+ *
+ * Once set, everything the decoder allocates while scanning and decoding
+ * comes out of storage by bumping a pointer, and falls back to the heap only
+ * when the arena is full. Nothing in the arena is freed individually: all of
+ * it is released at once by dmtxDecodeDestroy(), or by setting a new arena,
+ * so regions and messages from an arena must not be used after that. Calling
+ * dmtxRegionDestroy() and dmtxMessageDestroy() on them is still allowed, and
+ * returns the memory right away when nothing allocated later is still held,
+ * so destroying each message and then its region keeps the arena from
+ * filling up.
+ *
+ * \param  dec
+ * \param  storage Caller's memory to use (kept by caller), or NULL to have
+ *         the library allocate size bytes
+ * \param  size Size of arena in bytes, or 0 to go back to heap allocation
+ * \return DmtxPass | DmtxFail
+ */
+DmtxPassFail
+dmtxDecodeSetArena(DmtxDecode *dec, unsigned char *storage, size_t size)
+{
+   if(dec == NULL)
+      return DmtxFail;
+
+   ArenaRelease(&(dec->arena), &(dec->allocator));
+
+   if(size == 0)
+      return DmtxPass;
+
+   if(storage == NULL) {
+      storage = (unsigned char *)AllocMalloc(&(dec->allocator), size);
+      if(storage == NULL)
+         return DmtxFail;
+      dec->arena.ownStorage = DmtxTrue;
+   }
+
+   ArenaInit(&(dec->arena), storage, size);
+
+   return DmtxPass;
+}
+
 /**
  * \brief  Set decoding behavior property
  * \param  dec
@@ -105,6 +167,10 @@ dmtxDecodeSetProp(DmtxDecode *dec, int prop, int value)
       case DmtxPropEdgeThresh:
          dec->edgeThresh = value;
          break;
+      /* Leaves scan grid alone, so it can be switched in mid-scan */
+      case DmtxPropStats:
+         dec->statsFlags = value;
+         return DmtxPass;
       /* Min and Max values arrive unscaled */
       case DmtxPropXmin:
          dec->xMin = value / dec->scale;
@@ -159,6 +225,8 @@ dmtxDecodeGetProp(DmtxDecode *dec, int prop)
          return dec->sizeIdxExpected;
       case DmtxPropEdgeThresh:
          return dec->edgeThresh;
+      case DmtxPropStats:
+         return dec->statsFlags;
       case DmtxPropXmin:
          return dec->xMin;
       case DmtxPropXmax:
@@ -180,6 +248,204 @@ dmtxDecodeGetProp(DmtxDecode *dec, int prop)
    return DmtxUndefined;
 }
 
+/**
+ * \brief  Get counters collected while scanning and decoding
+ *
+ * Collection is off by default. Setting DmtxPropStats to DmtxStatsCount
+ * counts grid locations and, for each stage of detection and decoding, how
+ * often it ran and how often it rejected its candidate. Adding DmtxStatsTime
+ * also totals the time spent in each stage, at the cost of two clock reads
+ * per stage. Counters accumulate across images until dmtxDecodeResetStats().
+ *
+ * \param  dec
+ * \param  stats Receives copy of counters
+ * \return DmtxPass | DmtxFail
+ */
+DmtxPassFail
+dmtxDecodeGetStats(DmtxDecode *dec, DmtxDecodeStats *stats)
+{
+   if(dec == NULL || stats == NULL)
+      return DmtxFail;
+
+   *stats = dec->stats;
+
+   return DmtxPass;
+}
+
+/**
+ * \brief  Zero counters collected while scanning and decoding
+ * \param  dec
+ * \return DmtxPass | DmtxFail
+ */
+DmtxPassFail
+dmtxDecodeResetStats(DmtxDecode *dec)
+{
+   if(dec == NULL)
+      return DmtxFail;
+
+   memset(&(dec->stats), 0x00, sizeof(DmtxDecodeStats));
+
+   return DmtxPass;
+}
+
+/**
+ * \brief  Report detection and decoding steps to a callback as they happen
+ *
+ * The callback receives every event whose type is set in mask: edge seeds
+ * that start a trail, each step along a trail, fitted finder and calibration
+ * lines, regions once their finder pattern is fitted, symbol size decisions,
+ * and the outcome and duration of every stage counted by dmtxDecodeGetStats().
+ * Events point at the decoder's working data, which is only valid during the
+ * callback. With no callback set, each event site costs one test.
+ *
+ * \param  dec
+ * \param  callback Receives events, or NULL to stop tracing
+ * \param  mask DmtxTraceType values of events wanted, combined with |
+ * \param  userData Passed to callback
+ * \return DmtxPass | DmtxFail
+ */
+DmtxPassFail
+dmtxDecodeSetTrace(DmtxDecode *dec, DmtxTraceCallback callback, int mask, void *userData)
+{
+   if(dec == NULL)
+      return DmtxFail;
+
+   dec->trace = (mask != 0) ? callback : NULL;
+   dec->traceMask = mask;
+   dec->traceUserData = userData;
+
+   return DmtxPass;
+}
+
+/**
+ * \brief  Note start time of a stage if stages are being timed or traced
+ * \param  dec
+ * \return Time now, or zero time when not timing
+ */
+static DmtxTime
+StatsStart(DmtxDecode *dec)
+{
+   DmtxTime start;
+
+   if((dec->statsFlags & DmtxStatsTime) ||
+         (dec->trace != NULL && (dec->traceMask & DmtxTraceStage)))
+      return dmtxTimeNow();
+
+   start.sec = 0;
+   start.usec = 0;
+
+   return start;
+}
+
+/**
+ * \brief  Record outcome of a stage, and trace it if requested
+ * \param  dec
+ * \param  stage DmtxDecodeStage
+ * \param  start Value from StatsStart()
+ * \param  passFail Stage outcome
+ * \return passFail, unchanged
+ */
+static DmtxPassFail
+StatsStop(DmtxDecode *dec, int stage, DmtxTime start, DmtxPassFail passFail)
+{
+   double nsec;
+   DmtxDecodeStageStats *stageStats;
+   DmtxTraceEvent event;
+
+   if(dec->statsFlags == DmtxStatsNone && dec->trace == NULL)
+      return passFail;
+
+   nsec = (start.sec != 0 || start.usec != 0) ? TimeElapsedNsec(start) : 0.0;
+
+   if(dec->statsFlags != DmtxStatsNone) {
+      stageStats = &(dec->stats.stage[stage]);
+      stageStats->calls++;
+
+      if(passFail == DmtxFail)
+         stageStats->fails++;
+
+      if(dec->statsFlags & DmtxStatsTime)
+         stageStats->nsec += nsec;
+   }
+
+   if(dec->trace != NULL && (dec->traceMask & DmtxTraceStage)) {
+      memset(&event, 0x00, sizeof(DmtxTraceEvent));
+      event.type = DmtxTraceStage;
+      event.stage = stage;
+      event.passFail = passFail;
+      event.nsec = nsec;
+      (*dec->trace)(&event, dec->traceUserData);
+   }
+
+   return passFail;
+}
+
+/**
+ * \brief  Trace seed or trail location
+ * \param  dec
+ * \param  type DmtxTraceSeed | DmtxTraceTrail
+ * \param  loc
+ * \return void
+ */
+static void
+TracePoint(DmtxDecode *dec, int type, DmtxPixelLoc loc)
+{
+   DmtxTraceEvent event;
+
+   if(dec->trace == NULL || !(dec->traceMask & type))
+      return;
+
+   memset(&event, 0x00, sizeof(DmtxTraceEvent));
+   event.type = type;
+   event.loc = loc;
+
+   (*dec->trace)(&event, dec->traceUserData);
+}
+
+/**
+ * \brief  Trace fitted line
+ * \param  dec
+ * \param  line
+ * \return void
+ */
+static void
+TraceLine(DmtxDecode *dec, const DmtxBestLine *line)
+{
+   DmtxTraceEvent event;
+
+   if(dec->trace == NULL || !(dec->traceMask & DmtxTraceLine))
+      return;
+
+   memset(&event, 0x00, sizeof(DmtxTraceEvent));
+   event.type = DmtxTraceLine;
+   event.loc = line->locBeg;
+   event.line = line;
+
+   (*dec->trace)(&event, dec->traceUserData);
+}
+
+/**
+ * \brief  Trace region being fitted
+ * \param  dec
+ * \param  type DmtxTraceRegion | DmtxTraceSize
+ * \param  reg
+ * \return void
+ */
+static void
+TraceRegion(DmtxDecode *dec, int type, const DmtxRegion *reg)
+{
+   DmtxTraceEvent event;
+
+   if(dec->trace == NULL || !(dec->traceMask & type))
+      return;
+
+   memset(&event, 0x00, sizeof(DmtxTraceEvent));
+   event.type = type;
+   event.reg = reg;
+
+   (*dec->trace)(&event, dec->traceUserData);
+}
+
 /**
  * \brief  Returns xxx
  * \param  img
@@ -258,6 +524,7 @@ CacheFillQuad(DmtxDecode *dec, DmtxPixelLoc p0, DmtxPixelLoc p1, DmtxPixelLoc p2
    unsigned char *cache;
    int *scanlineMin, *scanlineMax;
    int minY, maxY, sizeY, posY, posX;
+   DmtxArena *arena;
    int i, idx;
 
    lines[0] = BresLineInit(p0, p1, pEmpty);
@@ -275,14 +542,21 @@ CacheFillQuad(DmtxDecode *dec, DmtxPixelLoc p0, DmtxPixelLoc p1, DmtxPixelLoc p2
 
    sizeY = maxY - minY + 1;
 
-   scanlineMin = (int *)malloc(sizeY * sizeof(int));
-   scanlineMax = (int *)calloc(sizeY, sizeof(int));
+   /* Both scanline arrays share one block */
+   arena = &(dec->arena);
+   scanlineMin = (int *)ArenaAlloc(arena, 2 * sizeY * sizeof(int));
+   if(scanlineMin == NULL) {
+      arena = NULL;
+      scanlineMin = (int *)AllocMalloc(&(dec->allocator), 2 * sizeY * sizeof(int));
+   }
 
    assert(scanlineMin); /* XXX handle this better */
-   assert(scanlineMax); /* XXX handle this better */
+   scanlineMax = scanlineMin + sizeY;
 
-   for(i = 0; i < sizeY; i++)
+   for(i = 0; i < sizeY; i++) {
       scanlineMin[i] = dec->xMax;
+      scanlineMax[i] = 0;
+   }
 
    for(i = 0; i < 4; i++) {
       while(lines[i].loc.X != lines[i].loc1.X || lines[i].loc.Y != lines[i].loc1.Y) {
@@ -302,8 +576,10 @@ CacheFillQuad(DmtxDecode *dec, DmtxPixelLoc p0, DmtxPixelLoc p1, DmtxPixelLoc p2
       }
    }
 
-   free(scanlineMin);
-   free(scanlineMax);
+   if(arena != NULL)
+      ArenaFree(arena, scanlineMin, 2 * sizeY * sizeof(int));
+   else
+      AllocFree(&(dec->allocator), scanlineMin);
 }
 
 /**
@@ -317,29 +593,141 @@ DmtxMessage *
 dmtxDecodeMatrixRegion(DmtxDecode *dec, DmtxRegion *reg, int fix)
 {
    DmtxMessage *msg;
-   DmtxVector2 topLeft, topRight, bottomLeft, bottomRight;
-   DmtxPixelLoc pxTopLeft, pxTopRight, pxBottomLeft, pxBottomRight;
 
-   msg = dmtxMessageCreate(reg->sizeIdx, DmtxFormatMatrix);
+   msg = MessageCreate(reg->sizeIdx, DmtxFormatMatrix, &(dec->arena), &(dec->allocator));
    if(msg == NULL)
       return NULL;
 
-   if(PopulateArrayFromMatrix(dec, reg, msg) != DmtxPass) {
+   /* Output is sized for the longest possible message, so this never fails */
+   if(DecodeMatrixRegionMessage(dec, reg, fix, msg, NULL) == DmtxFail ||
+         (size_t)msg->outputIdx >= msg->outputSize) {
       dmtxMessageDestroy(&msg);
       return NULL;
    }
 
+   return msg;
+}
+
+/**
+ * \brief  Convert fitted Data Matrix region into decoded bytes stored in caller's buffer
+ *
+ * Decodes without any heap allocation: the module and codeword arrays live
+ * on the stack and decoded bytes go straight to output. outputLength always
+ * receives the exact number of bytes the message needs, so a message that
+ * doesn't fit can be retried with a buffer of that size. A terminating zero
+ * byte is added when there is room for it, but isn't counted in outputLength.
+ *
+ * \param  dec
+ * \param  reg
+ * \param  fix
+ * \param  output Destination for decoded bytes
+ * \param  outputSize Size of destination in bytes
+ * \param  outputLength Receives length of decoded message
+ * \return DmtxPass | DmtxFail (including message longer than outputSize)
+ */
+DmtxPassFail
+dmtxDecodeMatrixRegionBuffer(DmtxDecode *dec, DmtxRegion *reg, int fix,
+      unsigned char *output, int outputSize, int *outputLength)
+{
+   return dmtxDecodeMatrixRegionSegments(dec, reg, fix, output, outputSize,
+         outputLength, NULL, NULL);
+}
+
+/**
+ * \brief  Convert fitted Data Matrix region into decoded bytes, reporting
+ *         each segment of the message as it is decoded
+ *
+ * Works like dmtxDecodeMatrixRegionBuffer(), and additionally passes each
+ * segment to callback in message order. Segments point into output rather
+ * than holding copies, so together the data segments (plus any GS bytes of
+ * FNC1 segments and the macro header and trailer) tile output exactly. A
+ * data segment covers a run of bytes decoded under one encodation scheme.
+ * Event segments mark a macro header or trailer, an FNC1 (length 0 when it
+ * leads the message as a GS1 indicator, otherwise the GS byte it produced),
+ * or an ECI designator (length 0, eci holding the new value). Segments stop
+ * if the callback fails or output fills up, and the call then fails.
+ *
+ * \param  dec
+ * \param  reg
+ * \param  fix
+ * \param  output Destination for decoded bytes
+ * \param  outputSize Size of destination in bytes
+ * \param  outputLength Receives length of decoded message
+ * \param  callback Receives segments, or NULL
+ * \param  userData Passed to callback
+ * \return DmtxPass | DmtxFail
+ */
+DmtxPassFail
+dmtxDecodeMatrixRegionSegments(DmtxDecode *dec, DmtxRegion *reg, int fix,
+      unsigned char *output, int outputSize, int *outputLength,
+      DmtxSegmentCallback callback, void *userData)
+{
+   DmtxMessage msg;
+   DmtxSegmentSink sink;
+   unsigned char arrayStorage[DmtxMaxMappingArea];
+   unsigned char codeStorage[DmtxMaxCodeWords];
+
+   if(output == NULL || outputSize < 0 || outputLength == NULL)
+      return DmtxFail;
+
+   *outputLength = 0;
+
+   if(MessageInit(&msg, reg->sizeIdx, arrayStorage, codeStorage) == DmtxFail)
+      return DmtxFail;
+
+   msg.output = output;
+   msg.outputSize = outputSize;
+
+   sink.callback = callback;
+   sink.userData = userData;
+
+   if(DecodeMatrixRegionMessage(dec, reg, fix, &msg,
+         (callback != NULL) ? &sink : NULL) == DmtxFail)
+      return DmtxFail;
+
+   *outputLength = msg.outputIdx;
+
+   if(callback != NULL && sink.passFail == DmtxFail)
+      return DmtxFail;
+
+   return (msg.outputIdx <= outputSize) ? DmtxPass : DmtxFail;
+}
+
+/**
+ * \brief  Sample region into message and decode it into message output
+ * \param  dec
+ * \param  reg
+ * \param  fix
+ * \param  msg Message sized for region with zeroed arrays
+ * \param  sink Segment receiver, or NULL
+ * \return DmtxPass | DmtxFail
+ */
+static DmtxPassFail
+DecodeMatrixRegionMessage(DmtxDecode *dec, DmtxRegion *reg, int fix, DmtxMessage *msg,
+      DmtxSegmentSink *sink)
+{
+   DmtxTime start;
+   DmtxPassFail passFail;
+   DmtxVector2 topLeft, topRight, bottomLeft, bottomRight;
+   DmtxPixelLoc pxTopLeft, pxTopRight, pxBottomLeft, pxBottomRight;
+
+   start = StatsStart(dec);
+   passFail = PopulateArrayFromMatrix(dec, reg, msg);
+
    /* maybe place remaining logic into new dmtxDecodePopulatedArray()
       function so other people can pass in their own arrays */
 
-   ModulePlacementEcc200(msg->array, msg->code,
-         reg->sizeIdx, DmtxModuleOnRed | DmtxModuleOnGreen | DmtxModuleOnBlue);
+   if(passFail == DmtxPass)
+      ModulePlacementEcc200(msg->array, msg->code,
+            reg->sizeIdx, DmtxModuleOnRed | DmtxModuleOnGreen | DmtxModuleOnBlue);
 
-   if(RsDecode(msg->code, reg->sizeIdx, fix) == DmtxFail)
-   {
-      dmtxMessageDestroy(&msg);
-      return NULL;
-   }
+   if(StatsStop(dec, DmtxStageReadModules, start, passFail) == DmtxFail)
+      return DmtxFail;
+
+   start = StatsStart(dec);
+   passFail = RsDecode(msg->code, reg->sizeIdx, fix);
+   if(StatsStop(dec, DmtxStageRsDecode, start, passFail) == DmtxFail)
+      return DmtxFail;
 
    topLeft.X = bottomLeft.X = topLeft.Y = topRight.Y = -0.1;
    topRight.X = bottomRight.X = bottomLeft.Y = bottomRight.Y = 1.1;
@@ -360,9 +748,11 @@ dmtxDecodeMatrixRegion(DmtxDecode *dec, DmtxRegion *reg, int fix)
 
    CacheFillQuad(dec, pxTopLeft, pxTopRight, pxBottomRight, pxBottomLeft);
 
-   DecodeDataStream(msg, reg->sizeIdx, NULL);
+   start = StatsStart(dec);
+   DecodeDataStream(msg, reg->sizeIdx, NULL, sink);
+   StatsStop(dec, DmtxStageDecodeData, start, DmtxPass);
 
-   return msg;
+   return DmtxPass;
 }
 
 /**
@@ -394,6 +784,10 @@ dmtxDecodeMosaicRegion(DmtxDecode *dec, DmtxRegion *reg, int fix)
     * identify value. An additional method will be required to get actual
     * RGB instead of just a plane in 3D. */
 
+   /* Create output first and release planes in reverse, so arena gets all
+      plane messages back */
+   oMsg = MessageCreate(reg->sizeIdx, DmtxFormatMosaic, &(dec->arena), &(dec->allocator));
+
    reg->flowBegin.plane = 0; /* kind of a hack */
    rMsg = dmtxDecodeMatrixRegion(dec, reg, fix);
 
@@ -405,13 +799,11 @@ dmtxDecodeMosaicRegion(DmtxDecode *dec, DmtxRegion *reg, int fix)
 
    reg->flowBegin.plane = colorPlane;
 
-   oMsg = dmtxMessageCreate(reg->sizeIdx, DmtxFormatMosaic);
-
    if(oMsg == NULL || rMsg == NULL || gMsg == NULL || bMsg == NULL) {
-      dmtxMessageDestroy(&oMsg);
-      dmtxMessageDestroy(&rMsg);
-      dmtxMessageDestroy(&gMsg);
       dmtxMessageDestroy(&bMsg);
+      dmtxMessageDestroy(&gMsg);
+      dmtxMessageDestroy(&rMsg);
+      dmtxMessageDestroy(&oMsg);
       return NULL;
    }
 
@@ -424,17 +816,22 @@ dmtxDecodeMosaicRegion(DmtxDecode *dec, DmtxRegion *reg, int fix)
    offset += bMsg->outputIdx;
 
    oMsg->outputIdx = offset;
+   oMsg->output[offset] = '\0';
 
-   dmtxMessageDestroy(&rMsg);
-   dmtxMessageDestroy(&gMsg);
    dmtxMessageDestroy(&bMsg);
+   dmtxMessageDestroy(&gMsg);
+   dmtxMessageDestroy(&rMsg);
 
    return oMsg;
 }
 
 /**
- *
- *
+ * \brief  Render decoder's view of the image as binary PPM
+ * \param  dec
+ * \param  totalBytes Receives size of returned buffer
+ * \param  headerBytes Receives size of PPM header
+ * \param  style Unused
+ * \return PPM data allocated with the decoder's allocator, or NULL
  */
 unsigned char *
 dmtxDecodeCreateDiagnostic(DmtxDecode *dec, int *totalBytes, int *headerBytes, int style)
@@ -464,7 +861,7 @@ dmtxDecodeCreateDiagnostic(DmtxDecode *dec, int *totalBytes, int *headerBytes, i
    *headerBytes = widthDigits + heightDigits + 9;
    *totalBytes = *headerBytes + width * height * 3;
 
-   pnm = (unsigned char *)malloc(*totalBytes);
+   pnm = (unsigned char *)AllocMalloc(&(dec->allocator), *totalBytes);
    if(pnm == NULL)
       return NULL;
 
@@ -475,7 +872,7 @@ dmtxDecodeCreateDiagnostic(DmtxDecode *dec, int *totalBytes, int *headerBytes, i
 #endif
 
    if(count != *headerBytes) {
-      free(pnm);
+      AllocFree(&(dec->allocator), pnm);
       return NULL;
    }
 
@@ -543,9 +940,12 @@ TallyModuleJumps(DmtxDecode *dec, DmtxRegion *reg, int tally[][24], int xOrigin,
    int color;
    int statusPrev, statusModule;
    int tPrev, tModule;
+   const DmtxSymbolInfo *info;
 
    assert(dir == DmtxDirUp || dir == DmtxDirLeft || dir == DmtxDirDown || dir == DmtxDirRight);
 
+   info = dmtxGetSymbolInfo(reg->sizeIdx);
+
    travelStep = (dir == DmtxDirUp || dir == DmtxDirRight) ? 1 : -1;
 
    /* Abstract row and column progress using pointers to allow grid
@@ -583,7 +983,7 @@ TallyModuleJumps(DmtxDecode *dec, DmtxRegion *reg, int tally[][24], int xOrigin,
          decide status based on predictable barcode border pattern */
 
       *travel = travelStart;
-      color = ReadModuleColor(dec, reg, symbolRow, symbolCol, reg->sizeIdx, reg->flowBegin.plane);
+      color = ReadModuleColor(dec, reg, symbolRow, symbolCol, info, reg->flowBegin.plane);
       tModule = (darkOnLight) ? reg->offColor - color : color - reg->offColor;
 
       statusModule = (travelStep == 1 || (*line & 0x01) == 0) ? DmtxModuleOnRGB : DmtxModuleOff;
@@ -598,7 +998,7 @@ TallyModuleJumps(DmtxDecode *dec, DmtxRegion *reg, int tally[][24], int xOrigin,
          /* For normal data-bearing modules capture color and decide
             module status based on comparison to previous "known" module */
 
-         color = ReadModuleColor(dec, reg, symbolRow, symbolCol, reg->sizeIdx, reg->flowBegin.plane);
+         color = ReadModuleColor(dec, reg, symbolRow, symbolCol, info, reg->flowBegin.plane);
          tModule = (darkOnLight) ? reg->offColor - color : color - reg->offColor;
 
          if(statusPrev == DmtxModuleOnRGB) {
@@ -646,16 +1046,19 @@ PopulateArrayFromMatrix(DmtxDecode *dec, DmtxRegion *reg, DmtxMessage *msg)
    int mapCol, mapRow;
    int colTmp, rowTmp, idx;
    int tally[24][24]; /* Large enough to map largest single region */
+   const DmtxSymbolInfo *info;
 
 /* memset(msg->array, 0x00, msg->arraySize); */
 
+   info = dmtxGetSymbolInfo(reg->sizeIdx);
+
    /* Capture number of regions present in barcode */
-   xRegionTotal = dmtxGetSymbolAttribute(DmtxSymAttribHorizDataRegions, reg->sizeIdx);
-   yRegionTotal = dmtxGetSymbolAttribute(DmtxSymAttribVertDataRegions, reg->sizeIdx);
+   xRegionTotal = info->horizDataRegions;
+   yRegionTotal = info->vertDataRegions;
 
    /* Capture region dimensions (not including border modules) */
-   mapWidth = dmtxGetSymbolAttribute(DmtxSymAttribDataRegionCols, reg->sizeIdx);
-   mapHeight = dmtxGetSymbolAttribute(DmtxSymAttribDataRegionRows, reg->sizeIdx);
+   mapWidth = info->dataRegionCols;
+   mapHeight = info->dataRegionRows;
 
    weightFactor = 2 * (mapHeight + mapWidth + 2);
    assert(weightFactor > 0);
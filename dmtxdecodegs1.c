@@ -0,0 +1,309 @@
+/**
+ * libdmtx - Data Matrix Encoding/Decoding Library
+ * Copyright 2011 Mike Laughton. All rights reserved.
+ *
+ * See LICENSE file in the main project directory for full
+ * terms of use and distribution.
+ *
+ * Contact: Mike Laughton <mike@dragonflylogic.com>
+ *
+ * \file dmtxdecodegs1.c
+ * \brief Splitting GS1 messages into Application Identifier fields
+ */
+
+#define DmtxGs1Separator          29 /* ASCII GS, produced by FNC1 */
+
+/**
+ * Two-digit AI prefixes, each determining the length of its AIs and of their
+ * data. Predefined length AIs have fixed dataLength; all others end at the
+ * next FNC1 or the end of the message.
+ */
+static const DmtxGs1Prefix gs1Prefix[] = {
+   /*   first last aiLen dataLen max  check */
+   {     0,   0,   2,   18,   18,  DmtxGs1CheckDigit   }, /* SSCC */
+   {     1,   2,   2,   14,   14,  DmtxGs1CheckDigit   }, /* GTIN, content */
+   {    10,  10,   2,    0,   20,  DmtxGs1CheckNone    }, /* Batch or lot */
+   {    11,  13,   2,    6,    6,  DmtxGs1CheckDate    },
+   {    15,  17,   2,    6,    6,  DmtxGs1CheckDate    }, /* Best before, expiry */
+   {    20,  20,   2,    2,    2,  DmtxGs1CheckNumeric }, /* Variant */
+   {    21,  22,   2,    0,   20,  DmtxGs1CheckNone    }, /* Serial number */
+   {    23,  23,   3,    0,   28,  DmtxGs1CheckNone    },
+   {    24,  25,   3,    0,   30,  DmtxGs1CheckNone    },
+   {    30,  30,   2,    0,    8,  DmtxGs1CheckNone    }, /* Count */
+   {    31,  36,   4,    6,    6,  DmtxGs1CheckNumeric }, /* Measures */
+   {    37,  37,   2,    0,    8,  DmtxGs1CheckNone    },
+   {    39,  39,   4,    0,   18,  DmtxGs1CheckNone    }, /* Amounts */
+   {    40,  40,   3,    0,   30,  DmtxGs1CheckNone    },
+   {    41,  41,   3,   13,   13,  DmtxGs1CheckDigit   }, /* GLN */
+   {    42,  42,   3,    0,   30,  DmtxGs1CheckNone    },
+   {    43,  43,   4,    0,   70,  DmtxGs1CheckNone    },
+   {    70,  70,   4,    0,   30,  DmtxGs1CheckNone    },
+   {    71,  71,   3,    0,   20,  DmtxGs1CheckNone    },
+   {    72,  72,   4,    0,   30,  DmtxGs1CheckNone    },
+   {    80,  80,   4,    0,   50,  DmtxGs1CheckNone    },
+   {    81,  82,   4,    0,   70,  DmtxGs1CheckNone    },
+   {    90,  99,   2,    0,   90,  DmtxGs1CheckNone    }  /* Internal */
+};
+
+/**
+ * \brief  Convert fitted Data Matrix region into decoded bytes and split its
+ *         GS1 element string into Application Identifier fields
+ *
+ * Fields are collected while the message is decoded, from the segments
+ * reported by dmtxDecodeMatrixRegionSegments(), so the message isn't scanned
+ * a second time. Each field points at its value within output. Predefined
+ * length fields must have exactly their length in digits, and SSCC, GTIN,
+ * and GLN check digits and YYMMDD dates are verified. Values of other
+ * fields are only checked against their maximum length.
+ *
+ * \param  dec
+ * \param  reg
+ * \param  fix
+ * \param  output Destination for decoded bytes
+ * \param  outputSize Size of destination in bytes
+ * \param  outputLength Receives length of decoded message
+ * \param  field Receives fields in message order
+ * \param  fieldSize Number of entries available in field
+ * \param  fieldCount Receives number of fields found
+ * \return DmtxPass | DmtxFail (including message not marked as GS1 with a
+ *         leading FNC1, malformed or invalid field, or too many fields)
+ */
+DmtxPassFail
+dmtxDecodeMatrixRegionGs1(DmtxDecode *dec, DmtxRegion *reg, int fix,
+      unsigned char *output, int outputSize, int *outputLength,
+      DmtxGs1Field *field, int fieldSize, int *fieldCount)
+{
+   DmtxGs1Parser parser;
+
+   if(field == NULL || fieldSize < 1 || fieldCount == NULL)
+      return DmtxFail;
+
+   *fieldCount = 0;
+
+   memset(&parser, 0x00, sizeof(DmtxGs1Parser));
+   parser.field = field;
+   parser.fieldSize = fieldSize;
+   parser.started = DmtxFalse;
+
+   if(dmtxDecodeMatrixRegionSegments(dec, reg, fix, output, outputSize,
+         outputLength, Gs1Segment, &parser) == DmtxFail)
+      return DmtxFail;
+
+   if(Gs1Finish(&parser) == DmtxFail)
+      return DmtxFail;
+
+   *fieldCount = parser.fieldCount;
+
+   return DmtxPass;
+}
+
+/**
+ * \brief  Segment callback feeding decoded bytes to GS1 parser
+ * \param  segment
+ * \param  userData Parser
+ * \return DmtxPass | DmtxFail (stops decoding)
+ */
+static DmtxPassFail
+Gs1Segment(const DmtxDecodeSegment *segment, void *userData)
+{
+   int i;
+   DmtxGs1Parser *parser;
+
+   parser = (DmtxGs1Parser *)userData;
+
+   /* GS1 data must open with FNC1, which produces no output */
+   if(parser->started == DmtxFalse) {
+      if(segment->type != DmtxSegmentFnc1 || segment->length != 0)
+         return DmtxFail;
+
+      parser->started = DmtxTrue;
+      return DmtxPass;
+   }
+
+   if(segment->type == DmtxSegmentMacroHeader || segment->type == DmtxSegmentMacroTrailer)
+      return DmtxFail;
+
+   /* Later FNC1 segments hold the GS that separates fields */
+   for(i = 0; i < segment->length; i++) {
+      if(Gs1PushByte(parser, segment->data + i, segment->offset + i) == DmtxFail)
+         return DmtxFail;
+   }
+
+   return DmtxPass;
+}
+
+/**
+ * \brief  Advance parser by one decoded byte
+ * \param  parser
+ * \param  ptr Byte within output
+ * \param  offset Position of byte within output
+ * \return DmtxPass | DmtxFail
+ */
+static DmtxPassFail
+Gs1PushByte(DmtxGs1Parser *parser, const unsigned char *ptr, int offset)
+{
+   DmtxGs1Field *field;
+
+   /* Separator ends a variable length field, and is harmless between fields */
+   if(*ptr == DmtxGs1Separator) {
+      if(parser->aiDigits == 0)
+         return DmtxPass;
+
+      return Gs1FieldEnd(parser);
+   }
+
+   if(parser->aiDigits == 0) {
+      if(parser->fieldCount >= parser->fieldSize)
+         return DmtxFail;
+
+      field = &(parser->field[parser->fieldCount]);
+      field->ai = 0;
+      field->aiLength = 0;
+      field->data = NULL;
+      field->offset = field->length = 0;
+      parser->prefix = NULL;
+   }
+
+   field = &(parser->field[parser->fieldCount]);
+
+   /* Collect AI digits until the prefix tells how many there are */
+   if(parser->prefix == NULL || parser->aiDigits < parser->prefix->aiLength) {
+      if(*ptr < '0' || *ptr > '9')
+         return DmtxFail;
+
+      field->ai = field->ai * 10 + (*ptr - '0');
+      parser->aiDigits++;
+
+      if(parser->aiDigits == 2) {
+         parser->prefix = Gs1FindPrefix(field->ai);
+         if(parser->prefix == NULL)
+            return DmtxFail;
+      }
+
+      if(parser->prefix != NULL && parser->aiDigits == parser->prefix->aiLength) {
+         field->aiLength = parser->aiDigits;
+         field->data = ptr + 1;
+         field->offset = offset + 1;
+      }
+
+      return DmtxPass;
+   }
+
+   field->length++;
+
+   if(field->length == parser->prefix->dataLength)
+      return Gs1FieldEnd(parser);
+
+   return (field->length <= parser->prefix->dataMax) ? DmtxPass : DmtxFail;
+}
+
+/**
+ * \brief  Validate field being collected and start the next one
+ * \param  parser
+ * \return DmtxPass | DmtxFail
+ */
+static DmtxPassFail
+Gs1FieldEnd(DmtxGs1Parser *parser)
+{
+   int i;
+   const DmtxGs1Prefix *prefix;
+   DmtxGs1Field *field;
+
+   prefix = parser->prefix;
+   field = &(parser->field[parser->fieldCount]);
+
+   if(prefix == NULL || parser->aiDigits < prefix->aiLength || field->length < 1)
+      return DmtxFail;
+
+   if(prefix->dataLength > 0 && field->length != prefix->dataLength)
+      return DmtxFail;
+
+   if(prefix->check != DmtxGs1CheckNone) {
+      for(i = 0; i < field->length; i++) {
+         if(field->data[i] < '0' || field->data[i] > '9')
+            return DmtxFail;
+      }
+   }
+
+   if(prefix->check == DmtxGs1CheckDigit && Gs1CheckDigit(field->data, field->length) == DmtxFail)
+      return DmtxFail;
+
+   if(prefix->check == DmtxGs1CheckDate && Gs1CheckDate(field->data) == DmtxFail)
+      return DmtxFail;
+
+   parser->fieldCount++;
+   parser->aiDigits = 0;
+   parser->prefix = NULL;
+
+   return DmtxPass;
+}
+
+/**
+ * \brief  Check end of message
+ * \param  parser
+ * \return DmtxPass | DmtxFail (not GS1, no fields, or last field incomplete)
+ */
+static DmtxPassFail
+Gs1Finish(DmtxGs1Parser *parser)
+{
+   if(parser->started == DmtxFalse)
+      return DmtxFail;
+
+   if(parser->aiDigits > 0 && Gs1FieldEnd(parser) == DmtxFail)
+      return DmtxFail;
+
+   return (parser->fieldCount > 0) ? DmtxPass : DmtxFail;
+}
+
+/**
+ * \brief  Look up two-digit AI prefix
+ * \param  prefix 0-99
+ * \return Prefix entry, or NULL if no AIs start with prefix
+ */
+static const DmtxGs1Prefix *
+Gs1FindPrefix(int prefix)
+{
+   int i;
+
+   for(i = 0; i < (int)(sizeof(gs1Prefix)/sizeof(gs1Prefix[0])); i++) {
+      if(prefix >= gs1Prefix[i].first && prefix <= gs1Prefix[i].last)
+         return &(gs1Prefix[i]);
+   }
+
+   return NULL;
+}
+
+/**
+ * \brief  Verify GS1 mod 10 check digit in last position
+ * \param  data Digits
+ * \param  length
+ * \return DmtxPass | DmtxFail
+ */
+static DmtxPassFail
+Gs1CheckDigit(const unsigned char *data, int length)
+{
+   int i, sum;
+
+   /* Weights alternate 3, 1, 3, ... leftward from the check digit */
+   sum = 0;
+   for(i = length - 2; i >= 0; i--)
+      sum += (data[i] - '0') * (((length - 2 - i) & 0x01) ? 1 : 3);
+
+   return ((10 - sum % 10) % 10 == data[length - 1] - '0') ? DmtxPass : DmtxFail;
+}
+
+/**
+ * \brief  Verify YYMMDD date (day 00 stands for end of month)
+ * \param  data Six digits
+ * \return DmtxPass | DmtxFail
+ */
+static DmtxPassFail
+Gs1CheckDate(const unsigned char *data)
+{
+   int month, day;
+
+   month = (data[2] - '0') * 10 + (data[3] - '0');
+   day = (data[4] - '0') * 10 + (data[5] - '0');
+
+   return (month >= 1 && month <= 12 && day <= 31) ? DmtxPass : DmtxFail;
+}
@@ -10,16 +10,101 @@
  * \file dmtxdecodescheme.c
  */
 
+/**
+ * C40 and Text values by character set, as output byte or (above 255) the
+ * action to take. Values not defined by a set are ignored.
+ */
+static const unsigned short c40TextDecode[2][4][40] = {
+   {  /* C40 */
+      {  /* Basic set */
+         DmtxCTXDecodeShift1, DmtxCTXDecodeShift2, DmtxCTXDecodeShift3,
+          32,  48,  49,  50,  51,  52,  53,  54,  55,  56,  57,
+          65,  66,  67,  68,  69,  70,  71,  72,  73,  74,  75,  76,  77,
+          78,  79,  80,  81,  82,  83,  84,  85,  86,  87,  88,  89,  90 },
+      {  /* Shift 1 */
+           0,   1,   2,   3,   4,   5,   6,   7,   8,   9,
+          10,  11,  12,  13,  14,  15,  16,  17,  18,  19,
+          20,  21,  22,  23,  24,  25,  26,  27,  28,  29,
+          30,  31,  32,  33,  34,  35,  36,  37,  38,  39 },
+      {  /* Shift 2 */
+          33,  34,  35,  36,  37,  38,  39,  40,  41,  42,
+          43,  44,  45,  46,  47,  58,  59,  60,  61,  62,
+          63,  64,  91,  92,  93,  94,  95,
+         DmtxCTXDecodeFnc1, DmtxCTXDecodeNone, DmtxCTXDecodeNone, DmtxCTXDecodeUpperShift,
+         DmtxCTXDecodeNone, DmtxCTXDecodeNone, DmtxCTXDecodeNone, DmtxCTXDecodeNone,
+         DmtxCTXDecodeNone, DmtxCTXDecodeNone, DmtxCTXDecodeNone, DmtxCTXDecodeNone,
+         DmtxCTXDecodeNone },
+      {  /* Shift 3 */
+          96,  97,  98,  99, 100, 101, 102, 103, 104, 105,
+         106, 107, 108, 109, 110, 111, 112, 113, 114, 115,
+         116, 117, 118, 119, 120, 121, 122, 123, 124, 125,
+         126, 127, 128, 129, 130, 131, 132, 133, 134, 135 }
+   },
+   {  /* Text */
+      {  /* Basic set */
+         DmtxCTXDecodeShift1, DmtxCTXDecodeShift2, DmtxCTXDecodeShift3,
+          32,  48,  49,  50,  51,  52,  53,  54,  55,  56,  57,
+          97,  98,  99, 100, 101, 102, 103, 104, 105, 106, 107, 108, 109,
+         110, 111, 112, 113, 114, 115, 116, 117, 118, 119, 120, 121, 122 },
+      {  /* Shift 1 */
+           0,   1,   2,   3,   4,   5,   6,   7,   8,   9,
+          10,  11,  12,  13,  14,  15,  16,  17,  18,  19,
+          20,  21,  22,  23,  24,  25,  26,  27,  28,  29,
+          30,  31,  32,  33,  34,  35,  36,  37,  38,  39 },
+      {  /* Shift 2 */
+          33,  34,  35,  36,  37,  38,  39,  40,  41,  42,
+          43,  44,  45,  46,  47,  58,  59,  60,  61,  62,
+          63,  64,  91,  92,  93,  94,  95,
+         DmtxCTXDecodeFnc1, DmtxCTXDecodeNone, DmtxCTXDecodeNone, DmtxCTXDecodeUpperShift,
+         DmtxCTXDecodeNone, DmtxCTXDecodeNone, DmtxCTXDecodeNone, DmtxCTXDecodeNone,
+         DmtxCTXDecodeNone, DmtxCTXDecodeNone, DmtxCTXDecodeNone, DmtxCTXDecodeNone,
+         DmtxCTXDecodeNone },
+      {  /* Shift 3 */
+          96,  65,  66,  67,  68,  69,  70,  71,  72,  73,
+          74,  75,  76,  77,  78,  79,  80,  81,  82,  83,
+          84,  85,  86,  87,  88,  89,  90, 123, 124, 125,
+         126, 127, 128, 129, 130, 131, 132, 133, 134, 135 }
+   }
+};
+
+/**
+ * X12 values as output bytes
+ */
+static const unsigned char x12Decode[40] = {
+    13,  42,  62,  32,  48,  49,  50,  51,  52,  53,
+    54,  55,  56,  57,  65,  66,  67,  68,  69,  70,
+    71,  72,  73,  74,  75,  76,  77,  78,  79,  80,
+    81,  82,  83,  84,  85,  86,  87,  88,  89,  90
+};
+
+/**
+ * EDIFACT 6-bit values as output bytes (ASCII 64-94 followed by 32-63)
+ */
+static const unsigned char edifactDecode[64] = {
+    64,  65,  66,  67,  68,  69,  70,  71,  72,  73,  74,  75,  76,  77,  78,  79,
+    80,  81,  82,  83,  84,  85,  86,  87,  88,  89,  90,  91,  92,  93,  94,  95,
+    32,  33,  34,  35,  36,  37,  38,  39,  40,  41,  42,  43,  44,  45,  46,  47,
+    48,  49,  50,  51,  52,  53,  54,  55,  56,  57,  58,  59,  60,  61,  62,  63
+};
+
 /**
  * \brief  Translate encoded data stream into final output
+ *
+ * When sink is provided, output is also reported as it is produced: a data
+ * segment for each stretch decoded under one scheme, and event segments for
+ * macro header and trailer, FNC1, and ECI codewords.
+ *
  * \param  msg
  * \param  sizeIdx
  * \param  outputStart
+ * \param  sink Segment receiver, or NULL
  * \return void
  */
 static void
-DecodeDataStream(DmtxMessage *msg, int sizeIdx, unsigned char *outputStart)
+DecodeDataStream(DmtxMessage *msg, int sizeIdx, unsigned char *outputStart,
+      DmtxSegmentSink *sink)
 {
+   int start;
    DmtxBoolean macro = DmtxFalse;
    DmtxScheme encScheme;
    unsigned char *ptr, *dataEnd;
@@ -28,12 +113,24 @@ DecodeDataStream(DmtxMessage *msg, int sizeIdx, unsigned char *outputStart)
    msg->outputIdx = 0;
 
    ptr = msg->code;
-   dataEnd = ptr + dmtxGetSymbolAttribute(DmtxSymAttribSymbolDataWords, sizeIdx);
+   dataEnd = ptr + dmtxGetSymbolInfo(sizeIdx)->symbolDataWords;
+
+   if(sink != NULL) {
+      sink->scheme = DmtxSchemeAscii;
+      sink->dataStart = 0;
+      sink->eci = DmtxUndefined;
+      sink->macro = DmtxUndefined;
+      sink->passFail = DmtxPass;
+   }
 
    /* Print macro header if first codeword triggers it */
    if(*ptr == DmtxValue05Macro || *ptr == DmtxValue06Macro) {
       PushOutputMacroHeader(msg, *ptr);
       macro = DmtxTrue;
+      if(sink != NULL) {
+         sink->macro = (*ptr == DmtxValue05Macro) ? 5 : 6;
+         SegmentDeliver(msg, sink, DmtxSegmentMacroHeader, 0);
+      }
    }
 
    while(ptr < dataEnd) {
@@ -42,13 +139,18 @@ DecodeDataStream(DmtxMessage *msg, int sizeIdx, unsigned char *outputStart)
       if(encScheme != DmtxSchemeAscii)
          ptr++;
 
+      if(sink != NULL && encScheme != sink->scheme) {
+         SegmentFlush(msg, sink);
+         sink->scheme = encScheme;
+      }
+
       switch(encScheme) {
          case DmtxSchemeAscii:
-            ptr = DecodeSchemeAscii(msg, ptr, dataEnd);
+            ptr = DecodeSchemeAscii(msg, ptr, dataEnd, sink);
             break;
          case DmtxSchemeC40:
          case DmtxSchemeText:
-            ptr = DecodeSchemeC40Text(msg, ptr, dataEnd, encScheme);
+            ptr = DecodeSchemeC40Text(msg, ptr, dataEnd, encScheme, sink);
             break;
          case DmtxSchemeX12:
             ptr = DecodeSchemeX12(msg, ptr, dataEnd);
@@ -65,9 +167,18 @@ DecodeDataStream(DmtxMessage *msg, int sizeIdx, unsigned char *outputStart)
       }
    }
 
+   SegmentFlush(msg, sink);
+
    /* Print macro trailer if required */
-   if(macro == DmtxTrue)
+   if(macro == DmtxTrue) {
+      start = msg->outputIdx;
       PushOutputMacroTrailer(msg);
+      SegmentDeliver(msg, sink, DmtxSegmentMacroTrailer, start);
+   }
+
+   /* Terminate if there is room, so output can be treated as a string */
+   if((size_t)msg->outputIdx < msg->outputSize)
+      msg->output[msg->outputIdx] = '\0';
 }
 
 /**
@@ -106,37 +217,24 @@ GetEncodationScheme(unsigned char cw)
 }
 
 /**
+ * \brief  Append decoded byte to message output
  *
+ * Bytes beyond outputSize are counted but not stored, so outputIdx ends up
+ * holding the exact length needed even when the buffer is too small.
  *
+ * \param  msg
+ * \param  value
+ * \return void
  */
 static void
 PushOutputWord(DmtxMessage *msg, int value)
 {
    assert(value >= 0 && value < 256);
 
-   msg->output[msg->outputIdx++] = (unsigned char)value;
-}
-
-/**
- *
- *
- */
-static void
-PushOutputC40TextWord(DmtxMessage *msg, C40TextState *state, int value)
-{
-   assert(value >= 0 && value < 256);
-
-   msg->output[msg->outputIdx] = (unsigned char)value;
-
-   if(state->upperShift == DmtxTrue) {
-      assert(value < 128);
-      msg->output[msg->outputIdx] += 128;
-   }
+   if((size_t)msg->outputIdx < msg->outputSize)
+      msg->output[msg->outputIdx] = (unsigned char)value;
 
    msg->outputIdx++;
-
-   state->shift = DmtxC40TextBasicSet;
-   state->upperShift = DmtxFalse;
 }
 
 /**
@@ -172,15 +270,143 @@ PushOutputMacroTrailer(DmtxMessage *msg)
    PushOutputWord(msg, 4);  /* ASCII EOT */
 }
 
+/**
+ * \brief  Output FNC1 codeword
+ *
+ * A leading FNC1 only flags the message as GS1 data and produces no output.
+ * Any later FNC1 separates variable length fields and is output as ASCII GS.
+ *
+ * \param  msg
+ * \param  sink Segment receiver, or NULL
+ * \return void
+ */
+static void
+PushOutputFnc1(DmtxMessage *msg, DmtxSegmentSink *sink)
+{
+   int start;
+
+   SegmentFlush(msg, sink);
+
+   start = msg->outputIdx;
+   if(start > 0)
+      PushOutputWord(msg, 29); /* ASCII GS */
+
+   SegmentDeliver(msg, sink, DmtxSegmentFnc1, start);
+}
+
+/**
+ * \brief  Report data collected since the previous segment, if any
+ * \param  msg
+ * \param  sink Segment receiver, or NULL
+ * \return void
+ */
+static void
+SegmentFlush(DmtxMessage *msg, DmtxSegmentSink *sink)
+{
+   if(sink != NULL && msg->outputIdx > sink->dataStart)
+      SegmentDeliver(msg, sink, DmtxSegmentData, sink->dataStart);
+}
+
+/**
+ * \brief  Report segment covering output from start to current position
+ *
+ * Delivery stops for good once the callback fails or a segment runs past
+ * the end of the output buffer, since its bytes were never stored.
+ *
+ * \param  msg
+ * \param  sink Segment receiver, or NULL
+ * \param  type DmtxSegmentType
+ * \param  start Output position where segment begins
+ * \return void
+ */
+static void
+SegmentDeliver(DmtxMessage *msg, DmtxSegmentSink *sink, int type, int start)
+{
+   DmtxDecodeSegment segment;
+
+   if(sink == NULL)
+      return;
+
+   sink->dataStart = msg->outputIdx;
+
+   if(sink->passFail == DmtxFail)
+      return;
+
+   if((size_t)msg->outputIdx > msg->outputSize) {
+      sink->passFail = DmtxFail;
+      return;
+   }
+
+   segment.type = type;
+   segment.scheme = sink->scheme;
+   segment.data = msg->output + start;
+   segment.offset = start;
+   segment.length = msg->outputIdx - start;
+   segment.eci = sink->eci;
+   segment.macro = sink->macro;
+
+   if(sink->callback != NULL)
+      sink->passFail = (*sink->callback)(&segment, sink->userData);
+}
+
+/**
+ * \brief  Read ECI designator following ECI codeword
+ *
+ * The designator takes 1 to 3 codewords and produces no output. A truncated
+ * designator consumes the rest of the data stream.
+ *
+ * \param  msg
+ * \param  ptr First designator codeword
+ * \param  dataEnd
+ * \param  sink Segment receiver, or NULL
+ * \return Pointer to next undecoded codeword
+ */
+static unsigned char *
+DecodeEci(DmtxMessage *msg, unsigned char *ptr, unsigned char *dataEnd,
+      DmtxSegmentSink *sink)
+{
+   int eci;
+
+   if(ptr >= dataEnd)
+      return dataEnd;
+
+   if(*ptr <= 127) {
+      eci = *ptr - 1;
+      ptr += 1;
+   }
+   else if(*ptr <= 191) {
+      if(dataEnd - ptr < 2)
+         return dataEnd;
+      eci = (*ptr - 128) * 254 + *(ptr+1) + 126;
+      ptr += 2;
+   }
+   else {
+      if(dataEnd - ptr < 3)
+         return dataEnd;
+      eci = (*ptr - 192) * 64516 + (*(ptr+1) - 1) * 254 + *(ptr+2) - 1 + 16383;
+      ptr += 3;
+   }
+
+   if(sink != NULL) {
+      SegmentFlush(msg, sink);
+      sink->eci = eci;
+      SegmentDeliver(msg, sink, DmtxSegmentEci, msg->outputIdx);
+   }
+
+   return ptr;
+}
+
 /**
  * \brief  Decode stream assuming standard ASCII encodation
  * \param  msg
  * \param  ptr
  * \param  dataEnd
+ * \param  sink Segment receiver, or NULL
  * \return Pointer to next undecoded codeword
  */
 static unsigned char *
-DecodeSchemeAscii(DmtxMessage *msg, unsigned char *ptr, unsigned char *dataEnd)
+DecodeSchemeAscii(DmtxMessage *msg, unsigned char *ptr, unsigned char *dataEnd,
+      DmtxSegmentSink *sink)
 {
    int upperShift;
    int codeword, digits;
@@ -217,6 +443,12 @@ DecodeSchemeAscii(DmtxMessage *msg, unsigned char *ptr, unsigned char *dataEnd)
          PushOutputWord(msg, digits/10 + '0');
          PushOutputWord(msg, digits - (digits/10)*10 + '0');
       }
+      else if(codeword == DmtxValueFNC1) {
+         PushOutputFnc1(msg, sink);
+      }
+      else if(codeword == DmtxValueECI) {
+         ptr = DecodeEci(msg, ptr, dataEnd, sink);
+      }
    }
 
    return ptr;
@@ -228,97 +460,66 @@ DecodeSchemeAscii(DmtxMessage *msg, unsigned char *ptr, unsigned char *dataEnd)
  * \param  ptr
  * \param  dataEnd
  * \param  encScheme
+ * \param  sink Segment receiver, or NULL
  * \return Pointer to next undecoded codeword
  */
 static unsigned char *
-DecodeSchemeC40Text(DmtxMessage *msg, unsigned char *ptr, unsigned char *dataEnd, DmtxScheme encScheme)
+DecodeSchemeC40Text(DmtxMessage *msg, unsigned char *ptr, unsigned char *dataEnd,
+      DmtxScheme encScheme, DmtxSegmentSink *sink)
 {
    int i;
-   int packed;
+   int packed, shift, upperShift, entry;
    int c40Values[3];
-   C40TextState state;
-
-   state.shift = DmtxC40TextBasicSet;
-   state.upperShift = DmtxFalse;
+   const unsigned short (*table)[40];
 
    assert(encScheme == DmtxSchemeC40 || encScheme == DmtxSchemeText);
 
-   /* Unlatch is implied if only one codeword remains */
-   if(dataEnd - ptr < 2)
-      return ptr;
+   table = c40TextDecode[(encScheme == DmtxSchemeText) ? 1 : 0];
+   shift = DmtxC40TextBasicSet;
+   upperShift = 0;
 
-   while(ptr < dataEnd) {
+   /* Unlatch is implied if only one codeword remains */
+   while(dataEnd - ptr >= 2) {
 
-      /* FIXME Also check that ptr+1 is safe to access */
       packed = (*ptr << 8) | *(ptr+1);
+      ptr += 2;
+
+      /* Pairs above 64000 don't hold three values and are skipped */
+      if(packed < 1 || packed > 64000)
+         continue;
+
       c40Values[0] = ((packed - 1)/1600);
       c40Values[1] = ((packed - 1)/40) % 40;
       c40Values[2] =  (packed - 1) % 40;
-      ptr += 2;
 
       for(i = 0; i < 3; i++) {
-         if(state.shift == DmtxC40TextBasicSet) { /* Basic set */
-            if(c40Values[i] <= 2) {
-               state.shift = c40Values[i] + 1;
-            }
-            else if(c40Values[i] == 3) {
-               PushOutputC40TextWord(msg, &state, ' ');
-            }
-            else if(c40Values[i] <= 13) {
-               PushOutputC40TextWord(msg, &state, c40Values[i] - 13 + '9'); /* 0-9 */
-            }
-            else if(c40Values[i] <= 39) {
-               if(encScheme == DmtxSchemeC40) {
-                  PushOutputC40TextWord(msg, &state, c40Values[i] - 39 + 'Z'); /* A-Z */
-               }
-               else if(encScheme == DmtxSchemeText) {
-                  PushOutputC40TextWord(msg, &state, c40Values[i] - 39 + 'z'); /* a-z */
-               }
-            }
+         entry = table[shift][c40Values[i]];
+
+         if(entry < 256) {
+            if((size_t)msg->outputIdx < msg->outputSize)
+               msg->output[msg->outputIdx] = (unsigned char)(entry + upperShift);
+            msg->outputIdx++;
+            shift = DmtxC40TextBasicSet;
+            upperShift = 0;
          }
-         else if(state.shift == DmtxC40TextShift1) { /* Shift 1 set */
-            PushOutputC40TextWord(msg, &state, c40Values[i]); /* ASCII 0 - 31 */
+         else if(entry <= DmtxCTXDecodeShift3) {
+            shift = entry - DmtxCTXDecodeShift1 + DmtxC40TextShift1;
          }
-         else if(state.shift == DmtxC40TextShift2) { /* Shift 2 set */
-            if(c40Values[i] <= 14) {
-               PushOutputC40TextWord(msg, &state, c40Values[i] + 33); /* ASCII 33 - 47 */
-            }
-            else if(c40Values[i] <= 21) {
-               PushOutputC40TextWord(msg, &state, c40Values[i] + 43); /* ASCII 58 - 64 */
-            }
-            else if(c40Values[i] <= 26) {
-               PushOutputC40TextWord(msg, &state, c40Values[i] + 69); /* ASCII 91 - 95 */
-            }
-            else if(c40Values[i] == 27) {
-               PushOutputC40TextWord(msg, &state, 0x1d); /* FNC1 -- XXX depends on position? */
-            }
-            else if(c40Values[i] == 30) {
-               state.upperShift = DmtxTrue;
-               state.shift = DmtxC40TextBasicSet;
-            }
+         else if(entry == DmtxCTXDecodeUpperShift) {
+            shift = DmtxC40TextBasicSet;
+            upperShift = 128;
          }
-         else if(state.shift == DmtxC40TextShift3) { /* Shift 3 set */
-            if(encScheme == DmtxSchemeC40) {
-               PushOutputC40TextWord(msg, &state, c40Values[i] + 96);
-            }
-            else if(encScheme == DmtxSchemeText) {
-               if(c40Values[i] == 0)
-                  PushOutputC40TextWord(msg, &state, c40Values[i] + 96);
-               else if(c40Values[i] <= 26)
-                  PushOutputC40TextWord(msg, &state, c40Values[i] - 26 + 'Z'); /* A-Z */
-               else
-                  PushOutputC40TextWord(msg, &state, c40Values[i] - 31 + 127); /* { | } ~ DEL */
-            }
+         else {
+            if(entry == DmtxCTXDecodeFnc1)
+               PushOutputFnc1(msg, sink);
+            shift = DmtxC40TextBasicSet;
+            upperShift = 0;
          }
       }
 
       /* Unlatch if codeword 254 follows 2 codewords in C40/Text encodation */
-      if(*ptr == DmtxValueCTXUnlatch)
+      if(ptr < dataEnd && *ptr == DmtxValueCTXUnlatch)
          return ptr + 1;
-
-      /* Unlatch is implied if only one codeword remains */
-      if(dataEnd - ptr < 2)
-         return ptr;
    }
 
    return ptr;
@@ -339,40 +540,28 @@ DecodeSchemeX12(DmtxMessage *msg, unsigned char *ptr, unsigned char *dataEnd)
    int x12Values[3];
 
    /* Unlatch is implied if only one codeword remains */
-   if(dataEnd - ptr < 2)
-      return ptr;
-
-   while(ptr < dataEnd) {
+   while(dataEnd - ptr >= 2) {
 
-      /* FIXME Also check that ptr+1 is safe to access */
       packed = (*ptr << 8) | *(ptr+1);
+      ptr += 2;
+
+      /* Pairs above 64000 don't hold three values and are skipped */
+      if(packed < 1 || packed > 64000)
+         continue;
+
       x12Values[0] = ((packed - 1)/1600);
       x12Values[1] = ((packed - 1)/40) % 40;
       x12Values[2] =  (packed - 1) % 40;
-      ptr += 2;
 
       for(i = 0; i < 3; i++) {
-         if(x12Values[i] == 0)
-            PushOutputWord(msg, 13);
-         else if(x12Values[i] == 1)
-            PushOutputWord(msg, 42);
-         else if(x12Values[i] == 2)
-            PushOutputWord(msg, 62);
-         else if(x12Values[i] == 3)
-            PushOutputWord(msg, 32);
-         else if(x12Values[i] <= 13)
-            PushOutputWord(msg, x12Values[i] + 44);
-         else if(x12Values[i] <= 90)
-            PushOutputWord(msg, x12Values[i] + 51);
+         if((size_t)msg->outputIdx < msg->outputSize)
+            msg->output[msg->outputIdx] = x12Decode[x12Values[i]];
+         msg->outputIdx++;
       }
 
       /* Unlatch if codeword 254 follows 2 codewords in C40/Text encodation */
-      if(*ptr == DmtxValueCTXUnlatch)
+      if(ptr < dataEnd && *ptr == DmtxValueCTXUnlatch)
          return ptr + 1;
-
-      /* Unlatch is implied if only one codeword remains */
-      if(dataEnd - ptr < 2)
-         return ptr;
    }
 
    return ptr;
@@ -412,12 +601,12 @@ DecodeSchemeEdifact(DmtxMessage *msg, unsigned char *ptr, unsigned char *dataEnd
             ptr++;
 
          /* Test for unlatch condition */
-         if(unpacked[i] == DmtxValueEdifactUnlatch) {
-            assert(msg->output[msg->outputIdx] == 0); /* XXX dirty why? */
+         if(unpacked[i] == DmtxValueEdifactUnlatch)
             return ptr;
-         }
 
-         PushOutputWord(msg, unpacked[i] ^ (((unpacked[i] & 0x20) ^ 0x20) << 1));
+         if((size_t)msg->outputIdx < msg->outputSize)
+            msg->output[msg->outputIdx] = edifactDecode[unpacked[i]];
+         msg->outputIdx++;
       }
 
       /* Unlatch is implied if fewer than 3 codewords remain */
@@ -20,31 +20,29 @@
  */
 DmtxEncode *
 dmtxEncodeCreate(void)
+{
+   return dmtxEncodeCreateWithAllocator(NULL);
+}
+
+/**
+ * \brief  Initialize encode struct that allocates through its own allocator
+ * \param  allocator Used for the encoder and everything it allocates, or NULL
+ *         for the global allocator
+ * \return Initialized DmtxEncode struct
+ */
+DmtxEncode *
+dmtxEncodeCreateWithAllocator(const DmtxAllocator *allocator)
 {
    DmtxEncode *enc;
 
-   enc = (DmtxEncode *)calloc(1, sizeof(DmtxEncode));
+   allocator = AllocSelect(allocator);
+
+   enc = (DmtxEncode *)AllocCalloc(allocator, 1, sizeof(DmtxEncode));
    if(enc == NULL)
       return NULL;
 
-   enc->scheme = DmtxSchemeAscii;
-   enc->sizeIdxRequest = DmtxSymbolSquareAuto;
-   enc->marginSize = 10;
-   enc->moduleSize = 5;
-   enc->pixelPacking = DmtxPack24bppRGB;
-   enc->imageFlip = DmtxFlipNone;
-   enc->rowPadBytes = 0;
-
-   /* Initialize background color to white */
-/* enc.region.gradient.ray.p.R = 255.0;
-   enc.region.gradient.ray.p.G = 255.0;
-   enc.region.gradient.ray.p.B = 255.0; */
-
-   /* Initialize foreground color to black */
-/* enc.region.gradient.tMin = 0.0;
-   enc.region.gradient.tMax = xyz; */
-
-   dmtxMatrix3Identity(enc->xfrm);
+   enc->allocator = *allocator;
+   EncodeDefaults(enc);
 
    return enc;
 }
@@ -60,22 +58,39 @@ dmtxEncodeDestroy(DmtxEncode **enc)
    if(enc == NULL || *enc == NULL)
       return DmtxFail;
 
-   /* Free pixel array allocated in dmtxEncodeDataMatrix() */
-   if((*enc)->image != NULL && (*enc)->image->pxl != NULL) {
-      free((*enc)->image->pxl);
-      (*enc)->image->pxl = NULL;
-   }
-
-   dmtxImageDestroy(&((*enc)->image));
-   dmtxMessageDestroy(&((*enc)->message));
+   EncodeRelease(*enc);
 
-   free(*enc);
+   AllocFree(&((*enc)->allocator), *enc);
 
    *enc = NULL;
 
    return DmtxPass;
 }
 
+/**
+ * \brief  Return encode struct to default values for reuse
+ *
+ * Settings go back to those of a freshly created encoder, while the message
+ * and pixel storage of the previous encode are kept. Later calls to
+ * dmtxEncodeDataMatrix() reuse that storage whenever the new symbol needs no
+ * more of it, so an encoder recycled this way stops allocating once it has
+ * seen its largest symbol. The image and message from the previous encode
+ * are no longer valid after this call.
+ *
+ * \param  enc
+ * \return DmtxPass | DmtxFail
+ */
+DmtxPassFail
+dmtxEncodeReset(DmtxEncode *enc)
+{
+   if(enc == NULL)
+      return DmtxFail;
+
+   EncodeDefaults(enc);
+
+   return DmtxPass;
+}
+
 /**
  * \brief  Set encoding behavior property
  * \param  enc
@@ -157,73 +172,432 @@ DmtxPassFail
 dmtxEncodeDataMatrix(DmtxEncode *enc, int inputSize, unsigned char *inputString)
 {
    int sizeIdx;
-   int width, height, bitsPerPixel;
-   unsigned char *pxl;
+   int width, height, bitsPerPixel, rowSizeBytes;
    DmtxByte outputStorage[4096];
    DmtxByteList output = dmtxByteListBuild(outputStorage, sizeof(outputStorage));
-   DmtxByteList input = dmtxByteListBuild(inputString, inputSize);
-
-   input.length = inputSize;
-
-   /* Future: stream = StreamInit() ... */
-   /* Future: EncodeDataCodewords(&stream) ... */
 
    /* Encode input string into data codewords */
-   sizeIdx = EncodeDataCodewords(&input, &output, enc->sizeIdxRequest, enc->scheme);
-   if(sizeIdx == DmtxUndefined || output.length <= 0)
+   sizeIdx = EncodeSymbolCodewords(enc, inputSize, inputString, &output, &(enc->region));
+   if(sizeIdx == DmtxUndefined)
       return DmtxFail;
 
-   /* EncodeDataCodewords() should have updated any auto sizeIdx to a real one */
-   assert(sizeIdx != DmtxSymbolSquareAuto && sizeIdx != DmtxSymbolRectAuto);
-
-   /* XXX we can remove a lot of this redundant data */
-   enc->region.sizeIdx = sizeIdx;
-   enc->region.symbolRows = dmtxGetSymbolAttribute(DmtxSymAttribSymbolRows, sizeIdx);
-   enc->region.symbolCols = dmtxGetSymbolAttribute(DmtxSymAttribSymbolCols, sizeIdx);
-   enc->region.mappingRows = dmtxGetSymbolAttribute(DmtxSymAttribMappingMatrixRows, sizeIdx);
-   enc->region.mappingCols = dmtxGetSymbolAttribute(DmtxSymAttribMappingMatrixCols, sizeIdx);
-
-   /* Allocate memory for message and array */
-   enc->message = dmtxMessageCreate(sizeIdx, DmtxFormatMatrix);
+   /* Reuse message and array of previous encode when big enough */
+   if(EncodePrepareMessage(enc, sizeIdx) == DmtxFail)
+      return DmtxFail;
    enc->message->padCount = 0; /* XXX this needs to be added back */
-   memcpy(enc->message->code, output.b, output.length);
 
-   /* Generate error correction codewords */
-   RsEncode(enc->message, enc->region.sizeIdx);
-
-   /* Module placement in region */
-   ModulePlacementEcc200(enc->message->array, enc->message->code,
-         enc->region.sizeIdx, DmtxModuleOnRGB);
+   /* Generate error correction codewords and place modules */
+   PlaceSymbolModules(enc->message, &output, sizeIdx);
 
    width = 2 * enc->marginSize + (enc->region.symbolCols * enc->moduleSize);
    height = 2 * enc->marginSize + (enc->region.symbolRows * enc->moduleSize);
    bitsPerPixel = GetBitsPerPixel(enc->pixelPacking);
    if(bitsPerPixel == DmtxUndefined)
       return DmtxFail;
-   assert(bitsPerPixel % 8 == 0);
+   rowSizeBytes = (width * bitsPerPixel + 7)/8 + enc->rowPadBytes;
+
+   /* Reuse pixels of previous encode when big enough */
+   if(EncodePrepareImage(enc, width, height, rowSizeBytes) == DmtxFail)
+      return DmtxFail;
+
+   /* Renderer leaves row padding alone, so give it a defined value here */
+   if(enc->rowPadBytes > 0)
+      memset(enc->image->pxl, 0xff, rowSizeBytes * height);
+
+   dmtxImageSetProp(enc->image, DmtxPropImageFlip, enc->imageFlip);
+   dmtxImageSetProp(enc->image, DmtxPropRowPadBytes, enc->rowPadBytes);
+
+   /* Insert finder and aligment pattern modules */
+   PrintPattern(enc);
+
+   return DmtxPass;
+}
+
+/**
+ * \brief  Apply default settings of a new encoder
+ * \param  enc
+ * \return void
+ */
+static void
+EncodeDefaults(DmtxEncode *enc)
+{
+   enc->method = 0;
+   enc->scheme = DmtxSchemeAscii;
+   enc->sizeIdxRequest = DmtxSymbolSquareAuto;
+   enc->marginSize = 10;
+   enc->moduleSize = 5;
+   enc->pixelPacking = DmtxPack24bppRGB;
+   enc->imageFlip = DmtxFlipNone;
+   enc->rowPadBytes = 0;
+   memset(&(enc->region), 0x00, sizeof(DmtxRegion));
+
+   /* Initialize background color to white */
+/* enc.region.gradient.ray.p.R = 255.0;
+   enc.region.gradient.ray.p.G = 255.0;
+   enc.region.gradient.ray.p.B = 255.0; */
+
+   /* Initialize foreground color to black */
+/* enc.region.gradient.tMin = 0.0;
+   enc.region.gradient.tMax = xyz; */
+
+   dmtxMatrix3Identity(enc->xfrm);
+   memset(enc->rxfrm, 0x00, sizeof(DmtxMatrix3));
+}
+
+/**
+ * \brief  Copy settings of one encoder into another without sharing storage
+ * \param  dst
+ * \param  src
+ * \return void
+ */
+static void
+EncodeCopySettings(DmtxEncode *dst, DmtxEncode *src)
+{
+   DmtxAllocator allocator;
+
+   /* Storage stays with the allocator dst was created with */
+   allocator = dst->allocator;
+   *dst = *src;
+   dst->allocator = allocator;
+   dst->message = NULL;
+   dst->image = NULL;
+   dst->arrayCapacity = dst->codeCapacity = dst->pxlCapacity = 0;
+}
+
+/**
+ * \brief  Free image and message of previous encode
+ * \param  enc
+ * \return void
+ */
+static void
+EncodeRelease(DmtxEncode *enc)
+{
+   /* Free pixel array allocated in dmtxEncodeDataMatrix() */
+   if(enc->image != NULL && enc->image->pxl != NULL) {
+      AllocFree(&(enc->allocator), enc->image->pxl);
+      enc->image->pxl = NULL;
+   }
+
+   dmtxImageDestroy(&(enc->image));
+   dmtxMessageDestroy(&(enc->message));
+
+   enc->arrayCapacity = enc->codeCapacity = enc->pxlCapacity = 0;
+}
+
+/**
+ * \brief  Set up enc->message for sizeIdx, reusing existing arrays if they fit
+ * \param  enc
+ * \param  sizeIdx
+ * \return DmtxPass | DmtxFail
+ */
+static DmtxPassFail
+EncodePrepareMessage(DmtxEncode *enc, int sizeIdx)
+{
+   size_t arraySize, codeSize, outputSize;
+   unsigned char *output;
+   const DmtxSymbolInfo *info;
+
+   info = dmtxGetSymbolInfo(sizeIdx);
+   if(info == NULL)
+      return DmtxFail;
+
+   arraySize = info->mappingRows * info->mappingCols;
+   codeSize = info->symbolDataWords + info->symbolErrorWords;
+
+   if(enc->message != NULL && arraySize <= enc->arrayCapacity &&
+         codeSize <= enc->codeCapacity) {
+      /* Output buffer is only used by the decoder, so carry it over as is */
+      output = enc->message->output;
+      outputSize = enc->message->outputSize;
+      MessageInit(enc->message, sizeIdx, enc->message->array, enc->message->code);
+      enc->message->output = output;
+      enc->message->outputSize = outputSize;
+      enc->message->allocator = enc->allocator;
+      return DmtxPass;
+   }
+
+   dmtxMessageDestroy(&(enc->message));
+   enc->arrayCapacity = enc->codeCapacity = 0;
+
+   enc->message = MessageCreate(sizeIdx, DmtxFormatMatrix, NULL, &(enc->allocator));
+   if(enc->message == NULL)
+      return DmtxFail;
+
+   enc->arrayCapacity = enc->message->arraySize;
+   enc->codeCapacity = enc->message->codeSize;
+
+   return DmtxPass;
+}
+
+/**
+ * \brief  Set up enc->image with given geometry, reusing existing pixels if they fit
+ * \param  enc
+ * \param  width
+ * \param  height
+ * \param  rowSizeBytes
+ * \return DmtxPass | DmtxFail
+ */
+static DmtxPassFail
+EncodePrepareImage(DmtxEncode *enc, int width, int height, int rowSizeBytes)
+{
+   size_t imageSize;
+   unsigned char *pxl;
+
+   imageSize = (size_t)rowSizeBytes * height;
+
+   if(enc->image != NULL && imageSize <= enc->pxlCapacity) {
+      if(ImageInit(enc->image, enc->image->pxl, width, height, enc->pixelPacking) == DmtxFail)
+         return DmtxFail;
+      enc->image->allocator = enc->allocator;
+      return DmtxPass;
+   }
+
+   /* Keep old message, but never a stale image */
+   if(enc->image != NULL) {
+      AllocFree(&(enc->allocator), enc->image->pxl);
+      enc->image->pxl = NULL;
+      dmtxImageDestroy(&(enc->image));
+      enc->pxlCapacity = 0;
+   }
 
    /* Allocate memory for the image to be generated */
-   pxl = (unsigned char *)malloc(width * height * (bitsPerPixel/8) + enc->rowPadBytes);
+   pxl = (unsigned char *)AllocAligned(&(enc->allocator), imageSize);
    if(pxl == NULL) {
       perror("pixel malloc error");
       return DmtxFail;
    }
 
-   enc->image = dmtxImageCreate(pxl, width, height, enc->pixelPacking);
+   enc->image = dmtxImageCreateWithAllocator(pxl, width, height, enc->pixelPacking,
+         &(enc->allocator));
    if(enc->image == NULL) {
       perror("image malloc error");
+      AllocFree(&(enc->allocator), pxl);
       return DmtxFail;
    }
 
-   dmtxImageSetProp(enc->image, DmtxPropImageFlip, enc->imageFlip);
-   dmtxImageSetProp(enc->image, DmtxPropRowPadBytes, enc->rowPadBytes);
+   enc->pxlCapacity = imageSize;
 
-   /* Insert finder and aligment pattern modules */
-   PrintPattern(enc);
+   return DmtxPass;
+}
+
+/**
+ * \brief  Report image geometry needed to render message as Data Matrix
+ *
+ * Uses the current scheme, size request, module size, margin size, pixel
+ * packing, and row padding of enc. No memory is allocated.
+ *
+ * \param  enc
+ * \param  inputSize
+ * \param  inputString
+ * \param  width Receives image width in pixels
+ * \param  height Receives image height in pixels
+ * \param  rowSizeBytes Receives minimum row stride in bytes (including padding)
+ * \return DmtxPass | DmtxFail
+ */
+DmtxPassFail
+dmtxEncodeMeasure(DmtxEncode *enc, int inputSize, unsigned char *inputString,
+      int *width, int *height, int *rowSizeBytes)
+{
+   int sizeIdx;
+   int bitsPerPixel;
+   DmtxRegion region;
+   DmtxByte outputStorage[4096];
+   DmtxByteList output = dmtxByteListBuild(outputStorage, sizeof(outputStorage));
+
+   bitsPerPixel = GetBitsPerPixel(enc->pixelPacking);
+   if(bitsPerPixel == DmtxUndefined)
+      return DmtxFail;
+
+   sizeIdx = EncodeSymbolCodewords(enc, inputSize, inputString, &output, &region);
+   if(sizeIdx == DmtxUndefined)
+      return DmtxFail;
+
+   *width = 2 * enc->marginSize + (region.symbolCols * enc->moduleSize);
+   *height = 2 * enc->marginSize + (region.symbolRows * enc->moduleSize);
+   *rowSizeBytes = (*width * bitsPerPixel + 7)/8 + enc->rowPadBytes;
+
+   return DmtxPass;
+}
+
+/**
+ * \brief  Convert message into Data Matrix image stored in caller's buffer
+ *
+ * Renders without any heap allocation: message and image bookkeeping live on
+ * the stack, and enc->image and enc->message are left untouched. The pixel
+ * packing and image flip come from enc, while the row stride is supplied by
+ * the caller so the symbol can be drawn straight into a larger framebuffer.
+ *
+ * \param  enc
+ * \param  inputSize
+ * \param  inputString
+ * \param  pxl Destination pixels (first byte of symbol image)
+ * \param  width Must match width reported by dmtxEncodeMeasure()
+ * \param  height Must match height reported by dmtxEncodeMeasure()
+ * \param  rowSizeBytes Distance in bytes between starts of consecutive rows
+ * \return DmtxPass | DmtxFail
+ */
+DmtxPassFail
+dmtxEncodeDataMatrixBuffer(DmtxEncode *enc, int inputSize, unsigned char *inputString,
+      unsigned char *pxl, int width, int height, int rowSizeBytes)
+{
+   int sizeIdx;
+   DmtxRegion region;
+   DmtxByte outputStorage[4096];
+   DmtxByteList output = dmtxByteListBuild(outputStorage, sizeof(outputStorage));
+
+   if(pxl == NULL)
+      return DmtxFail;
+
+   sizeIdx = EncodeSymbolCodewords(enc, inputSize, inputString, &output, &region);
+   if(sizeIdx == DmtxUndefined)
+      return DmtxFail;
+
+   if(width != 2 * enc->marginSize + (region.symbolCols * enc->moduleSize) ||
+         height != 2 * enc->marginSize + (region.symbolRows * enc->moduleSize))
+      return DmtxFail;
+
+   return RenderSymbolBuffer(enc, &output, sizeIdx, pxl, width, height, rowSizeBytes);
+}
+
+/**
+ * \brief  Convert message into a packed Data Matrix module bitmap
+ *
+ * Stops after module placement instead of rasterizing. Each row of the
+ * symbol (top row first) occupies (cols + 7)/8 bytes, most significant bit
+ * first, with set bits marking dark modules. Finder and alignment patterns
+ * are included; quiet zone (marginSize) and moduleSize are not applied.
+ * Passing NULL for modules only reports the symbol dimensions.
+ *
+ * \param  enc
+ * \param  inputSize
+ * \param  inputString
+ * \param  modules Destination bitmap, or NULL
+ * \param  modulesSize Size of destination bitmap in bytes
+ * \param  rows Receives symbol rows
+ * \param  cols Receives symbol columns
+ * \return DmtxPass | DmtxFail
+ */
+DmtxPassFail
+dmtxEncodeModules(DmtxEncode *enc, int inputSize, unsigned char *inputString,
+      unsigned char *modules, int modulesSize, int *rows, int *cols)
+{
+   int sizeIdx;
+   int rowBytes;
+   DmtxRegion region;
+   DmtxMessage message;
+   unsigned char arrayStorage[DmtxMaxMappingArea];
+   unsigned char codeStorage[DmtxMaxCodeWords];
+   DmtxByte outputStorage[4096];
+   DmtxByteList output = dmtxByteListBuild(outputStorage, sizeof(outputStorage));
+
+   sizeIdx = EncodeSymbolCodewords(enc, inputSize, inputString, &output, &region);
+   if(sizeIdx == DmtxUndefined)
+      return DmtxFail;
+
+   *rows = region.symbolRows;
+   *cols = region.symbolCols;
+
+   if(modules == NULL)
+      return DmtxPass;
+
+   rowBytes = (*cols + 7)/8;
+   if(modulesSize < rowBytes * *rows)
+      return DmtxFail;
+
+   MessageInit(&message, sizeIdx, arrayStorage, codeStorage);
+   PlaceSymbolModules(&message, &output, sizeIdx);
+   BuildModuleBitmap(&message, sizeIdx, modules);
 
    return DmtxPass;
 }
 
+/**
+ * \brief  Convert packed module bitmap into filled rectangles
+ *
+ * Dark modules are grouped into horizontal runs, and runs with identical
+ * extent in consecutive rows are merged into a single taller rectangle.
+ * Coordinates are in modules with (0,0) at the top-left of the symbol, to
+ * suit vector and printer back-ends. When more than maxRects rectangles
+ * are needed the first maxRects are written and the full count is still
+ * returned, so callers can size a second attempt.
+ *
+ * \param  modules Bitmap produced by dmtxEncodeModules()
+ * \param  rows
+ * \param  cols
+ * \param  rects Destination rectangles (may be NULL if maxRects is 0)
+ * \param  maxRects
+ * \return Number of rectangles needed, or DmtxUndefined on bad input
+ */
+int
+dmtxEncodeModuleRects(const unsigned char *modules, int rows, int cols,
+      DmtxModuleRect *rects, int maxRects)
+{
+   int row, col, runStart;
+   int i, prevIdx;
+   int openCount, nextCount, rectCount;
+   int openX[DmtxMaxRunsPerRow], openWidth[DmtxMaxRunsPerRow], openRect[DmtxMaxRunsPerRow];
+   int nextX[DmtxMaxRunsPerRow], nextWidth[DmtxMaxRunsPerRow], nextRect[DmtxMaxRunsPerRow];
+   const unsigned char *rowPtr;
+
+   if(modules == NULL || rows < 1 || cols < 1 || cols > 2 * DmtxMaxRunsPerRow ||
+         (rects == NULL && maxRects > 0))
+      return DmtxUndefined;
+
+   rectCount = 0;
+   openCount = 0;
+
+   for(row = 0; row < rows; row++) {
+      rowPtr = modules + row * ((cols + 7)/8);
+      nextCount = 0;
+      prevIdx = 0;
+
+      for(col = 0; col < cols; col++) {
+         if(!(rowPtr[col >> 3] & (0x80 >> (col & 0x07))))
+            continue;
+
+         /* Find end of dark run */
+         runStart = col;
+         while(col + 1 < cols && (rowPtr[(col + 1) >> 3] & (0x80 >> ((col + 1) & 0x07))))
+            col++;
+
+         /* Runs are sorted by x in both rows, so a single forward scan finds a match */
+         while(prevIdx < openCount && openX[prevIdx] < runStart)
+            prevIdx++;
+
+         nextX[nextCount] = runStart;
+         nextWidth[nextCount] = col - runStart + 1;
+
+         if(prevIdx < openCount && openX[prevIdx] == runStart &&
+               openWidth[prevIdx] == nextWidth[nextCount]) {
+            /* Extend rectangle from previous row */
+            nextRect[nextCount] = openRect[prevIdx];
+            if(openRect[prevIdx] < maxRects)
+               rects[openRect[prevIdx]].height++;
+         }
+         else {
+            nextRect[nextCount] = rectCount;
+            if(rectCount < maxRects) {
+               rects[rectCount].x = runStart;
+               rects[rectCount].y = row;
+               rects[rectCount].width = nextWidth[nextCount];
+               rects[rectCount].height = 1;
+            }
+            rectCount++;
+         }
+         nextCount++;
+      }
+
+      for(i = 0; i < nextCount; i++) {
+         openX[i] = nextX[i];
+         openWidth[i] = nextWidth[i];
+         openRect[i] = nextRect[i];
+      }
+      openCount = nextCount;
+   }
+
+   return rectCount;
+}
+
 /**
  * \brief  Convert message into Data Mosaic image
  *
@@ -284,13 +658,15 @@ dmtxEncodeDataMosaic(DmtxEncode *enc, int inputSize, unsigned char *inputString)
       dmtxEncodeDestroy(&encG);
       dmtxEncodeDestroy(&encB);
 
-      encR = dmtxEncodeCreate();
-      encG = dmtxEncodeCreate();
-      encB = dmtxEncodeCreate();
+      encR = dmtxEncodeCreateWithAllocator(&(enc->allocator));
+      encG = dmtxEncodeCreateWithAllocator(&(enc->allocator));
+      encB = dmtxEncodeCreateWithAllocator(&(enc->allocator));
 
-      /* Copy all settings from master DmtxEncode, including pointer to image
-         and message, which is initially null */
-      *encR = *encG = *encB = *enc;
+      /* Copy all settings from master DmtxEncode, but not its image and
+         message, which may hold storage from a previous encode */
+      EncodeCopySettings(encR, enc);
+      EncodeCopySettings(encG, enc);
+      EncodeCopySettings(encB, enc);
 
       dmtxEncodeSetProp(encR, DmtxPropSizeRequest, sizeIdxAttempt);
       dmtxEncodeSetProp(encG, DmtxPropSizeRequest, sizeIdxAttempt);
@@ -372,13 +748,15 @@ dmtxEncodeDataMosaic(DmtxEncode *enc, int inputSize, unsigned char *inputString)
  * \param  inputSize
  * \param  scheme
  * \param  sizeIdx
+ * \param  allocator Used for scratch memory
  * \return Count of encoded data words
  *
  * Future: pass DmtxEncode to this function with an error reason field, which
  *         goes to EncodeSingle... too
  */
 static int
-EncodeDataCodewords(DmtxByteList *input, DmtxByteList *output, int sizeIdxRequest, DmtxScheme scheme)
+EncodeDataCodewords(DmtxByteList *input, DmtxByteList *output, int sizeIdxRequest,
+      DmtxScheme scheme, const DmtxAllocator *allocator)
 {
    int sizeIdx;
 
@@ -386,10 +764,10 @@ EncodeDataCodewords(DmtxByteList *input, DmtxByteList *output, int sizeIdxReques
    switch(scheme)
    {
       case DmtxSchemeAutoBest:
-         sizeIdx = EncodeOptimizeBest(input, output, sizeIdxRequest);
+         sizeIdx = EncodeOptimizeBest(input, output, sizeIdxRequest, allocator);
          break;
       case DmtxSchemeAutoFast:
-         sizeIdx = DmtxUndefined; /* EncodeAutoFast(input, output, sizeIdxRequest, passFail); */
+         sizeIdx = EncodeAutoFast(input, output, sizeIdxRequest);
          break;
       default:
          sizeIdx = EncodeSingleScheme(input, output, sizeIdxRequest, scheme);
@@ -399,6 +777,134 @@ EncodeDataCodewords(DmtxByteList *input, DmtxByteList *output, int sizeIdxReques
    return sizeIdx;
 }
 
+/**
+ * \brief  Encode input into data codewords and record resulting symbol size
+ * \param  enc
+ * \param  inputSize
+ * \param  inputString
+ * \param  output Receives data codewords
+ * \param  region Receives symbol size (enc->region or a caller's local)
+ * \return Symbol size index, or DmtxUndefined if input does not fit
+ */
+static int
+EncodeSymbolCodewords(DmtxEncode *enc, int inputSize, unsigned char *inputString,
+      DmtxByteList *output, DmtxRegion *region)
+{
+   int sizeIdx;
+   const DmtxSymbolInfo *info;
+   DmtxByteList input = dmtxByteListBuild(inputString, inputSize);
+
+   input.length = inputSize;
+
+   /* Future: stream = StreamInit() ... */
+   /* Future: EncodeDataCodewords(&stream) ... */
+
+   /* Encode input string into data codewords */
+   sizeIdx = EncodeDataCodewords(&input, output, enc->sizeIdxRequest, enc->scheme,
+         &(enc->allocator));
+   if(sizeIdx == DmtxUndefined || output->length <= 0)
+      return DmtxUndefined;
+
+   /* EncodeDataCodewords() should have updated any auto sizeIdx to a real one */
+   assert(sizeIdx != DmtxSymbolSquareAuto && sizeIdx != DmtxSymbolRectAuto);
+
+   /* XXX we can remove a lot of this redundant data */
+   info = dmtxGetSymbolInfo(sizeIdx);
+   region->sizeIdx = sizeIdx;
+   region->symbolRows = info->symbolRows;
+   region->symbolCols = info->symbolCols;
+   region->mappingRows = info->mappingRows;
+   region->mappingCols = info->mappingCols;
+
+   return sizeIdx;
+}
+
+/**
+ * \brief  Place data codewords and render them into caller's pixels
+ *
+ * Message and image bookkeeping live on the stack, so nothing is allocated
+ * and enc->image and enc->message are left untouched.
+ *
+ * \param  enc Settings (packing, flip, module and margin size)
+ * \param  output Data codewords
+ * \param  sizeIdx
+ * \param  pxl Destination pixels
+ * \param  width
+ * \param  height
+ * \param  rowSizeBytes Distance in bytes between starts of consecutive rows
+ * \return DmtxPass | DmtxFail
+ */
+static DmtxPassFail
+RenderSymbolBuffer(DmtxEncode *enc, DmtxByteList *output, int sizeIdx,
+      unsigned char *pxl, int width, int height, int rowSizeBytes)
+{
+   DmtxImage image;
+   DmtxMessage message;
+   unsigned char arrayStorage[DmtxMaxMappingArea];
+   unsigned char codeStorage[DmtxMaxCodeWords];
+
+   if(ImageInit(&image, pxl, width, height, enc->pixelPacking) == DmtxFail ||
+         rowSizeBytes < image.rowSizeBytes)
+      return DmtxFail;
+
+   dmtxImageSetProp(&image, DmtxPropImageFlip, enc->imageFlip);
+   dmtxImageSetProp(&image, DmtxPropRowPadBytes, rowSizeBytes - image.rowSizeBytes);
+
+   MessageInit(&message, sizeIdx, arrayStorage, codeStorage);
+   PlaceSymbolModules(&message, output, sizeIdx);
+
+   return RenderPattern(&image, &message, sizeIdx, enc->moduleSize, enc->marginSize);
+}
+
+/**
+ * \brief  Pack placed modules of message into bitmap described by dmtxEncodeModules()
+ * \param  message Message with modules already placed
+ * \param  sizeIdx
+ * \param  modules Destination of at least rows * ((cols + 7)/8) bytes
+ * \return void
+ */
+static void
+BuildModuleBitmap(DmtxMessage *message, int sizeIdx, unsigned char *modules)
+{
+   int rows, cols, rowBytes;
+   int row, symbolRow, symbolCol;
+   unsigned char *rowPtr;
+
+   rows = dmtxGetSymbolAttribute(DmtxSymAttribSymbolRows, sizeIdx);
+   cols = dmtxGetSymbolAttribute(DmtxSymAttribSymbolCols, sizeIdx);
+   rowBytes = (cols + 7)/8;
+
+   memset(modules, 0x00, rowBytes * rows);
+
+   for(row = 0; row < rows; row++) {
+      rowPtr = modules + row * rowBytes;
+      symbolRow = rows - row - 1;
+      for(symbolCol = 0; symbolCol < cols; symbolCol++) {
+         if(dmtxSymbolModuleStatus(message, sizeIdx, symbolRow, symbolCol) & DmtxModuleOnRGB)
+            rowPtr[symbolCol >> 3] |= (0x80 >> (symbolCol & 0x07));
+      }
+   }
+}
+
+/**
+ * \brief  Add error codewords to message and place all codewords as modules
+ * \param  message Message sized for sizeIdx with zeroed module array
+ * \param  output Data codewords
+ * \param  sizeIdx
+ * \return void
+ */
+static void
+PlaceSymbolModules(DmtxMessage *message, DmtxByteList *output, int sizeIdx)
+{
+   memcpy(message->code, output->b, output->length);
+
+   /* Generate error correction codewords */
+   RsEncode(message, sizeIdx);
+
+   /* Module placement in region */
+   ModulePlacementEcc200(message->array, message->code, sizeIdx, DmtxModuleOnRGB);
+}
+
 /**
  * \brief  Write encoded message to image
  * \param  enc
@@ -407,15 +913,8 @@ EncodeDataCodewords(DmtxByteList *input, DmtxByteList *output, int sizeIdxReques
 static void
 PrintPattern(DmtxEncode *enc)
 {
-   int i, j;
-   int symbolRow, symbolCol;
-   int pixelRow, pixelCol;
-   int moduleStatus;
-   size_t rowSize, height;
-   int rgb[3];
    double sxy, txy;
    DmtxMatrix3 m1, m2;
-   DmtxVector2 vIn, vOut;
 
    txy = enc->marginSize;
    sxy = 1.0/enc->moduleSize;
@@ -428,37 +927,271 @@ PrintPattern(DmtxEncode *enc)
    dmtxMatrix3Scale(m2, enc->moduleSize, enc->moduleSize);
    dmtxMatrix3Multiply(enc->rxfrm, m2, m1);
 
-   rowSize = dmtxImageGetProp(enc->image, DmtxPropRowSizeBytes);
-   height = dmtxImageGetProp(enc->image, DmtxPropHeight);
+   RenderPattern(enc->image, enc->message, enc->region.sizeIdx,
+         enc->moduleSize, enc->marginSize);
+}
 
-   memset(enc->image->pxl, 0xff, rowSize * height);
+/**
+ * \brief  Draw symbol modules into an image sized for them
+ * \param  img
+ * \param  message Message with module placement already completed
+ * \param  sizeIdx
+ * \param  moduleSize
+ * \param  marginSize
+ * \return DmtxPass | DmtxFail
+ */
+static DmtxPassFail
+RenderPattern(DmtxImage *img, DmtxMessage *message, int sizeIdx, int moduleSize,
+      int marginSize)
+{
+   int i, j;
+   int symbolRow, symbolCol;
+   int pixelRow, pixelCol;
+   int moduleStatus;
+   int rgb[3];
+   unsigned char *rowPtr;
+   const DmtxSymbolInfo *info;
+
+   /* Byte-aligned packings are rendered a full pixel row at a time */
+   if(RenderPatternRows(img, message, sizeIdx, moduleSize, marginSize) == DmtxPass)
+      return DmtxPass;
 
-   for(symbolRow = 0; symbolRow < enc->region.symbolRows; symbolRow++) {
-      for(symbolCol = 0; symbolCol < enc->region.symbolCols; symbolCol++) {
+   info = dmtxGetSymbolInfo(sizeIdx);
+   if(info == NULL || img->channelCount < 3)
+      return DmtxFail;
 
-         vIn.X = symbolCol;
-         vIn.Y = symbolRow;
+   for(i = 0; i < img->height; i++) {
+      rowPtr = img->pxl + i * img->rowSizeBytes;
+      memset(rowPtr, 0xff, (img->width * img->bitsPerPixel + 7)/8);
+   }
 
-         dmtxMatrix3VMultiply(&vOut, &vIn, enc->rxfrm);
+   for(symbolRow = 0; symbolRow < info->symbolRows; symbolRow++) {
+      for(symbolCol = 0; symbolCol < info->symbolCols; symbolCol++) {
 
-         pixelCol = (int)(vOut.X);
-         pixelRow = (int)(vOut.Y);
+         pixelCol = marginSize + symbolCol * moduleSize;
+         pixelRow = marginSize + symbolRow * moduleSize;
 
-         moduleStatus = dmtxSymbolModuleStatus(enc->message,
-               enc->region.sizeIdx, symbolRow, symbolCol);
+         moduleStatus = dmtxSymbolModuleStatus(message, sizeIdx, symbolRow, symbolCol);
 
-         for(i = pixelRow; i < pixelRow + enc->moduleSize; i++) {
-            for(j = pixelCol; j < pixelCol + enc->moduleSize; j++) {
+         for(i = pixelRow; i < pixelRow + moduleSize; i++) {
+            for(j = pixelCol; j < pixelCol + moduleSize; j++) {
                rgb[0] = ((moduleStatus & DmtxModuleOnRed) != 0x00) ? 0 : 255;
                rgb[1] = ((moduleStatus & DmtxModuleOnGreen) != 0x00) ? 0 : 255;
                rgb[2] = ((moduleStatus & DmtxModuleOnBlue) != 0x00) ? 0 : 255;
-/*             dmtxImageSetRgb(enc->image, j, i, rgb); */
-               dmtxImageSetPixelValue(enc->image, j, i, 0, rgb[0]);
-               dmtxImageSetPixelValue(enc->image, j, i, 1, rgb[1]);
-               dmtxImageSetPixelValue(enc->image, j, i, 2, rgb[2]);
+/*             dmtxImageSetRgb(img, j, i, rgb); */
+               dmtxImageSetPixelValue(img, j, i, 0, rgb[0]);
+               dmtxImageSetPixelValue(img, j, i, 1, rgb[1]);
+               dmtxImageSetPixelValue(img, j, i, 2, rgb[2]);
             }
          }
 
       }
    }
+
+   return DmtxPass;
+}
+
+/**
+ * \brief  Build the bytes of one pixel for each combination of module colors
+ * \param  img
+ * \param  pixel Receives one pixel per DmtxModuleOnRGB bit combination
+ * \return DmtxPass | DmtxFail (packing is not byte-aligned)
+ */
+static DmtxPassFail
+BuildPatternPixels(DmtxImage *img, unsigned char pixel[][4])
+{
+   int color, channel;
+
+   if(img->bitsPerPixel % 8 != 0 || img->bytesPerPixel < 1 || img->bytesPerPixel > 4)
+      return DmtxFail;
+
+   for(channel = 0; channel < img->channelCount && channel < 3; channel++) {
+      if(img->bitsPerChannel[channel] != 8 || img->channelStart[channel] % 8 != 0)
+         return DmtxFail;
+   }
+
+   /* Unused channels and padding bytes stay white, as in a blank image */
+   for(color = 0; color <= DmtxModuleOnRGB; color++) {
+      memset(pixel[color], 0xff, 4);
+      for(channel = 0; channel < img->channelCount && channel < 3; channel++) {
+         pixel[color][img->channelStart[channel]/8] =
+               (color & (DmtxModuleOnRed << channel)) ? 0 : 255;
+      }
+   }
+
+   return DmtxPass;
+}
+
+/**
+ * \brief  Render symbol modules into image one pixel row per symbol row
+ *
+ * Each symbol row is written once as runs of identical pixels (one run per
+ * module) and then replicated moduleSize times with memcpy, so the cost is
+ * dominated by memory bandwidth rather than per-pixel function calls. Row
+ * padding bytes are never written, allowing img to describe a window into a
+ * larger buffer.
+ *
+ * \param  img Destination image sized for symbol, module, and margin sizes
+ * \param  message Message with module placement already completed
+ * \param  sizeIdx
+ * \param  moduleSize
+ * \param  marginSize
+ * \return DmtxPass | DmtxFail (packing or geometry not handled here)
+ */
+static DmtxPassFail
+RenderPatternRows(DmtxImage *img, DmtxMessage *message, int sizeIdx,
+      int moduleSize, int marginSize)
+{
+   int i;
+   int y, yBeg, yEnd;
+   int symbolRow, symbolCol;
+   int bytesPerPixel, rowBytes;
+   int moduleStatus;
+   unsigned char pixel[DmtxModuleOnRGB + 1][4];
+   unsigned char *rowStart, *ptr;
+   const DmtxSymbolInfo *info;
+
+   assert(img != NULL && message != NULL);
+
+   info = dmtxGetSymbolInfo(sizeIdx);
+   if(info == NULL || moduleSize < 1 || marginSize < 0)
+      return DmtxFail;
+
+   if(img->width < 2 * marginSize + info->symbolCols * moduleSize ||
+         img->height != 2 * marginSize + info->symbolRows * moduleSize)
+      return DmtxFail;
+
+   if(img->bitsPerPixel != 1 && BuildPatternPixels(img, pixel) == DmtxFail)
+      return DmtxFail;
+
+   bytesPerPixel = img->bytesPerPixel;
+   rowBytes = (img->width * img->bitsPerPixel + 7)/8;
+
+   /* Margin rows below and above the symbol */
+   for(y = 0; y < marginSize; y++) {
+      memset(PatternRowPtr(img, y), 0xff, rowBytes);
+      memset(PatternRowPtr(img, img->height - y - 1), 0xff, rowBytes);
+   }
+
+   for(symbolRow = 0; symbolRow < info->symbolRows; symbolRow++) {
+
+      yBeg = marginSize + symbolRow * moduleSize;
+      yEnd = yBeg + moduleSize;
+
+      /* Compose first pixel row, leaving margins white */
+      rowStart = PatternRowPtr(img, yBeg);
+      memset(rowStart, 0xff, rowBytes);
+      ptr = rowStart + marginSize * bytesPerPixel;
+
+      for(symbolCol = 0; symbolCol < info->symbolCols; symbolCol++) {
+         moduleStatus = dmtxSymbolModuleStatus(message, sizeIdx, symbolRow,
+               symbolCol) & DmtxModuleOnRGB;
+
+         /* 1bpp rows start white, so only dark modules need their bits cleared */
+         if(img->bitsPerPixel == 1) {
+            if(moduleStatus & DmtxModuleOnRed)
+               ClearBitRun(rowStart, marginSize + symbolCol * moduleSize, moduleSize);
+            continue;
+         }
+
+         /* Pixels made of one repeated byte can be written as a single run */
+         if(memcmp(pixel[moduleStatus], pixel[moduleStatus] + 1, bytesPerPixel - 1) == 0) {
+            memset(ptr, pixel[moduleStatus][0], moduleSize * bytesPerPixel);
+            ptr += moduleSize * bytesPerPixel;
+         }
+         else {
+            for(i = 0; i < moduleSize; i++) {
+               memcpy(ptr, pixel[moduleStatus], bytesPerPixel);
+               ptr += bytesPerPixel;
+            }
+         }
+      }
+
+      /* Replicate composed row for remaining pixel rows of this module row */
+      for(y = yBeg + 1; y < yEnd; y++)
+         memcpy(PatternRowPtr(img, y), rowStart, rowBytes);
+   }
+
+   return DmtxPass;
+}
+
+/**
+ * \brief  Address of first byte in image row y, honoring image flip
+ * \param  img
+ * \param  y
+ * \return Pointer to row
+ */
+static unsigned char *
+PatternRowPtr(DmtxImage *img, int y)
+{
+   if(img->imageFlip & DmtxFlipY)
+      return img->pxl + y * img->rowSizeBytes;
+
+   return img->pxl + (img->height - y - 1) * img->rowSizeBytes;
+}
+
+/**
+ * \brief  Clear a run of bits in a 1bpp row (leftmost pixel in MSB)
+ * \param  row
+ * \param  start First pixel of run
+ * \param  count Number of pixels in run
+ * \return void
+ */
+static void
+ClearBitRun(unsigned char *row, int start, int count)
+{
+   int end, byteBeg, byteEnd;
+   unsigned char maskBeg, maskEnd;
+
+   if(count < 1)
+      return;
+
+   end = start + count; /* one past last pixel */
+   byteBeg = start >> 3;
+   byteEnd = (end - 1) >> 3;
+   maskBeg = (unsigned char)(0xff >> (start & 0x07));
+   maskEnd = (unsigned char)(0xff << (7 - ((end - 1) & 0x07)));
+
+   if(byteBeg == byteEnd) {
+      row[byteBeg] &= ~(maskBeg & maskEnd);
+      return;
+   }
+
+   row[byteBeg] &= ~maskBeg;
+   if(byteEnd > byteBeg + 1)
+      memset(row + byteBeg + 1, 0x00, byteEnd - byteBeg - 1);
+   row[byteEnd] &= ~maskEnd;
+}
+
+/**
+ * \brief  Set a run of bits in a 1bpp row (leftmost pixel in MSB)
+ * \param  row
+ * \param  start First pixel of run
+ * \param  count Number of pixels in run
+ * \return void
+ */
+static void
+SetBitRun(unsigned char *row, int start, int count)
+{
+   int end, byteBeg, byteEnd;
+   unsigned char maskBeg, maskEnd;
+
+   if(count < 1)
+      return;
+
+   end = start + count; /* one past last pixel */
+   byteBeg = start >> 3;
+   byteEnd = (end - 1) >> 3;
+   maskBeg = (unsigned char)(0xff >> (start & 0x07));
+   maskEnd = (unsigned char)(0xff << (7 - ((end - 1) & 0x07)));
+
+   if(byteBeg == byteEnd) {
+      row[byteBeg] |= (maskBeg & maskEnd);
+      return;
+   }
+
+   row[byteBeg] |= maskBeg;
+   if(byteEnd > byteBeg + 1)
+      memset(row + byteBeg + 1, 0xff, byteEnd - byteBeg - 1);
+   row[byteEnd] |= maskEnd;
 }
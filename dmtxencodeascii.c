@@ -115,29 +115,25 @@ CompleteIfDoneAscii(DmtxEncodeStream *stream, int sizeIdxRequest)
 static void
 PadRemainingInAscii(DmtxEncodeStream *stream, int sizeIdx)
 {
-   int symbolRemaining;
-   DmtxByte padValue;
+   int i, padStart, symbolRemaining;
+   DmtxByte *pad;
 
    CHKSCHEME(DmtxSchemeAscii);
    CHKSIZE;
 
    symbolRemaining = GetRemainingSymbolCapacity(stream->output->length, sizeIdx);
+   if(symbolRemaining <= 0)
+      return;
+
+   padStart = stream->output->length;
+   pad = StreamOutputChainReserve(stream, symbolRemaining); CHKERR;
 
    /* First pad character is not randomized */
-   if(symbolRemaining > 0)
-   {
-      padValue = DmtxValueAsciiPad;
-      StreamOutputChainAppend(stream, padValue); CHKERR;
-      symbolRemaining--;
-   }
+   pad[0] = DmtxValueAsciiPad;
 
    /* All remaining pad characters are randomized based on character position */
-   while(symbolRemaining > 0)
-   {
-      padValue = Randomize253State(DmtxValueAsciiPad, stream->output->length + 1);
-      StreamOutputChainAppend(stream, padValue); CHKERR;
-      symbolRemaining--;
-   }
+   for(i = 1; i < symbolRemaining; i++)
+      pad[i] = Randomize253State(DmtxValueAsciiPad, padStart + i + 1);
 }
 
 /**
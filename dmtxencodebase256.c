@@ -190,13 +190,12 @@ static void
 Base256OutputChainInsertFirst(DmtxEncodeStream *stream)
 {
    DmtxByte value;
-   DmtxPassFail passFail;
    int i, chainStart;
 
    chainStart = stream->output->length - stream->outputChainWordCount;
-   dmtxByteListPush(stream->output, 0, &passFail);
-   if(passFail == DmtxPass)
+   if(stream->output->length < stream->output->capacity)
    {
+      DMTX_BYTELIST_PUSH(stream->output, 0);
       for(i = stream->output->length - 1; i > chainStart; i--)
       {
          value = UnRandomize255State(stream->output->b[i-1], i);
@@ -219,9 +218,14 @@ static void
 Base256OutputChainRemoveFirst(DmtxEncodeStream *stream)
 {
    DmtxByte value;
-   DmtxPassFail passFail;
    int i, chainStart;
 
+   if(stream->outputChainWordCount <= 0)
+   {
+      StreamMarkFatal(stream, DmtxErrorUnknown);
+      return;
+   }
+
    chainStart = stream->output->length - stream->outputChainWordCount;
 
    for(i = chainStart; i < stream->output->length - 1; i++)
@@ -230,11 +234,8 @@ Base256OutputChainRemoveFirst(DmtxEncodeStream *stream)
       stream->output->b[i] = Randomize255State(value, i + 1);
    }
 
-   dmtxByteListPop(stream->output, &passFail);
-   if(passFail == DmtxPass)
-      stream->outputChainWordCount--;
-   else
-      StreamMarkFatal(stream, DmtxErrorUnknown);
+   DMTX_BYTELIST_POP(stream->output);
+   stream->outputChainWordCount--;
 }
 
 /**
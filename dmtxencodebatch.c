@@ -0,0 +1,294 @@
+/**
+ * libdmtx - Data Matrix Encoding/Decoding Library
+ * Copyright 2011 Mike Laughton. All rights reserved.
+ *
+ * See LICENSE file in the main project directory for full
+ * terms of use and distribution.
+ *
+ * Contact: Mike Laughton <mike@dragonflylogic.com>
+ *
+ * \file dmtxencodebatch.c
+ * \brief Encoding many payloads with shared settings
+ */
+
+#if defined(HAVE_PTHREAD_H)
+
+#include <pthread.h>
+
+/**
+ * Progress of one batch, shared by the calling thread and its workers.
+ * Workers claim jobs in order through jobNext, and the calling thread waits
+ * on jobFinished to hand completed jobs to the callback in the same order.
+ */
+typedef struct DmtxEncodeBatch_struct {
+   DmtxEncode     *enc;
+   DmtxEncodeJob  *jobs;
+   int             jobCount;
+   int             jobNext;
+   DmtxBoolean     stop;
+   unsigned char  *jobDone;
+   pthread_mutex_t mutex;
+   pthread_cond_t  jobFinished;
+} DmtxEncodeBatch;
+
+#endif
+
+/**
+ * \brief  Encode many payloads with the same settings
+ *
+ * Each job is rendered into its own image using the scheme, size request,
+ * module and margin sizes, pixel packing, flip, and row padding of enc. Jobs
+ * run on up to threadCount worker threads, each reusing one copy of the
+ * settings so nothing is allocated per job beyond pixels the caller didn't
+ * supply. Pixels allocated this way belong to the caller, who releases them
+ * with dmtxEncodeJobRelease(). Without thread support the batch runs on the
+ * calling thread.
+ *
+ * If callback is not NULL it is called on the calling thread for every job in
+ * order, as soon as that job and all jobs before it are finished, so results
+ * can be written out while later jobs are still encoding. Returning DmtxFail
+ * from callback stops the batch; jobs not yet started are left untouched.
+ *
+ * \param  enc Settings shared by all jobs (not modified)
+ * \param  jobs
+ * \param  jobCount
+ * \param  threadCount Number of worker threads, 1 or less to use caller's thread
+ * \param  callback Receives finished jobs in order, or NULL
+ * \param  userData Passed to callback
+ * \return DmtxPass if every job was attempted, otherwise DmtxFail. Failures
+ *         of individual jobs are reported in their passFail field.
+ */
+DmtxPassFail
+dmtxEncodeBatch(DmtxEncode *enc, DmtxEncodeJob *jobs, int jobCount, int threadCount,
+      DmtxEncodeJobCallback callback, void *userData)
+{
+   if(enc == NULL || jobCount < 0 || (jobs == NULL && jobCount > 0))
+      return DmtxFail;
+
+   if(threadCount > jobCount)
+      threadCount = jobCount;
+
+#if defined(HAVE_PTHREAD_H)
+   if(threadCount > 1)
+      return EncodeBatchThreads(enc, jobs, jobCount, threadCount, callback, userData);
+#endif
+
+   return EncodeBatchSerial(enc, jobs, jobCount, callback, userData);
+}
+
+/**
+ * \brief  Free pixels the batch allocated for a job
+ *
+ * Use when dmtxEncodeBatch() allocated job->pxl (it was NULL going in). The
+ * pixels come from enc's allocator, so enc must be the encoder the batch ran
+ * with. Buffers supplied by the caller stay the caller's to free.
+ *
+ * \param  enc Encoder passed to dmtxEncodeBatch()
+ * \param  job
+ * \return DmtxPass | DmtxFail
+ */
+DmtxPassFail
+dmtxEncodeJobRelease(DmtxEncode *enc, DmtxEncodeJob *job)
+{
+   if(enc == NULL || job == NULL)
+      return DmtxFail;
+
+   if(job->pxl != NULL)
+      AllocFree(&(enc->allocator), job->pxl);
+
+   job->pxl = NULL;
+   job->pxlSize = 0;
+
+   return DmtxPass;
+}
+
+/**
+ * \brief  Encode batch on the calling thread
+ * \param  enc
+ * \param  jobs
+ * \param  jobCount
+ * \param  callback
+ * \param  userData
+ * \return DmtxPass | DmtxFail (stopped by callback)
+ */
+static DmtxPassFail
+EncodeBatchSerial(DmtxEncode *enc, DmtxEncodeJob *jobs, int jobCount,
+      DmtxEncodeJobCallback callback, void *userData)
+{
+   int i;
+   DmtxEncode encJob;
+
+   encJob = *enc;
+
+   for(i = 0; i < jobCount; i++) {
+      EncodeBatchJob(&encJob, &jobs[i]);
+
+      if(callback != NULL && (*callback)(&jobs[i], i, userData) == DmtxFail)
+         return DmtxFail;
+   }
+
+   return DmtxPass;
+}
+
+#if defined(HAVE_PTHREAD_H)
+
+/**
+ * \brief  Encode batch on worker threads
+ * \param  enc
+ * \param  jobs
+ * \param  jobCount
+ * \param  threadCount
+ * \param  callback
+ * \param  userData
+ * \return DmtxPass | DmtxFail
+ */
+static DmtxPassFail
+EncodeBatchThreads(DmtxEncode *enc, DmtxEncodeJob *jobs, int jobCount,
+      int threadCount, DmtxEncodeJobCallback callback, void *userData)
+{
+   int i, threadsStarted;
+   DmtxPassFail passFail;
+   DmtxEncodeBatch batch;
+   pthread_t *threads;
+
+   memset(&batch, 0x00, sizeof(DmtxEncodeBatch));
+   batch.enc = enc;
+   batch.jobs = jobs;
+   batch.jobCount = jobCount;
+   batch.jobNext = 0;
+   batch.stop = DmtxFalse;
+
+   batch.jobDone = (unsigned char *)AllocCalloc(&(enc->allocator), jobCount, sizeof(unsigned char));
+   threads = (pthread_t *)AllocMalloc(&(enc->allocator), threadCount * sizeof(pthread_t));
+   if(batch.jobDone == NULL || threads == NULL) {
+      AllocFree(&(enc->allocator), batch.jobDone);
+      AllocFree(&(enc->allocator), threads);
+      return EncodeBatchSerial(enc, jobs, jobCount, callback, userData);
+   }
+
+   pthread_mutex_init(&batch.mutex, NULL);
+   pthread_cond_init(&batch.jobFinished, NULL);
+
+   for(threadsStarted = 0; threadsStarted < threadCount; threadsStarted++) {
+      if(pthread_create(&threads[threadsStarted], NULL, EncodeBatchWorker, &batch) != 0)
+         break;
+   }
+
+   /* Caller's thread does the work if no worker could be started */
+   if(threadsStarted == 0)
+      EncodeBatchWorker(&batch);
+
+   /* Hand finished jobs to callback in order */
+   passFail = DmtxPass;
+   for(i = 0; i < jobCount; i++) {
+      pthread_mutex_lock(&batch.mutex);
+      while(!batch.jobDone[i])
+         pthread_cond_wait(&batch.jobFinished, &batch.mutex);
+      pthread_mutex_unlock(&batch.mutex);
+
+      if(callback != NULL && (*callback)(&jobs[i], i, userData) == DmtxFail) {
+         pthread_mutex_lock(&batch.mutex);
+         batch.stop = DmtxTrue;
+         pthread_mutex_unlock(&batch.mutex);
+         passFail = DmtxFail;
+         break;
+      }
+   }
+
+   for(i = 0; i < threadsStarted; i++)
+      pthread_join(threads[i], NULL);
+
+   pthread_cond_destroy(&batch.jobFinished);
+   pthread_mutex_destroy(&batch.mutex);
+   AllocFree(&(enc->allocator), threads);
+   AllocFree(&(enc->allocator), batch.jobDone);
+
+   return passFail;
+}
+
+/**
+ * \brief  Worker thread: claim and encode jobs until none remain
+ * \param  arg Shared DmtxEncodeBatch
+ * \return NULL
+ */
+static void *
+EncodeBatchWorker(void *arg)
+{
+   int jobIdx;
+   DmtxEncode encJob;
+   DmtxEncodeBatch *batch;
+
+   batch = (DmtxEncodeBatch *)arg;
+   encJob = *(batch->enc);
+
+   for(;;) {
+      pthread_mutex_lock(&batch->mutex);
+      if(batch->stop == DmtxTrue || batch->jobNext >= batch->jobCount) {
+         pthread_mutex_unlock(&batch->mutex);
+         break;
+      }
+      jobIdx = batch->jobNext++;
+      pthread_mutex_unlock(&batch->mutex);
+
+      EncodeBatchJob(&encJob, &batch->jobs[jobIdx]);
+
+      pthread_mutex_lock(&batch->mutex);
+      batch->jobDone[jobIdx] = 1;
+      pthread_cond_signal(&batch->jobFinished);
+      pthread_mutex_unlock(&batch->mutex);
+   }
+
+   return NULL;
+}
+
+#endif
+
+/**
+ * \brief  Encode one job into its destination pixels
+ * \param  enc Thread's own copy of batch settings
+ * \param  job
+ * \return void
+ */
+static void
+EncodeBatchJob(DmtxEncode *enc, DmtxEncodeJob *job)
+{
+   int sizeIdx, bitsPerPixel, imageSize;
+   DmtxRegion region;
+   DmtxByte outputStorage[4096];
+   DmtxByteList output = dmtxByteListBuild(outputStorage, sizeof(outputStorage));
+
+   job->passFail = DmtxFail;
+   job->width = job->height = job->rowSizeBytes = 0;
+
+   bitsPerPixel = GetBitsPerPixel(enc->pixelPacking);
+   if(bitsPerPixel == DmtxUndefined)
+      return;
+
+   sizeIdx = EncodeSymbolCodewords(enc, job->inputSize, job->inputString, &output,
+         &region);
+   if(sizeIdx == DmtxUndefined)
+      return;
+
+   job->width = 2 * enc->marginSize + (region.symbolCols * enc->moduleSize);
+   job->height = 2 * enc->marginSize + (region.symbolRows * enc->moduleSize);
+   job->rowSizeBytes = (job->width * bitsPerPixel + 7)/8 + enc->rowPadBytes;
+   imageSize = job->rowSizeBytes * job->height;
+
+   /* Caller can retry with a buffer of the reported size */
+   if(job->pxl == NULL) {
+      job->pxl = (unsigned char *)AllocAligned(&(enc->allocator), imageSize);
+      if(job->pxl == NULL)
+         return;
+      job->pxlSize = imageSize;
+   }
+   else if(job->pxlSize < imageSize) {
+      return;
+   }
+
+   /* Renderer leaves row padding alone, so give it a defined value here */
+   if(enc->rowPadBytes > 0)
+      memset(job->pxl, 0xff, imageSize);
+
+   job->passFail = RenderSymbolBuffer(enc, &output, sizeIdx, job->pxl,
+         job->width, job->height, job->rowSizeBytes);
+}
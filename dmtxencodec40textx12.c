@@ -20,8 +20,49 @@
 #undef CHKPASS
 #define CHKPASS { if(passFail == DmtxFail) { StreamMarkFatal(stream, DmtxErrorUnknown); return; } }
 
-#undef RETURN_IF_FAIL
-#define RETURN_IF_FAIL { if(*passFail == DmtxFail) return; }
+/*
+ * Each C40/Text/X12 table entry describes one ASCII input value. The top 2
+ * bits hold the shift needed to reach the value (0 for the basic set,
+ * otherwise the shift value plus one) and the low 6 bits hold the value
+ * itself. Extended ASCII is handled as an Upper Shift prefix followed by the
+ * entry for (inputValue - 128).
+ */
+#define DmtxCTXUnsupported          0xff
+#define CTXEntryShift(e)            ((e) >> 6)
+#define CTXEntryValue(e)            ((e) & 0x3f)
+
+/* C40 value for ASCII 0-127 (see CTXEntryShift and CTXEntryValue) */
+static const DmtxByte ctxValueC40[] =
+   {  64,  65,  66,  67,  68,  69,  70,  71,  72,  73,  74,  75,  76,  77,  78,  79,
+      80,  81,  82,  83,  84,  85,  86,  87,  88,  89,  90,  91,  92,  93,  94,  95,
+       3, 128, 129, 130, 131, 132, 133, 134, 135, 136, 137, 138, 139, 140, 141, 142,
+       4,   5,   6,   7,   8,   9,  10,  11,  12,  13, 143, 144, 145, 146, 147, 148,
+     149,  14,  15,  16,  17,  18,  19,  20,  21,  22,  23,  24,  25,  26,  27,  28,
+      29,  30,  31,  32,  33,  34,  35,  36,  37,  38,  39, 150, 151, 152, 153, 154,
+     192, 193, 194, 195, 196, 197, 198, 199, 200, 201, 202, 203, 204, 205, 206, 207,
+     208, 209, 210, 211, 212, 213, 214, 215, 216, 217, 218, 219, 220, 221, 222, 223 };
+
+/* Text value for ASCII 0-127 */
+static const DmtxByte ctxValueText[] =
+   {  64,  65,  66,  67,  68,  69,  70,  71,  72,  73,  74,  75,  76,  77,  78,  79,
+      80,  81,  82,  83,  84,  85,  86,  87,  88,  89,  90,  91,  92,  93,  94,  95,
+       3, 128, 129, 130, 131, 132, 133, 134, 135, 136, 137, 138, 139, 140, 141, 142,
+       4,   5,   6,   7,   8,   9,  10,  11,  12,  13, 143, 144, 145, 146, 147, 148,
+     149, 193, 194, 195, 196, 197, 198, 199, 200, 201, 202, 203, 204, 205, 206, 207,
+     208, 209, 210, 211, 212, 213, 214, 215, 216, 217, 218, 150, 151, 152, 153, 154,
+     192,  14,  15,  16,  17,  18,  19,  20,  21,  22,  23,  24,  25,  26,  27,  28,
+      29,  30,  31,  32,  33,  34,  35,  36,  37,  38,  39, 219, 220, 221, 222, 223 };
+
+/* X12 value for ASCII 0-127 (DmtxCTXUnsupported if none) */
+static const DmtxByte ctxValueX12[] =
+   { 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,   0, 255, 255,
+     255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+       3, 255, 255, 255, 255, 255, 255, 255, 255, 255,   1, 255, 255, 255, 255, 255,
+       4,   5,   6,   7,   8,   9,  10,  11,  12,  13, 255, 255, 255, 255,   2, 255,
+     255,  14,  15,  16,  17,  18,  19,  20,  21,  22,  23,  24,  25,  26,  27,  28,
+      29,  30,  31,  32,  33,  34,  35,  36,  37,  38,  39, 255, 255, 255, 255, 255,
+     255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+     255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255 };
 
 /**
  *
@@ -35,6 +76,14 @@ EncodeNextChunkCTX(DmtxEncodeStream *stream, int sizeIdxRequest)
    DmtxByte valueListStorage[6];
    DmtxByteList valueList = dmtxByteListBuild(valueListStorage, sizeof(valueListStorage));
 
+   /* Fast path: next 3 inputs expand to exactly 3 basic set values */
+   if(ExpandCTXBasicTriplet(stream, &valueList) == DmtxTrue)
+   {
+      stream->inputNext += 3;
+      AppendValuesCTX(stream, &valueList);
+      return;
+   }
+
    while(StreamInputHasNext(stream))
    {
       inputValue = StreamInputAdvanceNext(stream); CHKERR;
@@ -86,7 +135,7 @@ static void
 AppendValuesCTX(DmtxEncodeStream *stream, DmtxByteList *valueList)
 {
    int pairValue;
-   DmtxByte cw0, cw1;
+   DmtxByte *cw;
 
    if(!IsCTX(stream->currentScheme))
    {
@@ -102,12 +151,11 @@ AppendValuesCTX(DmtxEncodeStream *stream, DmtxByteList *valueList)
 
    /* Build codewords from computed value */
    pairValue = (1600 * valueList->b[0]) + (40 * valueList->b[1]) + valueList->b[2] + 1;
-   cw0 = pairValue / 256;
-   cw1 = pairValue % 256;
 
    /* Append 2 codewords */
-   StreamOutputChainAppend(stream, cw0); CHKERR;
-   StreamOutputChainAppend(stream, cw1); CHKERR;
+   cw = StreamOutputChainReserve(stream, 2); CHKERR;
+   cw[0] = pairValue / 256;
+   cw[1] = pairValue % 256;
 
    /* Update count for 3 encoded values */
    stream->outputChainValueCount += 3;
@@ -241,8 +289,7 @@ CompletePartialC40Text(DmtxEncodeStream *stream, DmtxByteList *valueList, int si
       inputValue = StreamInputPeekNext(stream); CHKERR;
 
       /* Test-encode most recently consumed input value to C40/Text/X12 */
-      PushCTXValues(&outputTmp, inputValue, stream->currentScheme, &passFail);
-      if(valueList->length == 2 && outputTmp.length == 1)
+      if(valueList->length == 2 && GetCTXValueCount(inputValue, stream->currentScheme) == 1)
          StreamInputAdvancePrev(stream); CHKERR;
 
       /* Re-use outputTmp to hold ASCII representation of 1-2 input values */
@@ -352,57 +399,53 @@ CompletePartialX12(DmtxEncodeStream *stream, DmtxByteList *valueList, int sizeId
 static DmtxBoolean
 PartialX12ChunkRemains(DmtxEncodeStream *stream)
 {
-   DmtxEncodeStream streamTmp;
-   DmtxByte inputValue;
-   DmtxByte valueListStorage[6];
-   DmtxByteList valueList = dmtxByteListBuild(valueListStorage, sizeof(valueListStorage));
-   DmtxPassFail passFail;
+   int i, valueCount, inputValueCount;
 
-   /* Create temporary copy of stream to track test input progress */
-   streamTmp = *stream;
-   streamTmp.currentScheme = DmtxSchemeX12;
-   streamTmp.outputChainValueCount = 0;
-   streamTmp.outputChainWordCount = 0;
-   streamTmp.reason = NULL;
-   streamTmp.sizeIdx = DmtxUndefined;
-   streamTmp.status = DmtxStatusEncoding;
-   streamTmp.output = NULL;
-
-   while(StreamInputHasNext(&streamTmp))
+   /* X12 values are never shifted, so each input value is one X12 value */
+   valueCount = 0;
+   for(i = stream->inputNext; i < stream->input->length; i++)
    {
-      inputValue = StreamInputAdvanceNext(&streamTmp);
-      if(stream->status != DmtxStatusEncoding)
-      {
-         StreamMarkInvalid(stream, DmtxErrorUnknown);
-         return DmtxFalse;
-      }
-
-      /* Expand next input value into up to 4 CTX values and add to valueList */
-      PushCTXValues(&valueList, inputValue, streamTmp.currentScheme, &passFail);
-      if(passFail == DmtxFail)
+      inputValueCount = GetCTXValueCount(stream->input->b[i], DmtxSchemeX12);
+      if(inputValueCount == 0)
       {
          StreamMarkInvalid(stream, DmtxErrorUnknown);
          return DmtxFalse;
       }
 
       /* Not a final partial chunk */
-      if(valueList.length >= 3)
+      valueCount += inputValueCount;
+      if(valueCount >= 3)
          return DmtxFalse;
    }
 
-   return (valueList.length == 0) ? DmtxFalse : DmtxTrue;
+   return (valueCount == 0) ? DmtxFalse : DmtxTrue;
 }
 
 /**
- *
- *
+ * \brief  Expand input value into its C40/Text/X12 values
+ * \param  valueList Receives 1 to 4 values
+ * \param  inputValue
+ * \param  targetScheme
+ * \param  passFail Set to DmtxFail if value can't be represented in scheme
+ * \return void
  */
 static void
 PushCTXValues(DmtxByteList *valueList, DmtxByte inputValue, int targetScheme,
       DmtxPassFail *passFail)
 {
+   DmtxByte entry;
+   const DmtxByte *table;
+
    assert(valueList->length <= 2);
 
+   /* Room for the longest expansion (Upper Shift + shifted value) */
+   table = GetCTXTable(targetScheme);
+   if(table == NULL || valueList->capacity - valueList->length < 4)
+   {
+      *passFail = DmtxFail;
+      return;
+   }
+
    /* Handle extended ASCII with Upper Shift character */
    if(inputValue > 127)
    {
@@ -411,109 +454,129 @@ PushCTXValues(DmtxByteList *valueList, DmtxByte inputValue, int targetScheme,
          *passFail = DmtxFail;
          return;
       }
-      else
-      {
-         dmtxByteListPush(valueList, DmtxValueCTXShift2, passFail); RETURN_IF_FAIL;
-         dmtxByteListPush(valueList, 30, passFail); RETURN_IF_FAIL;
-         inputValue -= 128;
-      }
+
+      DMTX_BYTELIST_PUSH(valueList, DmtxValueCTXShift2);
+      DMTX_BYTELIST_PUSH(valueList, 30);
+      inputValue -= 128;
    }
 
-   /* Handle all other characters according to encodation scheme */
-   if(targetScheme == DmtxSchemeX12)
+   entry = table[inputValue];
+   if(entry == DmtxCTXUnsupported)
    {
-      if(inputValue == 13)
-      {
-         dmtxByteListPush(valueList, 0, passFail); RETURN_IF_FAIL;
-      }
-      else if(inputValue == 42)
-      {
-         dmtxByteListPush(valueList, 1, passFail); RETURN_IF_FAIL;
-      }
-      else if(inputValue == 62)
-      {
-         dmtxByteListPush(valueList, 2, passFail); RETURN_IF_FAIL;
-      }
-      else if(inputValue == 32)
-      {
-         dmtxByteListPush(valueList, 3, passFail); RETURN_IF_FAIL;
-      }
-      else if(inputValue >= 48 && inputValue <= 57)
-      {
-         dmtxByteListPush(valueList, inputValue - 44, passFail); RETURN_IF_FAIL;
-      }
-      else if(inputValue >= 65 && inputValue <= 90)
-      {
-         dmtxByteListPush(valueList, inputValue - 51, passFail); RETURN_IF_FAIL;
-      }
-      else
-      {
-         *passFail = DmtxFail;
-         return;
-      }
+      *passFail = DmtxFail;
+      return;
    }
-   else
+
+   if(CTXEntryShift(entry) != DmtxC40TextBasicSet)
+      DMTX_BYTELIST_PUSH(valueList, CTXEntryShift(entry) - 1);
+   DMTX_BYTELIST_PUSH(valueList, CTXEntryValue(entry));
+
+   *passFail = DmtxPass;
+}
+
+/**
+ * \brief  Count C40/Text/X12 values needed to represent input value
+ * \param  inputValue
+ * \param  targetScheme
+ * \return Value count (1 to 4), or 0 if value can't be represented in scheme
+ */
+static int
+GetCTXValueCount(DmtxByte inputValue, int targetScheme)
+{
+   int count;
+   DmtxByte entry;
+   const DmtxByte *table;
+
+   table = GetCTXTable(targetScheme);
+   if(table == NULL)
+      return 0;
+
+   count = 0;
+   if(inputValue > 127)
    {
-      /* targetScheme is C40 or Text */
-      if(inputValue <= 31)
-      {
-         dmtxByteListPush(valueList, DmtxValueCTXShift1, passFail); RETURN_IF_FAIL;
-         dmtxByteListPush(valueList, inputValue, passFail); RETURN_IF_FAIL;
-      }
-      else if(inputValue == 32)
-      {
-         dmtxByteListPush(valueList, 3, passFail); RETURN_IF_FAIL;
-      }
-      else if(inputValue <= 47)
-      {
-         dmtxByteListPush(valueList, DmtxValueCTXShift2, passFail); RETURN_IF_FAIL;
-         dmtxByteListPush(valueList, inputValue - 33, passFail); RETURN_IF_FAIL;
-      }
-      else if(inputValue <= 57)
-      {
-         dmtxByteListPush(valueList, inputValue - 44, passFail); RETURN_IF_FAIL;
-      }
-      else if(inputValue <= 64)
-      {
-         dmtxByteListPush(valueList, DmtxValueCTXShift2, passFail); RETURN_IF_FAIL;
-         dmtxByteListPush(valueList, inputValue - 43, passFail); RETURN_IF_FAIL;
-      }
-      else if(inputValue <= 90 && targetScheme == DmtxSchemeC40)
-      {
-         dmtxByteListPush(valueList, inputValue - 51, passFail); RETURN_IF_FAIL;
-      }
-      else if(inputValue <= 90 && targetScheme == DmtxSchemeText)
-      {
-         dmtxByteListPush(valueList, DmtxValueCTXShift3, passFail); RETURN_IF_FAIL;
-         dmtxByteListPush(valueList, inputValue - 64, passFail); RETURN_IF_FAIL;
-      }
-      else if(inputValue <= 95)
-      {
-         dmtxByteListPush(valueList, DmtxValueCTXShift2, passFail); RETURN_IF_FAIL;
-         dmtxByteListPush(valueList, inputValue - 69, passFail); RETURN_IF_FAIL;
-      }
-      else if(inputValue == 96 && targetScheme == DmtxSchemeText)
-      {
-         dmtxByteListPush(valueList, DmtxValueCTXShift3, passFail); RETURN_IF_FAIL;
-         dmtxByteListPush(valueList, 0, passFail); RETURN_IF_FAIL;
-      }
-      else if(inputValue <= 122 && targetScheme == DmtxSchemeText)
-      {
-         dmtxByteListPush(valueList, inputValue - 83, passFail); RETURN_IF_FAIL;
-      }
-      else if(inputValue <= 127)
-      {
-         dmtxByteListPush(valueList, DmtxValueCTXShift3, passFail); RETURN_IF_FAIL;
-         dmtxByteListPush(valueList, inputValue - 96, passFail); RETURN_IF_FAIL;
-      }
-      else
-      {
-         *passFail = DmtxFail;
-         return;
-      }
+      if(targetScheme == DmtxSchemeX12)
+         return 0;
+
+      count = 2;
+      inputValue -= 128;
    }
 
-   *passFail = DmtxPass;
+   entry = table[inputValue];
+   if(entry == DmtxCTXUnsupported)
+      return 0;
+
+   return count + ((CTXEntryShift(entry) == DmtxC40TextBasicSet) ? 1 : 2);
+}
+
+/**
+ * \brief  Expand next 3 inputs if each is a single basic set value
+ * \param  stream
+ * \param  valueList Receives 3 values on success
+ * \return DmtxTrue if 3 values were expanded, otherwise DmtxFalse
+ *
+ * Covers the common case of uppercase (C40), lowercase (Text), and digit runs
+ * without pushing each value through the general shift handling. Input
+ * progress is left for the caller to register.
+ */
+static DmtxBoolean
+ExpandCTXBasicTriplet(DmtxEncodeStream *stream, DmtxByteList *valueList)
+{
+   int i;
+   DmtxByte inputValue, entry;
+   const DmtxByte *table;
+
+   if(stream->inputNext + 3 > stream->input->length || valueList->capacity < 3)
+      return DmtxFalse;
+
+   table = GetCTXTable(stream->currentScheme);
+   if(table == NULL)
+      return DmtxFalse;
+
+   for(i = 0; i < 3; i++)
+   {
+      inputValue = stream->input->b[stream->inputNext + i];
+      if(inputValue > 127)
+         return DmtxFalse;
+
+      /* Basic set entries are below 64, which also excludes unsupported */
+      entry = table[inputValue];
+      if(CTXEntryShift(entry) != DmtxC40TextBasicSet)
+         return DmtxFalse;
+
+      valueList->b[i] = CTXEntryValue(entry);
+   }
+   valueList->length = 3;
+
+   return DmtxTrue;
+}
+
+/**
+ * \brief  Get value table for C40, Text, or X12
+ * \param  scheme
+ * \return Table of 128 entries, or NULL if scheme is not C40/Text/X12
+ */
+static const DmtxByte *
+GetCTXTable(int scheme)
+{
+   const DmtxByte *table;
+
+   switch(scheme)
+   {
+      case DmtxSchemeC40:
+         table = ctxValueC40;
+         break;
+      case DmtxSchemeText:
+         table = ctxValueText;
+         break;
+      case DmtxSchemeX12:
+         table = ctxValueX12;
+         break;
+      default:
+         table = NULL;
+         break;
+   }
+
+   return table;
 }
 
 /**
@@ -546,16 +609,13 @@ ShiftValueListBy3(DmtxByteList *list, DmtxPassFail *passFail)
    for(i = 0; i < list->length - 3; i++)
       list->b[i] = list->b[i+3];
 
-   /* Shorten list by 3 (or less) */
-   for(i = 0; i < 3; i++)
+   if(list->length == 0)
    {
-      dmtxByteListPop(list, passFail);
-      if(*passFail == DmtxFail)
-         return;
-
-      if(list->length == 0)
-         break;
+      *passFail = DmtxFail;
+      return;
    }
 
+   /* Shorten list by 3 (or less) */
+   list->length = max(list->length - 3, 0);
    *passFail = DmtxPass;
 }
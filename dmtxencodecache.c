@@ -0,0 +1,718 @@
+/**
+ * libdmtx - Data Matrix Encoding/Decoding Library
+ * Copyright 2011 Mike Laughton. All rights reserved.
+ *
+ * See LICENSE file in the main project directory for full
+ * terms of use and distribution.
+ *
+ * Contact: Mike Laughton <mike@dragonflylogic.com>
+ *
+ * \file dmtxencodecache.c
+ * \brief Reusing encoded symbols for repeated payloads
+ */
+
+#if defined(HAVE_PTHREAD_H)
+#include <pthread.h>
+#endif
+
+/**
+ * Bounded table of recently encoded symbols. Entries live in a fixed array,
+ * chained into hash buckets by next and into a most-recently-used list by
+ * newer and older, so a full cache recycles its oldest entry in place.
+ */
+struct DmtxEncodeCache_struct {
+   DmtxEncodeCacheEntry *entries;
+   int            *buckets;      /* First entry of each bucket, or DmtxUndefined */
+   int             bucketMask;   /* Bucket count - 1 (power of 2) */
+   int             maxEntries;
+   int             newest;       /* Most recently used entry */
+   int             oldest;       /* Least recently used entry, next to be evicted */
+   DmtxBoolean     keepImages;
+   DmtxEncodeCacheStats stats;
+   DmtxAllocator   allocator;    /* Allocator given at creation, or global one */
+#if defined(HAVE_PTHREAD_H)
+   pthread_mutex_t mutex;
+#endif
+};
+
+/**
+ * \brief  Create a cache of encoded symbols
+ *
+ * Symbols are keyed by payload, scheme, and size request. Each entry keeps
+ * the symbol's codewords and packed module bitmap, and with keepImages also
+ * the most recent image rendered from it. Once maxEntries symbols are held,
+ * the least recently used one is dropped to make room. When built with
+ * pthread support a cache can be shared by any number of threads; otherwise
+ * its lock does nothing and the cache must stay on one thread.
+ *
+ * \param  maxEntries Number of symbols held
+ * \param  keepImages DmtxTrue to also keep rendered images
+ * \return Initialized DmtxEncodeCache struct, or NULL on error
+ */
+DmtxEncodeCache *
+dmtxEncodeCacheCreate(int maxEntries, DmtxBoolean keepImages)
+{
+   return dmtxEncodeCacheCreateWithAllocator(maxEntries, keepImages, NULL);
+}
+
+/**
+ * \brief  Create a cache of encoded symbols that allocates through its own
+ *         allocator
+ * \param  maxEntries Number of symbols held
+ * \param  keepImages DmtxTrue to also keep rendered images
+ * \param  allocator Used for the cache and every symbol it holds, or NULL
+ *         for the global allocator
+ * \return Initialized DmtxEncodeCache struct, or NULL on error
+ */
+DmtxEncodeCache *
+dmtxEncodeCacheCreateWithAllocator(int maxEntries, DmtxBoolean keepImages,
+      const DmtxAllocator *allocator)
+{
+   int i, bucketCount;
+   DmtxEncodeCache *cache;
+
+   if(maxEntries < 1)
+      return NULL;
+
+   allocator = AllocSelect(allocator);
+   cache = (DmtxEncodeCache *)AllocCalloc(allocator, 1, sizeof(DmtxEncodeCache));
+   if(cache == NULL)
+      return NULL;
+
+   cache->allocator = *allocator;
+
+   /* Keep buckets at most half full */
+   for(bucketCount = 2; bucketCount < 2 * maxEntries; bucketCount *= 2)
+      ;
+
+   cache->entries = (DmtxEncodeCacheEntry *)AllocCalloc(allocator, maxEntries,
+         sizeof(DmtxEncodeCacheEntry));
+   cache->buckets = (int *)AllocMalloc(allocator, bucketCount * sizeof(int));
+   if(cache->entries == NULL || cache->buckets == NULL) {
+      AllocFree(allocator, cache->entries);
+      AllocFree(allocator, cache->buckets);
+      AllocFree(allocator, cache);
+      return NULL;
+   }
+
+   for(i = 0; i < bucketCount; i++)
+      cache->buckets[i] = DmtxUndefined;
+
+   cache->bucketMask = bucketCount - 1;
+   cache->maxEntries = maxEntries;
+   cache->newest = cache->oldest = DmtxUndefined;
+   cache->keepImages = keepImages;
+
+#if defined(HAVE_PTHREAD_H)
+   pthread_mutex_init(&cache->mutex, NULL);
+#endif
+
+   return cache;
+}
+
+/**
+ * \brief  Free cache and every symbol it holds
+ * \param  cache
+ * \return DmtxPass | DmtxFail
+ */
+DmtxPassFail
+dmtxEncodeCacheDestroy(DmtxEncodeCache **cache)
+{
+   int i;
+   DmtxAllocator allocator;
+
+   if(cache == NULL || *cache == NULL)
+      return DmtxFail;
+
+   allocator = (*cache)->allocator;
+
+   for(i = 0; i < (*cache)->stats.entryCount; i++) {
+      AllocFree(&allocator, (*cache)->entries[i].storage);
+      AllocFree(&allocator, (*cache)->entries[i].image);
+   }
+
+#if defined(HAVE_PTHREAD_H)
+   pthread_mutex_destroy(&(*cache)->mutex);
+#endif
+
+   AllocFree(&allocator, (*cache)->entries);
+   AllocFree(&allocator, (*cache)->buckets);
+   AllocFree(&allocator, *cache);
+
+   *cache = NULL;
+
+   return DmtxPass;
+}
+
+/**
+ * \brief  Report cache usage since creation
+ * \param  cache
+ * \param  stats Receives counters and current entry count
+ * \return DmtxPass | DmtxFail
+ */
+DmtxPassFail
+dmtxEncodeCacheGetStats(DmtxEncodeCache *cache, DmtxEncodeCacheStats *stats)
+{
+   if(cache == NULL || stats == NULL)
+      return DmtxFail;
+
+   CacheLock(cache);
+   *stats = cache->stats;
+   CacheUnlock(cache);
+
+   return DmtxPass;
+}
+
+/**
+ * \brief  Convert message into a packed module bitmap, using cache when possible
+ *
+ * Same as dmtxEncodeModules(), except a payload already in the cache skips
+ * encodation, error correction, and module placement. enc is not modified.
+ *
+ * \param  cache
+ * \param  enc
+ * \param  inputSize
+ * \param  inputString
+ * \param  modules Destination bitmap, or NULL
+ * \param  modulesSize Size of destination bitmap in bytes
+ * \param  rows Receives symbol rows
+ * \param  cols Receives symbol columns
+ * \return DmtxPass | DmtxFail
+ */
+DmtxPassFail
+dmtxEncodeCacheModules(DmtxEncodeCache *cache, DmtxEncode *enc, int inputSize,
+      unsigned char *inputString, unsigned char *modules, int modulesSize,
+      int *rows, int *cols)
+{
+   int modulesBytes;
+   DmtxEncodeCacheSymbol symbol;
+
+   if(cache == NULL || enc == NULL || CacheFetch(cache, enc, inputSize, inputString,
+         &symbol) == DmtxFail)
+      return DmtxFail;
+
+   *rows = symbol.rows;
+   *cols = symbol.cols;
+
+   if(modules == NULL)
+      return DmtxPass;
+
+   modulesBytes = symbol.rows * ((symbol.cols + 7)/8);
+   if(modulesSize < modulesBytes)
+      return DmtxFail;
+
+   memcpy(modules, symbol.modules, modulesBytes);
+
+   return DmtxPass;
+}
+
+/**
+ * \brief  Render message into caller's buffer, using cache when possible
+ *
+ * Geometry is reported as with dmtxEncodeMeasure() and the symbol is drawn
+ * as with dmtxEncodeDataMatrixBuffer() at the reported row stride, without
+ * touching row padding. A cached payload skips encodation, error correction,
+ * and module placement, and if the cache keeps images and this payload was
+ * last rendered with the same module size, margin size, pixel packing, and
+ * image flip, its pixels are simply copied. Passing NULL for pxl only reports
+ * the geometry. enc is not modified.
+ *
+ * \param  cache
+ * \param  enc
+ * \param  inputSize
+ * \param  inputString
+ * \param  pxl Destination pixels, or NULL
+ * \param  pxlSize Size of destination in bytes
+ * \param  width Receives image width
+ * \param  height Receives image height
+ * \param  rowSizeBytes Receives distance between starts of rows in bytes
+ * \return DmtxPass | DmtxFail (including pxlSize too small)
+ */
+DmtxPassFail
+dmtxEncodeCacheImage(DmtxEncodeCache *cache, DmtxEncode *enc, int inputSize,
+      unsigned char *inputString, unsigned char *pxl, int pxlSize, int *width,
+      int *height, int *rowSizeBytes)
+{
+   int bitsPerPixel;
+   DmtxEncodeCacheSymbol symbol;
+
+   if(cache == NULL || enc == NULL)
+      return DmtxFail;
+
+   bitsPerPixel = GetBitsPerPixel(enc->pixelPacking);
+   if(bitsPerPixel == DmtxUndefined)
+      return DmtxFail;
+
+   if(CacheFetch(cache, enc, inputSize, inputString, &symbol) == DmtxFail)
+      return DmtxFail;
+
+   *width = 2 * enc->marginSize + (symbol.cols * enc->moduleSize);
+   *height = 2 * enc->marginSize + (symbol.rows * enc->moduleSize);
+   *rowSizeBytes = (*width * bitsPerPixel + 7)/8 + enc->rowPadBytes;
+
+   if(pxl == NULL)
+      return DmtxPass;
+
+   if(pxlSize < *rowSizeBytes * *height)
+      return DmtxFail;
+
+   if(cache->keepImages == DmtxTrue && CacheCopyImage(cache, enc, inputSize,
+         inputString, pxl, *height, *rowSizeBytes) == DmtxPass)
+      return DmtxPass;
+
+   if(CacheRender(enc, &symbol, pxl, *width, *height, *rowSizeBytes) == DmtxFail)
+      return DmtxFail;
+
+   if(cache->keepImages == DmtxTrue)
+      CacheStoreImage(cache, enc, inputSize, inputString, pxl, *height, *rowSizeBytes,
+            (*width * bitsPerPixel + 7)/8);
+
+   return DmtxPass;
+}
+
+/**
+ * \brief  Copy symbol for payload out of cache, encoding and adding it if missing
+ * \param  cache
+ * \param  enc
+ * \param  inputSize
+ * \param  inputString
+ * \param  symbol Receives codewords and module bitmap
+ * \return DmtxPass | DmtxFail
+ */
+static DmtxPassFail
+CacheFetch(DmtxEncodeCache *cache, DmtxEncode *enc, int inputSize,
+      unsigned char *inputString, DmtxEncodeCacheSymbol *symbol)
+{
+   int entryIdx;
+   unsigned long hash;
+   DmtxEncodeCacheEntry *entry;
+
+   if(inputSize < 0 || (inputString == NULL && inputSize > 0))
+      return DmtxFail;
+
+   hash = CacheHash(enc, inputSize, inputString);
+
+   CacheLock(cache);
+   entryIdx = CacheFind(cache, hash, enc, inputSize, inputString);
+   if(entryIdx != DmtxUndefined) {
+      entry = &(cache->entries[entryIdx]);
+      symbol->sizeIdx = entry->sizeIdx;
+      symbol->rows = entry->rows;
+      symbol->cols = entry->cols;
+      symbol->codeSize = entry->codeSize;
+      memcpy(symbol->code, entry->storage + inputSize, entry->codeSize);
+      memcpy(symbol->modules, entry->storage + inputSize + entry->codeSize,
+            entry->rows * ((entry->cols + 7)/8));
+      CacheTouch(cache, entryIdx);
+      cache->stats.hits++;
+      CacheUnlock(cache);
+      return DmtxPass;
+   }
+   cache->stats.misses++;
+   CacheUnlock(cache);
+
+   /* Encode without holding the lock so other threads aren't held up */
+   if(CacheEncode(enc, inputSize, inputString, symbol) == DmtxFail)
+      return DmtxFail;
+
+   CacheLock(cache);
+   if(CacheFind(cache, hash, enc, inputSize, inputString) == DmtxUndefined)
+      CacheInsert(cache, hash, enc, inputSize, inputString, symbol);
+   CacheUnlock(cache);
+
+   return DmtxPass;
+}
+
+/**
+ * \brief  Encode payload into codewords and module bitmap
+ * \param  enc Settings (not modified)
+ * \param  inputSize
+ * \param  inputString
+ * \param  symbol
+ * \return DmtxPass | DmtxFail
+ */
+static DmtxPassFail
+CacheEncode(DmtxEncode *enc, int inputSize, unsigned char *inputString,
+      DmtxEncodeCacheSymbol *symbol)
+{
+   int sizeIdx;
+   DmtxEncode encCopy;
+   DmtxMessage message;
+   unsigned char arrayStorage[DmtxMaxMappingArea];
+   DmtxByte outputStorage[4096];
+   DmtxByteList output = dmtxByteListBuild(outputStorage, sizeof(outputStorage));
+
+   /* Work on a copy since encoding records the symbol size in enc->region.
+      The copy keeps its own allocator, so give it the one enc uses. */
+   encCopy.allocator = enc->allocator;
+   EncodeCopySettings(&encCopy, enc);
+
+   sizeIdx = EncodeSymbolCodewords(&encCopy, inputSize, inputString, &output,
+         &(encCopy.region));
+   if(sizeIdx == DmtxUndefined)
+      return DmtxFail;
+
+   MessageInit(&message, sizeIdx, arrayStorage, symbol->code);
+   PlaceSymbolModules(&message, &output, sizeIdx);
+   BuildModuleBitmap(&message, sizeIdx, symbol->modules);
+
+   symbol->sizeIdx = sizeIdx;
+   symbol->rows = encCopy.region.symbolRows;
+   symbol->cols = encCopy.region.symbolCols;
+   symbol->codeSize = (int)message.codeSize;
+
+   return DmtxPass;
+}
+
+/**
+ * \brief  Draw symbol into caller's pixels
+ * \param  enc
+ * \param  symbol
+ * \param  pxl
+ * \param  width
+ * \param  height
+ * \param  rowSizeBytes
+ * \return DmtxPass | DmtxFail
+ */
+static DmtxPassFail
+CacheRender(DmtxEncode *enc, DmtxEncodeCacheSymbol *symbol, unsigned char *pxl,
+      int width, int height, int rowSizeBytes)
+{
+   DmtxImage image;
+   DmtxMessage message;
+   unsigned char arrayStorage[DmtxMaxMappingArea];
+   unsigned char codeStorage[DmtxMaxCodeWords];
+
+   if(ImageInit(&image, pxl, width, height, enc->pixelPacking) == DmtxFail ||
+         rowSizeBytes < image.rowSizeBytes)
+      return DmtxFail;
+
+   dmtxImageSetProp(&image, DmtxPropImageFlip, enc->imageFlip);
+   dmtxImageSetProp(&image, DmtxPropRowPadBytes, rowSizeBytes - image.rowSizeBytes);
+
+   /* Codewords already include error correction, so only placement remains */
+   MessageInit(&message, symbol->sizeIdx, arrayStorage, codeStorage);
+   memcpy(message.code, symbol->code, symbol->codeSize);
+   ModulePlacementEcc200(message.array, message.code, symbol->sizeIdx, DmtxModuleOnRGB);
+
+   return RenderPattern(&image, &message, symbol->sizeIdx, enc->moduleSize, enc->marginSize);
+}
+
+/**
+ * \brief  Copy stored image of payload into caller's pixels if it matches enc
+ * \param  cache
+ * \param  enc
+ * \param  inputSize
+ * \param  inputString
+ * \param  pxl
+ * \param  height
+ * \param  rowSizeBytes Caller's row stride
+ * \return DmtxPass | DmtxFail (no matching image)
+ */
+static DmtxPassFail
+CacheCopyImage(DmtxEncodeCache *cache, DmtxEncode *enc, int inputSize,
+      unsigned char *inputString, unsigned char *pxl, int height, int rowSizeBytes)
+{
+   int row, entryIdx, imageRowBytes;
+   DmtxPassFail passFail;
+   DmtxEncodeCacheEntry *entry;
+
+   passFail = DmtxFail;
+
+   CacheLock(cache);
+   entryIdx = CacheFind(cache, CacheHash(enc, inputSize, inputString), enc,
+         inputSize, inputString);
+   if(entryIdx != DmtxUndefined) {
+      entry = &(cache->entries[entryIdx]);
+      if(entry->imageSize > 0 && CacheImageMatches(entry, enc) == DmtxTrue) {
+         imageRowBytes = entry->imageSize / height;
+         for(row = 0; row < height; row++)
+            memcpy(pxl + row * rowSizeBytes, entry->image + row * imageRowBytes, imageRowBytes);
+         cache->stats.imageHits++;
+         passFail = DmtxPass;
+      }
+   }
+   CacheUnlock(cache);
+
+   return passFail;
+}
+
+/**
+ * \brief  Keep a copy of freshly rendered pixels with the payload's entry
+ * \param  cache
+ * \param  enc
+ * \param  inputSize
+ * \param  inputString
+ * \param  pxl
+ * \param  height
+ * \param  rowSizeBytes Caller's row stride
+ * \param  imageRowBytes Row size without padding
+ * \return void
+ */
+static void
+CacheStoreImage(DmtxEncodeCache *cache, DmtxEncode *enc, int inputSize,
+      unsigned char *inputString, unsigned char *pxl, int height, int rowSizeBytes,
+      int imageRowBytes)
+{
+   int row, entryIdx, imageSize;
+   unsigned char *image;
+   DmtxEncodeCacheEntry *entry;
+
+   imageSize = imageRowBytes * height;
+
+   CacheLock(cache);
+   entryIdx = CacheFind(cache, CacheHash(enc, inputSize, inputString), enc,
+         inputSize, inputString);
+   if(entryIdx != DmtxUndefined) {
+      entry = &(cache->entries[entryIdx]);
+      image = entry->image;
+      if(entry->imageCapacity < imageSize) {
+         image = (unsigned char *)AllocRealloc(&(cache->allocator), entry->image, imageSize);
+         if(image != NULL) {
+            entry->image = image;
+            entry->imageCapacity = imageSize;
+         }
+      }
+
+      if(image != NULL) {
+         for(row = 0; row < height; row++)
+            memcpy(image + row * imageRowBytes, pxl + row * rowSizeBytes, imageRowBytes);
+         entry->imageSize = imageSize;
+         entry->moduleSize = enc->moduleSize;
+         entry->marginSize = enc->marginSize;
+         entry->pixelPacking = enc->pixelPacking;
+         entry->imageFlip = enc->imageFlip;
+      }
+   }
+   CacheUnlock(cache);
+}
+
+/**
+ * \brief  Test whether entry's stored image was rendered with settings of enc
+ * \param  entry
+ * \param  enc
+ * \return DmtxTrue | DmtxFalse
+ */
+static DmtxBoolean
+CacheImageMatches(DmtxEncodeCacheEntry *entry, DmtxEncode *enc)
+{
+   if(entry->moduleSize != enc->moduleSize || entry->marginSize != enc->marginSize ||
+         entry->pixelPacking != enc->pixelPacking || entry->imageFlip != enc->imageFlip)
+      return DmtxFalse;
+
+   return DmtxTrue;
+}
+
+/**
+ * \brief  Find entry for payload (caller holds lock)
+ * \param  cache
+ * \param  hash Result of CacheHash()
+ * \param  enc
+ * \param  inputSize
+ * \param  inputString
+ * \return Entry index, or DmtxUndefined
+ */
+static int
+CacheFind(DmtxEncodeCache *cache, unsigned long hash, DmtxEncode *enc,
+      int inputSize, unsigned char *inputString)
+{
+   int entryIdx;
+   DmtxEncodeCacheEntry *entry;
+
+   for(entryIdx = cache->buckets[hash & cache->bucketMask]; entryIdx != DmtxUndefined;
+         entryIdx = entry->next) {
+      entry = &(cache->entries[entryIdx]);
+      if(entry->hash == hash && entry->scheme == enc->scheme &&
+            entry->sizeIdxRequest == enc->sizeIdxRequest &&
+            entry->inputSize == inputSize &&
+            (inputSize == 0 || memcmp(entry->storage, inputString, inputSize) == 0))
+         return entryIdx;
+   }
+
+   return DmtxUndefined;
+}
+
+/**
+ * \brief  Add symbol for payload, evicting least recently used entry if full
+ *         (caller holds lock)
+ * \param  cache
+ * \param  hash
+ * \param  enc
+ * \param  inputSize
+ * \param  inputString
+ * \param  symbol
+ * \return void
+ */
+static void
+CacheInsert(DmtxEncodeCache *cache, unsigned long hash, DmtxEncode *enc,
+      int inputSize, unsigned char *inputString, DmtxEncodeCacheSymbol *symbol)
+{
+   int entryIdx, storageSize, modulesBytes;
+   int *link;
+   unsigned char *storage;
+   DmtxEncodeCacheEntry *entry;
+
+   entryIdx = (cache->stats.entryCount < cache->maxEntries) ?
+         cache->stats.entryCount : cache->oldest;
+   entry = &(cache->entries[entryIdx]);
+
+   modulesBytes = symbol->rows * ((symbol->cols + 7)/8);
+   storageSize = inputSize + symbol->codeSize + modulesBytes;
+
+   /* Grow storage first so a failed allocation leaves the cache as it was */
+   if(entry->storageCapacity < storageSize) {
+      storage = (unsigned char *)AllocRealloc(&(cache->allocator), entry->storage, storageSize);
+      if(storage == NULL)
+         return;
+      entry->storage = storage;
+      entry->storageCapacity = storageSize;
+   }
+
+   if(entryIdx == cache->stats.entryCount) {
+      cache->stats.entryCount++;
+   }
+   else {
+      /* Recycle oldest entry, unlinking it from its bucket and the list */
+      for(link = &(cache->buckets[entry->hash & cache->bucketMask]); *link != entryIdx;
+            link = &(cache->entries[*link].next))
+         ;
+      *link = entry->next;
+
+      CacheUnlink(cache, entryIdx);
+      cache->stats.evictions++;
+   }
+
+   /* Storage holds payload, then codewords, then module bitmap */
+   memcpy(entry->storage, inputString, inputSize);
+   memcpy(entry->storage + inputSize, symbol->code, symbol->codeSize);
+   memcpy(entry->storage + inputSize + symbol->codeSize, symbol->modules, modulesBytes);
+
+   entry->hash = hash;
+   entry->scheme = enc->scheme;
+   entry->sizeIdxRequest = enc->sizeIdxRequest;
+   entry->inputSize = inputSize;
+   entry->sizeIdx = symbol->sizeIdx;
+   entry->rows = symbol->rows;
+   entry->cols = symbol->cols;
+   entry->codeSize = symbol->codeSize;
+   entry->imageSize = 0;
+
+   entry->next = cache->buckets[hash & cache->bucketMask];
+   cache->buckets[hash & cache->bucketMask] = entryIdx;
+
+   CacheLinkNewest(cache, entryIdx);
+}
+
+/**
+ * \brief  Mark entry as most recently used (caller holds lock)
+ * \param  cache
+ * \param  entryIdx
+ * \return void
+ */
+static void
+CacheTouch(DmtxEncodeCache *cache, int entryIdx)
+{
+   if(cache->newest == entryIdx)
+      return;
+
+   CacheUnlink(cache, entryIdx);
+   CacheLinkNewest(cache, entryIdx);
+}
+
+/**
+ * \brief  Remove entry from most-recently-used list (caller holds lock)
+ * \param  cache
+ * \param  entryIdx
+ * \return void
+ */
+static void
+CacheUnlink(DmtxEncodeCache *cache, int entryIdx)
+{
+   DmtxEncodeCacheEntry *entry;
+
+   entry = &(cache->entries[entryIdx]);
+
+   if(entry->newer != DmtxUndefined)
+      cache->entries[entry->newer].older = entry->older;
+   else
+      cache->newest = entry->older;
+
+   if(entry->older != DmtxUndefined)
+      cache->entries[entry->older].newer = entry->newer;
+   else
+      cache->oldest = entry->newer;
+
+   entry->newer = entry->older = DmtxUndefined;
+}
+
+/**
+ * \brief  Put unlinked entry at head of most-recently-used list (caller holds lock)
+ * \param  cache
+ * \param  entryIdx
+ * \return void
+ */
+static void
+CacheLinkNewest(DmtxEncodeCache *cache, int entryIdx)
+{
+   DmtxEncodeCacheEntry *entry;
+
+   entry = &(cache->entries[entryIdx]);
+   entry->newer = DmtxUndefined;
+   entry->older = cache->newest;
+
+   if(cache->newest != DmtxUndefined)
+      cache->entries[cache->newest].newer = entryIdx;
+   else
+      cache->oldest = entryIdx;
+
+   cache->newest = entryIdx;
+}
+
+/**
+ * \brief  Hash payload together with settings that affect encodation (FNV-1a)
+ * \param  enc
+ * \param  inputSize
+ * \param  inputString
+ * \return Hash value
+ */
+static unsigned long
+CacheHash(DmtxEncode *enc, int inputSize, unsigned char *inputString)
+{
+   int i;
+   unsigned long hash;
+
+   hash = 2166136261UL;
+   hash = ((hash ^ (unsigned long)(enc->scheme & 0xff)) * 16777619UL) & 0xffffffffUL;
+   hash = ((hash ^ (unsigned long)(enc->sizeIdxRequest & 0xff)) * 16777619UL) & 0xffffffffUL;
+
+   for(i = 0; i < inputSize; i++)
+      hash = ((hash ^ inputString[i]) * 16777619UL) & 0xffffffffUL;
+
+   return hash;
+}
+
+/**
+ * \brief  Acquire cache lock (no-op without thread support)
+ * \param  cache
+ * \return void
+ */
+static void
+CacheLock(DmtxEncodeCache *cache)
+{
+#if defined(HAVE_PTHREAD_H)
+   pthread_mutex_lock(&cache->mutex);
+#endif
+}
+
+/**
+ * \brief  Release cache lock (no-op without thread support)
+ * \param  cache
+ * \return void
+ */
+static void
+CacheUnlock(DmtxEncodeCache *cache)
+{
+#if defined(HAVE_PTHREAD_H)
+   pthread_mutex_unlock(&cache->mutex);
+#endif
+}
@@ -0,0 +1,282 @@
+/**
+ * libdmtx - Data Matrix Encoding/Decoding Library
+ * Copyright 2011 Mike Laughton. All rights reserved.
+ *
+ * See LICENSE file in the main project directory for full
+ * terms of use and distribution.
+ *
+ * Contact: Mike Laughton <mike@dragonflylogic.com>
+ *
+ * \file dmtxencodelookahead.c
+ * \brief Fast encodation using the look-ahead test from the specification
+ */
+
+/**
+ * The look-ahead test walks forward from the current input position keeping a
+ * running cost for each scheme, in 1/12 codeword units so that the 1/2, 2/3,
+ * and 3/4 codeword steps stay exact. Counts for schemes other than the
+ * current one start with the cost of latching into them.
+ */
+#define DmtxLookAheadUnit              12
+#define DmtxLookAheadMinInputs          4
+#define DmtxLookAheadNativeCTX          8 /* 2/3 codeword */
+
+/**
+ * \brief  Encode input by choosing each scheme with the look-ahead test
+ * \param  input
+ * \param  output
+ * \param  sizeIdxRequest
+ * \return Symbol size index, or DmtxUndefined if input does not fit
+ *
+ * Runs in a single pass over the input. The look-ahead test is repeated at
+ * every chunk boundary, but stops as soon as one scheme is clearly cheaper,
+ * which for typical input happens within a few values.
+ */
+static int
+EncodeAutoFast(DmtxByteList *input, DmtxByteList *output, int sizeIdxRequest)
+{
+   int scheme;
+   DmtxEncodeStream stream;
+
+   stream = StreamInit(input, output);
+
+   while(stream.status == DmtxStatusEncoding)
+   {
+      scheme = LookAheadScheme(input, stream.inputNext, stream.currentScheme);
+
+      /* Fall back to ASCII where next chunk cannot be encoded in chosen scheme */
+      if(LookAheadChunkFits(input, stream.inputNext, scheme) == DmtxFalse)
+         scheme = DmtxSchemeAscii;
+
+      EncodeNextChunk(&stream, scheme, DmtxEncodeNormal, sizeIdxRequest);
+   }
+
+   /* Look-ahead picked an end-of-symbol sequence the schemes can't finish */
+   if(stream.status == DmtxStatusInvalid)
+   {
+      dmtxByteListClear(output);
+      return EncodeSingleScheme(input, output, sizeIdxRequest, DmtxSchemeAscii);
+   }
+
+   if(stream.status != DmtxStatusComplete || StreamInputHasNext(&stream))
+      return DmtxUndefined;
+
+   return stream.sizeIdx;
+}
+
+/**
+ * \brief  Choose encodation scheme for upcoming input (look-ahead test)
+ * \param  input
+ * \param  inputNext Position of next unencoded input value
+ * \param  currentScheme
+ * \return Scheme that should encode the next chunk
+ */
+static int
+LookAheadScheme(DmtxByteList *input, int inputNext, int currentScheme)
+{
+   int i, scheme, inputCount;
+   int count[DmtxSchemeBase256 + 1];
+   DmtxByte value;
+
+   if(inputNext >= input->length)
+      return currentScheme;
+
+   /* Every scheme but the current one starts with the cost of its latch */
+   for(scheme = DmtxSchemeAscii; scheme <= DmtxSchemeBase256; scheme++)
+   {
+      if(scheme == currentScheme)
+         count[scheme] = 0;
+      else if(currentScheme == DmtxSchemeAscii || scheme == DmtxSchemeAscii)
+         count[scheme] = DmtxLookAheadUnit;
+      else
+         count[scheme] = 2 * DmtxLookAheadUnit;
+   }
+
+   /* Base 256 also pays for its length header */
+   if(currentScheme != DmtxSchemeBase256)
+      count[DmtxSchemeBase256] += DmtxLookAheadUnit / 4;
+
+   for(i = inputNext; i < input->length; i++)
+   {
+      value = input->b[i];
+
+      /* ASCII: digit pairs share a codeword, anything else starts a new one */
+      if(ISDIGIT(value))
+      {
+         count[DmtxSchemeAscii] += DmtxLookAheadUnit / 2;
+      }
+      else
+      {
+         count[DmtxSchemeAscii] = LookAheadRoundUp(count[DmtxSchemeAscii]);
+         count[DmtxSchemeAscii] += (value > 127) ? 2 * DmtxLookAheadUnit : DmtxLookAheadUnit;
+      }
+
+      /* C40 and Text: 2/3 per value, with shifts costing an extra value */
+      count[DmtxSchemeC40] += LookAheadCostCTX(value, DmtxSchemeC40);
+      count[DmtxSchemeText] += LookAheadCostCTX(value, DmtxSchemeText);
+      count[DmtxSchemeX12] += LookAheadCostCTX(value, DmtxSchemeX12);
+
+      /* EDIFACT: 3/4 per value, or ASCII round trip for anything else */
+      if(value >= 32 && value <= 94)
+         count[DmtxSchemeEdifact] += 9;
+      else if(value > 127)
+         count[DmtxSchemeEdifact] += 51;
+      else
+         count[DmtxSchemeEdifact] += 39;
+
+      /* Base 256: one codeword per value */
+      count[DmtxSchemeBase256] += DmtxLookAheadUnit;
+
+      inputCount = i - inputNext + 1;
+      if(inputCount < DmtxLookAheadMinInputs)
+         continue;
+
+      scheme = LookAheadDecide(count, input, i + 1, DmtxFalse);
+      if(scheme != DmtxUndefined)
+         return scheme;
+   }
+
+   return LookAheadDecide(count, input, input->length, DmtxTrue);
+}
+
+/**
+ * \brief  Compare look-ahead counts and choose a scheme if one has won
+ * \param  count Running count per scheme in 1/12 codeword units
+ * \param  input
+ * \param  inputNext Position following last counted input value
+ * \param  endOfInput DmtxTrue if every remaining input value was counted
+ * \return Chosen scheme, or DmtxUndefined if look-ahead should continue
+ */
+static int
+LookAheadDecide(int *count, DmtxByteList *input, int inputNext, DmtxBoolean endOfInput)
+{
+   int i;
+   int ascii, c40, text, x12, edifact, base256;
+
+   ascii = LookAheadRoundUp(count[DmtxSchemeAscii]) / DmtxLookAheadUnit;
+   c40 = LookAheadRoundUp(count[DmtxSchemeC40]) / DmtxLookAheadUnit;
+   text = LookAheadRoundUp(count[DmtxSchemeText]) / DmtxLookAheadUnit;
+   x12 = LookAheadRoundUp(count[DmtxSchemeX12]) / DmtxLookAheadUnit;
+   edifact = LookAheadRoundUp(count[DmtxSchemeEdifact]) / DmtxLookAheadUnit;
+   base256 = LookAheadRoundUp(count[DmtxSchemeBase256]) / DmtxLookAheadUnit;
+
+   if(endOfInput == DmtxTrue)
+   {
+      if(ascii <= c40 && ascii <= text && ascii <= x12 && ascii <= edifact && ascii <= base256)
+         return DmtxSchemeAscii;
+      if(base256 < ascii && base256 < c40 && base256 < text && base256 < x12 && base256 < edifact)
+         return DmtxSchemeBase256;
+      if(edifact < ascii && edifact < c40 && edifact < text && edifact < x12 && edifact < base256)
+         return DmtxSchemeEdifact;
+      if(text < ascii && text < c40 && text < x12 && text < edifact && text < base256)
+         return DmtxSchemeText;
+      if(x12 < ascii && x12 < c40 && x12 < text && x12 < edifact && x12 < base256)
+         return DmtxSchemeX12;
+      return DmtxSchemeC40;
+   }
+
+   if(ascii < c40 && ascii < text && ascii < x12 && ascii < edifact && ascii < base256)
+      return DmtxSchemeAscii;
+   if(base256 < ascii && base256 < c40 && base256 < text && base256 < x12 && base256 < edifact)
+      return DmtxSchemeBase256;
+   if(edifact + 1 < ascii && edifact + 1 < c40 && edifact + 1 < text &&
+         edifact + 1 < x12 && edifact + 1 < base256)
+      return DmtxSchemeEdifact;
+   if(text + 1 < ascii && text + 1 < c40 && text + 1 < x12 &&
+         text + 1 < edifact && text + 1 < base256)
+      return DmtxSchemeText;
+   if(x12 + 1 < ascii && x12 + 1 < c40 && x12 + 1 < text &&
+         x12 + 1 < edifact && x12 + 1 < base256)
+      return DmtxSchemeX12;
+
+   if(c40 + 1 < ascii && c40 + 1 < text && c40 + 1 < edifact && c40 + 1 < base256)
+   {
+      if(c40 < x12)
+         return DmtxSchemeC40;
+
+      if(c40 == x12)
+      {
+         /* Prefer X12 if an X12 terminator or separator comes up first */
+         for(i = inputNext; i < input->length; i++)
+         {
+            if(input->b[i] == 13 || input->b[i] == '*' || input->b[i] == '>')
+               return DmtxSchemeX12;
+            if(LookAheadCostCTX(input->b[i], DmtxSchemeX12) != DmtxLookAheadNativeCTX)
+               break;
+         }
+         return DmtxSchemeC40;
+      }
+   }
+
+   return DmtxUndefined;
+}
+
+/**
+ * \brief  Cost of one input value in C40, Text, or X12
+ * \param  value
+ * \param  scheme
+ * \return Cost in 1/12 codeword units
+ */
+static int
+LookAheadCostCTX(DmtxByte value, int scheme)
+{
+   /* Native values are those reachable without a shift */
+   if(GetCTXValueCount(value, scheme) == 1)
+      return DmtxLookAheadNativeCTX;
+
+   if(scheme == DmtxSchemeX12)
+      return (value > 127) ? 52 : 40;
+
+   return (value > 127) ? 32 : 16;
+}
+
+/**
+ * \brief  Round look-ahead count up to a whole codeword
+ * \param  count
+ * \return Rounded count in 1/12 codeword units
+ */
+static int
+LookAheadRoundUp(int count)
+{
+   return ((count + DmtxLookAheadUnit - 1) / DmtxLookAheadUnit) * DmtxLookAheadUnit;
+}
+
+/**
+ * \brief  Check whether next chunk can be encoded in scheme at all
+ * \param  input
+ * \param  inputNext
+ * \param  scheme
+ * \return DmtxTrue if next chunk can be encoded, otherwise DmtxFalse
+ *
+ * The look-ahead counts values that a scheme can only represent by switching
+ * back to ASCII. X12 chunks always span 3 input values and EDIFACT chunks 1,
+ * so these must be native to the scheme; C40, Text, and Base 256 can encode
+ * any input value.
+ */
+static DmtxBoolean
+LookAheadChunkFits(DmtxByteList *input, int inputNext, int scheme)
+{
+   int i;
+
+   switch(scheme)
+   {
+      case DmtxSchemeX12:
+         for(i = inputNext; i < inputNext + 3 && i < input->length; i++)
+         {
+            if(LookAheadCostCTX(input->b[i], DmtxSchemeX12) != DmtxLookAheadNativeCTX)
+               return DmtxFalse;
+         }
+         break;
+
+      case DmtxSchemeEdifact:
+         if(inputNext < input->length &&
+               (input->b[inputNext] < 32 || input->b[inputNext] > 94))
+            return DmtxFalse;
+         break;
+
+      default:
+         break;
+   }
+
+   return DmtxTrue;
+}
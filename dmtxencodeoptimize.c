@@ -32,8 +32,10 @@ enum SchemeState {
    SchemeStateCount
 };
 
+#define DmtxOptimizeTailSmall 4
+
 /** temporary
-static void DumpStreams(DmtxEncodeStream *streamBest)
+static void DumpStreams(DmtxOptimizeStream *streamBest)
 {
    enum SchemeState state;
    char prefix[32];
@@ -41,13 +43,13 @@ static void DumpStreams(DmtxEncodeStream *streamBest)
    fprintf(stdout, "----------------------------------------\n");
    for(state = 0; state < SchemeStateCount; state++)
    {
-      if(streamBest[state].status == DmtxStatusEncoding ||
-            streamBest[state].status == DmtxStatusComplete)
-         fprintf(stdout, "\"%c\" ", streamBest[state].input->b[streamBest[state].inputNext-1]);
+      if(streamBest[state].stream.status == DmtxStatusEncoding ||
+            streamBest[state].stream.status == DmtxStatusComplete)
+         fprintf(stdout, "\"%c\" ", streamBest[state].stream.input->b[streamBest[state].stream.inputNext-1]);
       else
          fprintf(stdout, "    ");
 
-      switch(streamBest[state].status) {
+      switch(streamBest[state].stream.status) {
          case DmtxStatusEncoding:
             snprintf(prefix, sizeof(prefix), "%2d (%s): ", state, " encode ");
             break;
@@ -61,87 +63,102 @@ static void DumpStreams(DmtxEncodeStream *streamBest)
             snprintf(prefix, sizeof(prefix), "%2d (%s): ", state, " fatal  ");
             break;
       }
-      dmtxByteListPrint(streamBest[state].output, prefix);
+      fprintf(stdout, "%5d words, node %6d, tail ", streamBest[state].outputLength,
+            streamBest[state].node);
+      dmtxByteListPrint(&(streamBest[state].tail), prefix);
    }
 }
 */
 
 /**
+ * Find the shortest encodation by advancing every scheme state one input
+ * value at a time, keeping the best stream for each state.
  *
- *
+ * Streams do not carry their full output. Each one records the arena node
+ * that produced it plus the few trailing words a later chunk can still
+ * touch, so advancing a state only costs the words it appends. The winning
+ * stream's output is rebuilt once at the end by replaying its node chain.
  */
 static int
-EncodeOptimizeBest(DmtxByteList *input, DmtxByteList *output, int sizeIdxRequest)
+EncodeOptimizeBest(DmtxByteList *input, DmtxByteList *output, int sizeIdxRequest,
+      const DmtxAllocator *allocator)
 {
    enum SchemeState state;
    int inputNext, c40ValueCount, textValueCount, x12ValueCount;
    int sizeIdx;
-   DmtxEncodeStream *winner;
-   DmtxPassFail passFail;
-   DmtxEncodeStream streamsBest[SchemeStateCount];
-   DmtxEncodeStream streamsTemp[SchemeStateCount];
-   DmtxByte outputsBestStorage[SchemeStateCount][4096];
-   DmtxByte outputsTempStorage[SchemeStateCount][4096];
-   DmtxByte ctxTempStorage[4];
-   DmtxByteList outputsBest[SchemeStateCount];
-   DmtxByteList outputsTemp[SchemeStateCount];
-   DmtxByteList ctxTemp = dmtxByteListBuild(ctxTempStorage, sizeof(ctxTempStorage));
-
-   /* Initialize all streams with their own output storage */
+   DmtxOptimizeStream *winner;
+   DmtxEncodeArena arena;
+   DmtxOptimizeStream streamsBest[SchemeStateCount];
+   DmtxOptimizeStream streamsTemp[SchemeStateCount];
+   DmtxByte tailsBestStorage[SchemeStateCount][DmtxOptimizeTailSmall];
+   DmtxByte tailsTempStorage[SchemeStateCount][DmtxOptimizeTailSmall];
+   DmtxByte base256BestStorage[4096];
+   DmtxByte base256TempStorage[4096];
+   DmtxByte scratchStorage[4096];
+
+   /* Each state adds at most one node per input value, plus the shared root */
+   arena.capacity = input->length * SchemeStateCount + 1;
+   arena.node = (DmtxEncodeNode *)AllocMalloc(allocator, arena.capacity * sizeof(DmtxEncodeNode));
+   if(arena.node == NULL)
+      return DmtxUndefined;
+   arena.length = 0;
+   arena.scratch = dmtxByteListBuild(scratchStorage, sizeof(scratchStorage));
+   ArenaAppendNode(&arena, DmtxUndefined, DmtxUndefined, DmtxUndefined);
+
+   /* Only Base256 needs its whole chain on hand (header rewrites) */
    for(state = 0; state < SchemeStateCount; state++)
    {
-      outputsBest[state] = dmtxByteListBuild(outputsBestStorage[state], sizeof(outputsBestStorage[state]));
-      outputsTemp[state] = dmtxByteListBuild(outputsTempStorage[state], sizeof(outputsTempStorage[state]));
-      streamsBest[state] = StreamInit(input, &(outputsBest[state]));
-      streamsTemp[state] = StreamInit(input, &(outputsTemp[state]));
+      if(state == Base256)
+      {
+         OptimizeStreamInit(&(streamsBest[state]), input, base256BestStorage, sizeof(base256BestStorage));
+         OptimizeStreamInit(&(streamsTemp[state]), input, base256TempStorage, sizeof(base256TempStorage));
+      }
+      else
+      {
+         OptimizeStreamInit(&(streamsBest[state]), input, tailsBestStorage[state], DmtxOptimizeTailSmall);
+         OptimizeStreamInit(&(streamsTemp[state]), input, tailsTempStorage[state], DmtxOptimizeTailSmall);
+      }
    }
 
    c40ValueCount = textValueCount = x12ValueCount = 0;
 
    for(inputNext = 0; inputNext < input->length; inputNext++)
    {
-      StreamAdvanceFromBest(streamsTemp, streamsBest, AsciiFull, sizeIdxRequest);
+      StreamAdvanceFromBest(streamsTemp, streamsBest, AsciiFull, &arena, sizeIdxRequest);
 
-      AdvanceAsciiCompact(streamsTemp, streamsBest, AsciiCompactOffset0, inputNext, sizeIdxRequest);
-      AdvanceAsciiCompact(streamsTemp, streamsBest, AsciiCompactOffset1, inputNext, sizeIdxRequest);
+      AdvanceAsciiCompact(streamsTemp, streamsBest, AsciiCompactOffset0, inputNext, &arena, sizeIdxRequest);
+      AdvanceAsciiCompact(streamsTemp, streamsBest, AsciiCompactOffset1, inputNext, &arena, sizeIdxRequest);
 
-      AdvanceCTX(streamsTemp, streamsBest, C40Offset0, inputNext, c40ValueCount, sizeIdxRequest);
-      AdvanceCTX(streamsTemp, streamsBest, C40Offset1, inputNext, c40ValueCount, sizeIdxRequest);
-      AdvanceCTX(streamsTemp, streamsBest, C40Offset2, inputNext, c40ValueCount, sizeIdxRequest);
+      AdvanceCTX(streamsTemp, streamsBest, C40Offset0, inputNext, c40ValueCount, &arena, sizeIdxRequest);
+      AdvanceCTX(streamsTemp, streamsBest, C40Offset1, inputNext, c40ValueCount, &arena, sizeIdxRequest);
+      AdvanceCTX(streamsTemp, streamsBest, C40Offset2, inputNext, c40ValueCount, &arena, sizeIdxRequest);
 
-      AdvanceCTX(streamsTemp, streamsBest, TextOffset0, inputNext, textValueCount, sizeIdxRequest);
-      AdvanceCTX(streamsTemp, streamsBest, TextOffset1, inputNext, textValueCount, sizeIdxRequest);
-      AdvanceCTX(streamsTemp, streamsBest, TextOffset2, inputNext, textValueCount, sizeIdxRequest);
+      AdvanceCTX(streamsTemp, streamsBest, TextOffset0, inputNext, textValueCount, &arena, sizeIdxRequest);
+      AdvanceCTX(streamsTemp, streamsBest, TextOffset1, inputNext, textValueCount, &arena, sizeIdxRequest);
+      AdvanceCTX(streamsTemp, streamsBest, TextOffset2, inputNext, textValueCount, &arena, sizeIdxRequest);
 
-      AdvanceCTX(streamsTemp, streamsBest, X12Offset0, inputNext, x12ValueCount, sizeIdxRequest);
-      AdvanceCTX(streamsTemp, streamsBest, X12Offset1, inputNext, x12ValueCount, sizeIdxRequest);
-      AdvanceCTX(streamsTemp, streamsBest, X12Offset2, inputNext, x12ValueCount, sizeIdxRequest);
+      AdvanceCTX(streamsTemp, streamsBest, X12Offset0, inputNext, x12ValueCount, &arena, sizeIdxRequest);
+      AdvanceCTX(streamsTemp, streamsBest, X12Offset1, inputNext, x12ValueCount, &arena, sizeIdxRequest);
+      AdvanceCTX(streamsTemp, streamsBest, X12Offset2, inputNext, x12ValueCount, &arena, sizeIdxRequest);
 
-      AdvanceEdifact(streamsTemp, streamsBest, EdifactOffset0, inputNext, sizeIdxRequest);
-      AdvanceEdifact(streamsTemp, streamsBest, EdifactOffset1, inputNext, sizeIdxRequest);
-      AdvanceEdifact(streamsTemp, streamsBest, EdifactOffset2, inputNext, sizeIdxRequest);
-      AdvanceEdifact(streamsTemp, streamsBest, EdifactOffset3, inputNext, sizeIdxRequest);
+      AdvanceEdifact(streamsTemp, streamsBest, EdifactOffset0, inputNext, &arena, sizeIdxRequest);
+      AdvanceEdifact(streamsTemp, streamsBest, EdifactOffset1, inputNext, &arena, sizeIdxRequest);
+      AdvanceEdifact(streamsTemp, streamsBest, EdifactOffset2, inputNext, &arena, sizeIdxRequest);
+      AdvanceEdifact(streamsTemp, streamsBest, EdifactOffset3, inputNext, &arena, sizeIdxRequest);
 
-      StreamAdvanceFromBest(streamsTemp, streamsBest, Base256, sizeIdxRequest);
+      StreamAdvanceFromBest(streamsTemp, streamsBest, Base256, &arena, sizeIdxRequest);
 
       /* Overwrite best streams with new results */
       for(state = 0; state < SchemeStateCount; state++)
       {
-         if(streamsBest[state].status != DmtxStatusComplete)
-            StreamCopy(&(streamsBest[state]), &(streamsTemp[state]));
+         if(streamsBest[state].stream.status != DmtxStatusComplete)
+            OptimizeStreamCopy(&(streamsBest[state]), &(streamsTemp[state]));
       }
 
-      dmtxByteListClear(&ctxTemp);
-      PushCTXValues(&ctxTemp, input->b[inputNext], DmtxSchemeC40, &passFail);
-      c40ValueCount += ((passFail == DmtxPass) ? ctxTemp.length : 1);
-
-      dmtxByteListClear(&ctxTemp);
-      PushCTXValues(&ctxTemp, input->b[inputNext], DmtxSchemeText, &passFail);
-      textValueCount += ((passFail == DmtxPass) ? ctxTemp.length : 1);
-
-      dmtxByteListClear(&ctxTemp);
-      PushCTXValues(&ctxTemp, input->b[inputNext], DmtxSchemeX12, &passFail);
-      x12ValueCount += ((passFail == DmtxPass) ? ctxTemp.length : 1);
+      /* Unsupported X12 values still advance the offset by one */
+      c40ValueCount += GetCTXValueCount(input->b[inputNext], DmtxSchemeC40);
+      textValueCount += GetCTXValueCount(input->b[inputNext], DmtxSchemeText);
+      x12ValueCount += max(GetCTXValueCount(input->b[inputNext], DmtxSchemeX12), 1);
 
 /*    DumpStreams(streamsBest); */
    }
@@ -150,24 +167,27 @@ EncodeOptimizeBest(DmtxByteList *input, DmtxByteList *output, int sizeIdxRequest
    winner = NULL;
    for(state = 0; state < SchemeStateCount; state++)
    {
-      if(streamsBest[state].status == DmtxStatusComplete)
+      if(streamsBest[state].stream.status == DmtxStatusComplete)
       {
-         if(winner == NULL || streamsBest[state].output->length < winner->output->length)
+         if(winner == NULL || streamsBest[state].outputLength < winner->outputLength)
             winner = &(streamsBest[state]);
       }
    }
 
-   /* Copy winner to output */
+   /* Materialize winner into output */
    if(winner == NULL)
    {
       sizeIdx = DmtxUndefined;
    }
    else
    {
-      dmtxByteListCopy(output, winner->output, &passFail);
-      sizeIdx = (passFail == DmtxPass) ? winner->sizeIdx : DmtxUndefined;
+      sizeIdx = ArenaReplay(&arena, winner->node, input, output, sizeIdxRequest);
+      assert(sizeIdx == DmtxUndefined || (sizeIdx == winner->stream.sizeIdx &&
+            output->length == winner->outputLength));
    }
 
+   AllocFree(allocator, arena.node);
+
    return sizeIdx;
 }
 
@@ -177,19 +197,18 @@ EncodeOptimizeBest(DmtxByteList *input, DmtxByteList *output, int sizeIdxRequest
  * is the number of latches/unlatches that are also encoded
  */
 static void
-StreamAdvanceFromBest(DmtxEncodeStream *streamsNext, DmtxEncodeStream *streamsBest,
-     int targetState, int sizeIdxRequest)
+StreamAdvanceFromBest(DmtxOptimizeStream *streamsNext, DmtxOptimizeStream *streamsBest,
+     int targetState, DmtxEncodeArena *arena, int sizeIdxRequest)
 {
    enum SchemeState fromState;
+   int chosenState;
    DmtxScheme targetScheme;
    DmtxEncodeOption encodeOption;
-   DmtxByte outputTempStorage[4096];
-   DmtxByteList outputTemp = dmtxByteListBuild(outputTempStorage, sizeof(outputTempStorage));
    DmtxEncodeStream streamTemp;
-   DmtxEncodeStream *targetStream = &(streamsNext[targetState]);
+   DmtxOptimizeStream *targetStream = &(streamsNext[targetState]);
 
-   streamTemp.output = &outputTemp; /* Set directly instead of calling StreamInit() */
    targetScheme = GetScheme(targetState);
+   chosenState = DmtxUndefined;
 
    if(targetState == AsciiFull)
       encodeOption = DmtxEncodeFull;
@@ -200,32 +219,42 @@ StreamAdvanceFromBest(DmtxEncodeStream *streamsNext, DmtxEncodeStream *streamsBe
 
    for(fromState = 0; fromState < SchemeStateCount; fromState++)
    {
-      if(streamsBest[fromState].status != DmtxStatusEncoding ||
+      if(streamsBest[fromState].stream.status != DmtxStatusEncoding ||
             ValidStateSwitch(fromState, targetState) == DmtxFalse)
       {
          continue;
       }
 
-      StreamCopy(&streamTemp, &(streamsBest[fromState]));
+      OptimizeStreamExpand(&streamTemp, &(streamsBest[fromState]), arena);
       EncodeNextChunk(&streamTemp, targetScheme, encodeOption, sizeIdxRequest);
 
       if(fromState == 0 || (streamTemp.status != DmtxStatusInvalid &&
-            streamTemp.output->length < targetStream->output->length))
+            streamTemp.output->length < targetStream->outputLength))
       {
-         StreamCopy(targetStream, &streamTemp);
+         OptimizeStreamCollapse(targetStream, &streamTemp);
+         chosenState = fromState;
       }
    }
+
+   /* Record only the surviving candidate in the arena */
+   if(chosenState != DmtxUndefined)
+   {
+      targetStream->node = ArenaAppendNode(arena, streamsBest[chosenState].node,
+            targetScheme, encodeOption);
+      if(targetStream->node == DmtxUndefined)
+         StreamMarkFatal(&(targetStream->stream), DmtxErrorOutOfBounds);
+   }
 }
 
 /**
  *
  */
 static void
-AdvanceAsciiCompact(DmtxEncodeStream *streamsNext, DmtxEncodeStream *streamsBest,
-      int targetState, int inputNext, int sizeIdxRequest)
+AdvanceAsciiCompact(DmtxOptimizeStream *streamsNext, DmtxOptimizeStream *streamsBest,
+      int targetState, int inputNext, DmtxEncodeArena *arena, int sizeIdxRequest)
 {
-   DmtxEncodeStream *currentStream = &(streamsBest[targetState]);
-   DmtxEncodeStream *targetStream = &(streamsNext[targetState]);
+   DmtxOptimizeStream *currentStream = &(streamsBest[targetState]);
+   DmtxOptimizeStream *targetStream = &(streamsNext[targetState]);
    DmtxBoolean isStartState;
 
    switch(targetState)
@@ -239,22 +268,22 @@ AdvanceAsciiCompact(DmtxEncodeStream *streamsNext, DmtxEncodeStream *streamsBest
          break;
 
       default:
-         StreamMarkFatal(targetStream, DmtxErrorIllegalParameterValue);
+         StreamMarkFatal(&(targetStream->stream), DmtxErrorIllegalParameterValue);
          return;
    }
 
-   if(inputNext < currentStream->inputNext)
+   if(inputNext < currentStream->stream.inputNext)
    {
-      StreamCopy(targetStream, currentStream);
+      OptimizeStreamCopy(targetStream, currentStream);
    }
    else if(isStartState == DmtxTrue)
    {
-      StreamAdvanceFromBest(streamsNext, streamsBest, targetState, sizeIdxRequest);
+      StreamAdvanceFromBest(streamsNext, streamsBest, targetState, arena, sizeIdxRequest);
    }
    else
    {
-      StreamCopy(targetStream, currentStream);
-      StreamMarkInvalid(targetStream, DmtxErrorUnknown);
+      OptimizeStreamCopy(targetStream, currentStream);
+      StreamMarkInvalid(&(targetStream->stream), DmtxErrorUnknown);
    }
 }
 
@@ -262,11 +291,12 @@ AdvanceAsciiCompact(DmtxEncodeStream *streamsNext, DmtxEncodeStream *streamsBest
  *
  */
 static void
-AdvanceCTX(DmtxEncodeStream *streamsNext, DmtxEncodeStream *streamsBest,
-      int targetState, int inputNext, int ctxValueCount, int sizeIdxRequest)
+AdvanceCTX(DmtxOptimizeStream *streamsNext, DmtxOptimizeStream *streamsBest,
+      int targetState, int inputNext, int ctxValueCount, DmtxEncodeArena *arena,
+      int sizeIdxRequest)
 {
-   DmtxEncodeStream *currentStream = &(streamsBest[targetState]);
-   DmtxEncodeStream *targetStream = &(streamsNext[targetState]);
+   DmtxOptimizeStream *currentStream = &(streamsBest[targetState]);
+   DmtxOptimizeStream *targetStream = &(streamsNext[targetState]);
    DmtxBoolean isStartState;
 
    /* we won't actually use inputNext here */
@@ -291,22 +321,22 @@ AdvanceCTX(DmtxEncodeStream *streamsNext, DmtxEncodeStream *streamsBest,
          break;
 
       default:
-         StreamMarkFatal(targetStream, DmtxErrorIllegalParameterValue);
+         StreamMarkFatal(&(targetStream->stream), DmtxErrorIllegalParameterValue);
          return;
    }
 
-   if(inputNext < currentStream->inputNext)
+   if(inputNext < currentStream->stream.inputNext)
    {
-      StreamCopy(targetStream, currentStream);
+      OptimizeStreamCopy(targetStream, currentStream);
    }
    else if(isStartState == DmtxTrue)
    {
-      StreamAdvanceFromBest(streamsNext, streamsBest, targetState, sizeIdxRequest);
+      StreamAdvanceFromBest(streamsNext, streamsBest, targetState, arena, sizeIdxRequest);
    }
    else
    {
-      StreamCopy(targetStream, currentStream);
-      StreamMarkInvalid(targetStream, DmtxErrorUnknown);
+      OptimizeStreamCopy(targetStream, currentStream);
+      StreamMarkInvalid(&(targetStream->stream), DmtxErrorUnknown);
    }
 }
 
@@ -314,11 +344,12 @@ AdvanceCTX(DmtxEncodeStream *streamsNext, DmtxEncodeStream *streamsBest,
  *
  */
 static void
-AdvanceEdifact(DmtxEncodeStream *streamsNext, DmtxEncodeStream *streamsBest,
-      int targetState, int inputNext, int sizeIdxRequest)
+AdvanceEdifact(DmtxOptimizeStream *streamsNext, DmtxOptimizeStream *streamsBest,
+      int targetState, int inputNext, DmtxEncodeArena *arena, int sizeIdxRequest)
 {
-   DmtxEncodeStream *currentStream = &(streamsBest[targetState]);
-   DmtxEncodeStream *targetStream = &(streamsNext[targetState]);
+   DmtxOptimizeStream *currentStream = &(streamsBest[targetState]);
+   DmtxOptimizeStream *targetStream = &(streamsNext[targetState]);
+   DmtxEncodeStream streamTemp;
    DmtxBoolean isStartState;
 
    switch(targetState)
@@ -340,22 +371,204 @@ AdvanceEdifact(DmtxEncodeStream *streamsNext, DmtxEncodeStream *streamsBest,
          break;
 
       default:
-         StreamMarkFatal(targetStream, DmtxErrorIllegalParameterValue);
+         StreamMarkFatal(&(targetStream->stream), DmtxErrorIllegalParameterValue);
          return;
    }
 
    if(isStartState == DmtxTrue)
    {
-      StreamAdvanceFromBest(streamsNext, streamsBest, targetState, sizeIdxRequest);
+      StreamAdvanceFromBest(streamsNext, streamsBest, targetState, arena, sizeIdxRequest);
+   }
+   else if(currentStream->stream.status == DmtxStatusEncoding &&
+         currentStream->stream.currentScheme == DmtxSchemeEdifact)
+   {
+      OptimizeStreamExpand(&streamTemp, currentStream, arena);
+      EncodeNextChunk(&streamTemp, DmtxSchemeEdifact, DmtxEncodeNormal, sizeIdxRequest);
+      OptimizeStreamCollapse(targetStream, &streamTemp);
+
+      targetStream->node = ArenaAppendNode(arena, currentStream->node,
+            DmtxSchemeEdifact, DmtxEncodeNormal);
+      if(targetStream->node == DmtxUndefined)
+         StreamMarkFatal(&(targetStream->stream), DmtxErrorOutOfBounds);
    }
    else
    {
-      StreamCopy(targetStream, currentStream);
-      if(currentStream->status == DmtxStatusEncoding && currentStream->currentScheme == DmtxSchemeEdifact)
-         EncodeNextChunk(targetStream, DmtxSchemeEdifact, DmtxEncodeNormal, sizeIdxRequest);
-      else
-         StreamMarkInvalid(targetStream, DmtxErrorUnknown);
+      OptimizeStreamCopy(targetStream, currentStream);
+      StreamMarkInvalid(&(targetStream->stream), DmtxErrorUnknown);
+   }
+}
+
+/**
+ * \brief  Initialize optimizer stream at start of input
+ * \param  ostream
+ * \param  input
+ * \param  tailStorage Storage for trailing output words
+ * \param  tailCapacity
+ * \return void
+ */
+static void
+OptimizeStreamInit(DmtxOptimizeStream *ostream, DmtxByteList *input,
+      DmtxByte *tailStorage, int tailCapacity)
+{
+   ostream->stream = StreamInit(input, NULL);
+   ostream->outputLength = 0;
+   ostream->node = 0;
+   ostream->tail = dmtxByteListBuild(tailStorage, tailCapacity);
+}
+
+/**
+ * \brief  Copy optimizer stream, including its trailing output words
+ * \param  dst
+ * \param  src
+ * \return void
+ */
+static void
+OptimizeStreamCopy(DmtxOptimizeStream *dst, DmtxOptimizeStream *src)
+{
+   dst->stream = src->stream;
+   dst->outputLength = src->outputLength;
+   dst->node = src->node;
+
+   if(src->tail.length > dst->tail.capacity)
+   {
+      dst->tail.length = 0;
+      StreamMarkFatal(&(dst->stream), DmtxErrorOutOfBounds);
+      return;
+   }
+
+   memcpy(dst->tail.b, src->tail.b, src->tail.length);
+   dst->tail.length = src->tail.length;
+}
+
+/**
+ * \brief  Expand optimizer stream into a regular stream writing to the
+ *         arena's scratch buffer
+ *
+ * Only the tail words are copied. Earlier positions in the scratch buffer
+ * hold stale data, which is safe because encoders only revisit words in
+ * their current chain and the tail covers every such word.
+ *
+ * \param  stream Receives stream ready for EncodeNextChunk()
+ * \param  ostream
+ * \param  arena
+ * \return void
+ */
+static void
+OptimizeStreamExpand(DmtxEncodeStream *stream, DmtxOptimizeStream *ostream,
+      DmtxEncodeArena *arena)
+{
+   DmtxByteList *scratch = &(arena->scratch);
+
+   assert(ostream->outputLength <= scratch->capacity);
+
+   *stream = ostream->stream;
+   stream->output = scratch;
+
+   scratch->length = ostream->outputLength;
+   memcpy(scratch->b + scratch->length - ostream->tail.length, ostream->tail.b,
+         ostream->tail.length);
+}
+
+/**
+ * \brief  Store regular stream back into optimizer stream, keeping only the
+ *         output words a later chunk may revisit
+ * \param  ostream
+ * \param  stream
+ * \return void
+ */
+static void
+OptimizeStreamCollapse(DmtxOptimizeStream *ostream, DmtxEncodeStream *stream)
+{
+   int tailLength;
+
+   if(stream->status != DmtxStatusEncoding)
+      tailLength = 0; /* Never advanced again */
+   else if(stream->currentScheme == DmtxSchemeBase256)
+      tailLength = stream->outputChainWordCount; /* Header updates rewrite chain */
+   else
+      tailLength = min(stream->outputChainWordCount, 1); /* Edifact repacks last word */
+
+   ostream->stream = *stream;
+   ostream->stream.output = NULL;
+   ostream->outputLength = stream->output->length;
+
+   if(tailLength > ostream->tail.capacity)
+   {
+      ostream->tail.length = 0;
+      StreamMarkFatal(&(ostream->stream), DmtxErrorOutOfBounds);
+      return;
    }
+
+   memcpy(ostream->tail.b, stream->output->b + stream->output->length - tailLength,
+         tailLength);
+   ostream->tail.length = tailLength;
+}
+
+/**
+ * \brief  Add node to arena
+ * \param  arena
+ * \param  parent Node being extended
+ * \param  scheme
+ * \param  option
+ * \return Index of new node, or DmtxUndefined if arena is full
+ */
+static int
+ArenaAppendNode(DmtxEncodeArena *arena, int parent, int scheme, int option)
+{
+   DmtxEncodeNode *node;
+
+   if(arena->length >= arena->capacity)
+      return DmtxUndefined;
+
+   node = &(arena->node[arena->length]);
+   node->parent = parent;
+   node->scheme = scheme;
+   node->option = option;
+
+   return arena->length++;
+}
+
+/**
+ * \brief  Rebuild a stream's full output by replaying its node chain
+ *
+ * Parent links are reversed in place to walk the chain from the root, so
+ * the arena cannot be used for further encoding afterward.
+ *
+ * \param  arena
+ * \param  node Final node of chain
+ * \param  input
+ * \param  output Receives encoded codewords
+ * \param  sizeIdxRequest
+ * \return Symbol size index of completed stream, or DmtxUndefined
+ */
+static int
+ArenaReplay(DmtxEncodeArena *arena, int node, DmtxByteList *input,
+      DmtxByteList *output, int sizeIdxRequest)
+{
+   int prev, next;
+   DmtxEncodeStream stream;
+
+   /* Reverse chain so each node points to its successor */
+   prev = DmtxUndefined;
+   while(node != DmtxUndefined)
+   {
+      next = arena->node[node].parent;
+      arena->node[node].parent = prev;
+      prev = node;
+      node = next;
+   }
+
+   dmtxByteListClear(output);
+   stream = StreamInit(input, output);
+
+   /* First node is the root, which holds no chunk */
+   for(node = arena->node[prev].parent; node != DmtxUndefined; node = arena->node[node].parent)
+   {
+      EncodeNextChunk(&stream, arena->node[node].scheme, arena->node[node].option,
+            sizeIdxRequest);
+   }
+
+   return (stream.status == DmtxStatusComplete) ? stream.sizeIdx : DmtxUndefined;
 }
 
 /**
@@ -0,0 +1,241 @@
+/**
+ * libdmtx - Data Matrix Encoding/Decoding Library
+ * Copyright 2011 Mike Laughton. All rights reserved.
+ *
+ * See LICENSE file in the main project directory for full
+ * terms of use and distribution.
+ *
+ * Contact: Mike Laughton <mike@dragonflylogic.com>
+ *
+ * \file dmtxencodesheet.c
+ * \brief Rendering a grid of symbols into one sheet image
+ */
+
+/**
+ * \brief  Render a grid of symbols directly into a sheet image
+ *
+ * Every payload is encoded up front into a packed module bitmap, after which
+ * the sheet is written in a single pass from its first scanline to its last.
+ * Each scanline is composed once across all cells in its grid row, and
+ * scanlines that repeat the one above (within a module row) are copied. No
+ * memory is allocated per symbol, and the sheet is left untouched if any
+ * payload fails to encode or its symbol doesn't fit its cell.
+ *
+ * Each symbol is drawn at the top-left corner of its cell with a quiet zone
+ * of enc->marginSize pixels, using the scheme, size request, module size,
+ * pixel packing, and image flip of enc. Pixels outside symbols are white,
+ * and row padding beyond width is not written. Packings must be 1bpp or
+ * byte-aligned (as with dmtxEncodeDataMatrixBuffer() fast path).
+ *
+ * \param  enc Settings shared by all cells
+ * \param  layout Grid geometry in pixels
+ * \param  inputSize Payload size per cell, row-major
+ * \param  inputString Payload per cell, row-major (NULL leaves cell blank)
+ * \param  pxl Sheet pixels
+ * \param  width Sheet width in pixels
+ * \param  height Sheet height in pixels
+ * \param  rowSizeBytes Distance in bytes between starts of consecutive rows
+ * \return DmtxPass | DmtxFail
+ */
+DmtxPassFail
+dmtxEncodeSheet(DmtxEncode *enc, const DmtxSheetLayout *layout, int *inputSize,
+      unsigned char **inputString, unsigned char *pxl, int width, int height,
+      int rowSizeBytes)
+{
+   int i, cellCount;
+   int rowIdx, ty, keyBand, keyRow, prevBand, prevRow;
+   int rowBytes;
+   unsigned char pixel[DmtxModuleOnRGB + 1][4];
+   unsigned char *rowPtr, *prevPtr;
+   DmtxSheetCell *cells;
+   DmtxImage image;
+
+   if(enc == NULL || layout == NULL || inputSize == NULL || inputString == NULL ||
+         pxl == NULL || layout->columns < 1 || layout->rows < 1 ||
+         layout->pitchX < 1 || layout->pitchY < 1 || enc->moduleSize < 1)
+      return DmtxFail;
+
+   if(ImageInit(&image, pxl, width, height, enc->pixelPacking) == DmtxFail ||
+         rowSizeBytes < image.rowSizeBytes)
+      return DmtxFail;
+
+   dmtxImageSetProp(&image, DmtxPropImageFlip, enc->imageFlip);
+   dmtxImageSetProp(&image, DmtxPropRowPadBytes, rowSizeBytes - image.rowSizeBytes);
+
+   if(image.bitsPerPixel != 1 && BuildPatternPixels(&image, pixel) == DmtxFail)
+      return DmtxFail;
+
+   cellCount = layout->columns * layout->rows;
+   cells = (DmtxSheetCell *)AllocMalloc(&(enc->allocator), cellCount * sizeof(DmtxSheetCell) +
+         cellCount * DmtxMaxModuleBytes);
+   if(cells == NULL)
+      return DmtxFail;
+
+   /* Encode every cell before touching the sheet */
+   for(i = 0; i < cellCount; i++) {
+      cells[i].modules = (unsigned char *)(cells + cellCount) + i * DmtxMaxModuleBytes;
+      if(SheetEncodeCell(enc, layout, i, inputSize[i], inputString[i], &cells[i],
+            width, height) == DmtxFail) {
+         AllocFree(&(enc->allocator), cells);
+         return DmtxFail;
+      }
+   }
+
+   rowBytes = (width * image.bitsPerPixel + 7)/8;
+   prevPtr = NULL;
+   prevBand = prevRow = DmtxUndefined;
+
+   /* Write scanlines in memory order, whichever way the image is flipped */
+   for(rowIdx = 0; rowIdx < height; rowIdx++) {
+      rowPtr = pxl + rowIdx * rowSizeBytes;
+      ty = (image.imageFlip & DmtxFlipY) ? height - rowIdx - 1 : rowIdx;
+
+      SheetRowKey(enc, layout, ty, &keyBand, &keyRow);
+
+      if(prevPtr != NULL && keyBand == prevBand && keyRow == prevRow) {
+         memcpy(rowPtr, prevPtr, rowBytes);
+      }
+      else {
+         memset(rowPtr, 0xff, rowBytes);
+         if(keyBand != DmtxUndefined && keyRow != DmtxUndefined)
+            SheetComposeRow(&image, rowPtr, pixel, enc, layout,
+                  cells + keyBand * layout->columns, keyRow);
+      }
+
+      prevPtr = rowPtr;
+      prevBand = keyBand;
+      prevRow = keyRow;
+   }
+
+   AllocFree(&(enc->allocator), cells);
+
+   return DmtxPass;
+}
+
+/**
+ * \brief  Encode one cell's payload into its module bitmap
+ * \param  enc
+ * \param  layout
+ * \param  cellIdx Row-major cell index
+ * \param  inputSize
+ * \param  inputString Payload, or NULL for a blank cell
+ * \param  cell Receives bitmap and symbol dimensions
+ * \param  width Sheet width in pixels
+ * \param  height Sheet height in pixels
+ * \return DmtxPass | DmtxFail (encoding failed or symbol doesn't fit)
+ */
+static DmtxPassFail
+SheetEncodeCell(DmtxEncode *enc, const DmtxSheetLayout *layout, int cellIdx,
+      int inputSize, unsigned char *inputString, DmtxSheetCell *cell, int width,
+      int height)
+{
+   int cellX, cellY, symbolWidth, symbolHeight;
+
+   cell->rows = cell->cols = 0;
+
+   if(inputString == NULL || inputSize < 1)
+      return DmtxPass;
+
+   if(dmtxEncodeModules(enc, inputSize, inputString, cell->modules,
+         DmtxMaxModuleBytes, &(cell->rows), &(cell->cols)) == DmtxFail)
+      return DmtxFail;
+
+   cellX = layout->marginLeft + (cellIdx % layout->columns) * layout->pitchX;
+   cellY = layout->marginTop + (cellIdx / layout->columns) * layout->pitchY;
+   symbolWidth = 2 * enc->marginSize + cell->cols * enc->moduleSize;
+   symbolHeight = 2 * enc->marginSize + cell->rows * enc->moduleSize;
+
+   /* Symbol must stay inside its own cell and the sheet */
+   if(cellX < 0 || cellY < 0 || cellX + symbolWidth > width || cellY + symbolHeight > height)
+      return DmtxFail;
+
+   if((layout->columns > 1 && symbolWidth > layout->pitchX) ||
+         (layout->rows > 1 && symbolHeight > layout->pitchY))
+      return DmtxFail;
+
+   return DmtxPass;
+}
+
+/**
+ * \brief  Identify which grid row and module row a scanline shows
+ * \param  enc
+ * \param  layout
+ * \param  ty Scanline counted from top of sheet
+ * \param  band Receives grid row, or DmtxUndefined outside the grid
+ * \param  moduleRow Receives module row counted from top of symbols, or
+ *         DmtxUndefined within quiet zone or gutter
+ * \return void
+ *
+ * Symbols in a grid row share their top edge and module size, so scanlines
+ * with the same band and module row are identical.
+ */
+static void
+SheetRowKey(DmtxEncode *enc, const DmtxSheetLayout *layout, int ty, int *band,
+      int *moduleRow)
+{
+   int offset;
+
+   *band = *moduleRow = DmtxUndefined;
+
+   offset = ty - layout->marginTop;
+   if(offset < 0 || offset >= layout->rows * layout->pitchY)
+      return;
+
+   *band = offset / layout->pitchY;
+   offset = offset % layout->pitchY - enc->marginSize;
+   if(offset >= 0)
+      *moduleRow = offset / enc->moduleSize;
+}
+
+/**
+ * \brief  Draw dark modules of one module row across a grid row of cells
+ * \param  img Sheet image
+ * \param  rowPtr Scanline, already white
+ * \param  pixel Pixel bytes from BuildPatternPixels() (unused for 1bpp)
+ * \param  enc
+ * \param  layout
+ * \param  cells First cell of grid row
+ * \param  moduleRow Module row counted from top of symbols
+ * \return void
+ */
+static void
+SheetComposeRow(DmtxImage *img, unsigned char *rowPtr, unsigned char pixel[][4],
+      DmtxEncode *enc, const DmtxSheetLayout *layout, DmtxSheetCell *cells,
+      int moduleRow)
+{
+   int i, col, x;
+   int moduleSize, bytesPerPixel;
+   DmtxBoolean uniform;
+   unsigned char *modules, *ptr;
+
+   moduleSize = enc->moduleSize;
+   bytesPerPixel = img->bytesPerPixel;
+   uniform = (img->bitsPerPixel == 1 || memcmp(pixel[DmtxModuleOnRGB],
+         pixel[DmtxModuleOnRGB] + 1, bytesPerPixel - 1) == 0) ? DmtxTrue : DmtxFalse;
+
+   for(i = 0; i < layout->columns; i++) {
+      if(moduleRow >= cells[i].rows)
+         continue;
+
+      modules = cells[i].modules + moduleRow * ((cells[i].cols + 7)/8);
+      x = layout->marginLeft + i * layout->pitchX + enc->marginSize;
+
+      for(col = 0; col < cells[i].cols; col++, x += moduleSize) {
+         if(!(modules[col >> 3] & (0x80 >> (col & 0x07))))
+            continue;
+
+         if(img->bitsPerPixel == 1) {
+            ClearBitRun(rowPtr, x, moduleSize);
+         }
+         else if(uniform == DmtxTrue) {
+            memset(rowPtr + x * bytesPerPixel, pixel[DmtxModuleOnRGB][0],
+                  moduleSize * bytesPerPixel);
+         }
+         else {
+            for(ptr = rowPtr + x * bytesPerPixel; ptr < rowPtr + (x + moduleSize) * bytesPerPixel;
+                  ptr += bytesPerPixel)
+               memcpy(ptr, pixel[DmtxModuleOnRGB], bytesPerPixel);
+         }
+      }
+   }
+}
@@ -34,27 +34,6 @@ StreamInit(DmtxByteList *input, DmtxByteList *output)
    return stream;
 }
 
-/**
- *
- *
- */
-static void
-StreamCopy(DmtxEncodeStream *dst, DmtxEncodeStream *src)
-{
-   DmtxPassFail passFail;
-
-   dst->currentScheme = src->currentScheme;
-   dst->inputNext = src->inputNext;
-   dst->outputChainValueCount = src->outputChainValueCount;
-   dst->outputChainWordCount = src->outputChainWordCount;
-   dst->reason = src->reason;
-   dst->sizeIdx = src->sizeIdx;
-   dst->status = src->status;
-   dst->input = src->input;
-
-   dmtxByteListCopy(dst->output, src->output, &passFail);
-}
-
 /**
  *
  *
@@ -99,14 +78,35 @@ StreamMarkFatal(DmtxEncodeStream *stream, int reasonIdx)
 static void
 StreamOutputChainAppend(DmtxEncodeStream *stream, DmtxByte value)
 {
+   if(stream->output->length < stream->output->capacity)
+   {
+      DMTX_BYTELIST_PUSH(stream->output, value);
+      stream->outputChainWordCount++;
+   }
+   else
+   {
+      StreamMarkFatal(stream, DmtxErrorOutOfBounds);
+   }
+}
+
+/**
+ * append several words at once, returning where the caller should write them
+ * used for multi-word chunks and padding
+ */
+static DmtxByte *
+StreamOutputChainReserve(DmtxEncodeStream *stream, int count)
+{
+   DmtxByte *reserved;
    DmtxPassFail passFail;
 
-   dmtxByteListPush(stream->output, value, &passFail);
+   reserved = dmtxByteListReserve(stream->output, count, &passFail);
 
    if(passFail == DmtxPass)
-      stream->outputChainWordCount++;
+      stream->outputChainWordCount += count;
    else
       StreamMarkFatal(stream, DmtxErrorOutOfBounds);
+
+   return reserved;
 }
 
 /**
@@ -117,11 +117,10 @@ static DmtxByte
 StreamOutputChainRemoveLast(DmtxEncodeStream *stream)
 {
    DmtxByte value;
-   DmtxPassFail passFail;
 
    if(stream->outputChainWordCount > 0)
    {
-      value = dmtxByteListPop(stream->output, &passFail);
+      value = DMTX_BYTELIST_POP(stream->output);
       stream->outputChainWordCount--;
    }
    else
@@ -0,0 +1,389 @@
+/**
+ * libdmtx - Data Matrix Encoding/Decoding Library
+ * Copyright 2011 Mike Laughton. All rights reserved.
+ *
+ * See LICENSE file in the main project directory for full
+ * terms of use and distribution.
+ *
+ * Contact: Mike Laughton <mike@dragonflylogic.com>
+ *
+ * \file dmtxencodetemplate.c
+ * \brief Incremental encoding of labels that share a fixed prefix
+ */
+
+/**
+ * Encoders look at most this many values past the end of a chunk (X12 checks
+ * for a final partial triplet, EDIFACT for an ASCII finish in 3 codewords).
+ * Prefix chunks ending at least this far from the end of the prefix produce
+ * the same codewords no matter what follows.
+ */
+#define DmtxTemplateLookAhead           6
+
+/**
+ * \brief  Create template for labels that all begin with the same prefix
+ * \param  enc Encode settings to use (scheme, size request, and image layout)
+ * \param  prefixSize
+ * \param  prefix
+ * \return Initialized DmtxEncodeTemplate struct, or NULL on error
+ *
+ * Settings are copied, so enc may be changed or destroyed afterward. With a
+ * single encodation scheme the prefix is encoded once here; the automatic
+ * schemes choose between schemes across the whole input and so re-encode the
+ * prefix for every label, still saving the remaining steps.
+ */
+DmtxEncodeTemplate *
+dmtxEncodeTemplateCreate(DmtxEncode *enc, int prefixSize, unsigned char *prefix)
+{
+   DmtxEncodeTemplate *tpl;
+   DmtxByte *inputStorage, *prefixStorage;
+
+   if(enc == NULL || prefixSize < 0 || (prefix == NULL && prefixSize > 0))
+      return NULL;
+
+   /* Template and everything in it come from the allocator of enc */
+   tpl = (DmtxEncodeTemplate *)AllocCalloc(&(enc->allocator), 1, sizeof(DmtxEncodeTemplate));
+   if(tpl == NULL)
+      return NULL;
+
+   tpl->enc = dmtxEncodeCreateWithAllocator(&(enc->allocator));
+   inputStorage = (DmtxByte *)AllocMalloc(&(enc->allocator), prefixSize + 1);
+   prefixStorage = (DmtxByte *)AllocMalloc(&(enc->allocator), 4096);
+   if(tpl->enc == NULL || inputStorage == NULL || prefixStorage == NULL) {
+      AllocFree(&(enc->allocator), inputStorage);
+      AllocFree(&(enc->allocator), prefixStorage);
+      dmtxEncodeDestroy(&(tpl->enc));
+      AllocFree(&(enc->allocator), tpl);
+      return NULL;
+   }
+
+   /* Copy all settings but not the image and message of a previous encode */
+   EncodeCopySettings(tpl->enc, enc);
+
+   tpl->input = dmtxByteListBuild(inputStorage, prefixSize + 1);
+   tpl->prefixOutput = dmtxByteListBuild(prefixStorage, 4096);
+   tpl->prefixSize = prefixSize;
+   tpl->sizeIdx = DmtxUndefined;
+
+   memcpy(tpl->input.b, prefix, prefixSize);
+   tpl->input.length = prefixSize;
+
+   EncodeTemplatePrefix(tpl);
+
+   return tpl;
+}
+
+/**
+ * \brief  Deinitialize template struct
+ * \param  tpl
+ * \return DmtxPass | DmtxFail
+ */
+DmtxPassFail
+dmtxEncodeTemplateDestroy(DmtxEncodeTemplate **tpl)
+{
+   DmtxAllocator allocator;
+
+   if(tpl == NULL || *tpl == NULL)
+      return DmtxFail;
+
+   allocator = (*tpl)->enc->allocator;
+   dmtxEncodeDestroy(&((*tpl)->enc));
+
+   AllocFree(&allocator, (*tpl)->input.b);
+   AllocFree(&allocator, (*tpl)->prefixOutput.b);
+   AllocFree(&allocator, (*tpl)->placement);
+   AllocFree(&allocator, (*tpl)->parity);
+   AllocFree(&allocator, *tpl);
+
+   *tpl = NULL;
+
+   return DmtxPass;
+}
+
+/**
+ * \brief  Convert prefix plus variable part into Data Matrix image
+ *
+ * Result is left in tpl->enc->image and tpl->enc->message, as with
+ * dmtxEncodeDataMatrix(). While the symbol size stays the same, only data
+ * codewords that differ from the previous label are updated, along with the
+ * error codewords they feed and the modules of every codeword that changed.
+ * Everything else, including the rendered finder pattern, is reused.
+ *
+ * \param  tpl
+ * \param  inputSize Size of variable part
+ * \param  inputString Variable part following prefix
+ * \return DmtxPass | DmtxFail
+ */
+DmtxPassFail
+dmtxEncodeTemplateDataMatrix(DmtxEncodeTemplate *tpl, int inputSize, unsigned char *inputString)
+{
+   int i, bit, sizeIdx;
+   int symbolDataWords, codeSize;
+   int moduleIdx, moduleStatus;
+   DmtxBoolean renderModules;
+   DmtxByte value, changed, *storage;
+   DmtxByte codePrev[DmtxMaxCodeWords];
+   DmtxByte outputStorage[4096];
+   unsigned char pixel[DmtxModuleOnRGB + 1][4];
+   DmtxPassFail passFail;
+   DmtxEncode *enc;
+   DmtxMessage *message;
+   DmtxByteList output = dmtxByteListBuild(outputStorage, sizeof(outputStorage));
+
+   if(tpl == NULL || inputSize < 0 || (inputString == NULL && inputSize > 0))
+      return DmtxFail;
+
+   enc = tpl->enc;
+
+   /* Grow input storage to hold prefix and variable part */
+   if(tpl->prefixSize + inputSize > tpl->input.capacity) {
+      storage = (DmtxByte *)AllocRealloc(&(enc->allocator), tpl->input.b, tpl->prefixSize + inputSize);
+      if(storage == NULL)
+         return DmtxFail;
+      tpl->input.b = storage;
+      tpl->input.capacity = tpl->prefixSize + inputSize;
+   }
+
+   tpl->input.length = tpl->prefixSize;
+   dmtxByteListAppend(&(tpl->input), inputString, inputSize, &passFail);
+   if(passFail == DmtxFail)
+      return DmtxFail;
+
+   sizeIdx = EncodeTemplateCodewords(tpl, &output);
+   if(sizeIdx == DmtxUndefined)
+      return DmtxFail;
+
+   /* First label, or variable part moved symbol to a different size */
+   if(sizeIdx != tpl->sizeIdx || enc->message == NULL || enc->image == NULL)
+      return EncodeTemplateRebuild(tpl, sizeIdx);
+
+   message = enc->message;
+   symbolDataWords = dmtxGetSymbolAttribute(DmtxSymAttribSymbolDataWords, sizeIdx);
+   codeSize = message->codeSize;
+
+   memcpy(codePrev, message->code, codeSize);
+
+   /* Fold changed data codewords into the error codewords */
+   for(i = 0; i < symbolDataWords; i++) {
+      value = (i < output.length) ? output.b[i] : 0;
+      if(value == message->code[i])
+         continue;
+
+      RsUpdateParity(message, sizeIdx, tpl->parity, i, (DmtxByte)(value ^ message->code[i]));
+      message->code[i] = value;
+   }
+
+   renderModules = (enc->image->bitsPerPixel == 1 ||
+         BuildPatternPixels(enc->image, pixel) == DmtxPass) ? DmtxTrue : DmtxFalse;
+
+   /* Flip modules of changed codeword bits */
+   for(i = 0; i < codeSize; i++) {
+      changed = message->code[i] ^ codePrev[i];
+      if(changed == 0)
+         continue;
+
+      for(bit = 0; bit < 8; bit++) {
+         if(!(changed & (0x01 << bit)))
+            continue;
+
+         moduleIdx = tpl->placement[i * 8 + bit];
+         moduleStatus = (message->code[i] & (0x01 << bit)) ? DmtxModuleOnRGB : DmtxModuleOff;
+         message->array[moduleIdx] = (message->array[moduleIdx] & ~DmtxModuleOnRGB) | moduleStatus;
+
+         if(renderModules == DmtxTrue)
+            EncodeTemplateRenderModule(enc->image, pixel, moduleIdx, moduleStatus,
+                  sizeIdx, enc->moduleSize, enc->marginSize);
+      }
+   }
+
+   /* Packings without a per-module fast path are redrawn in full */
+   if(renderModules == DmtxFalse)
+      return RenderPattern(enc->image, message, sizeIdx, enc->moduleSize, enc->marginSize);
+
+   return DmtxPass;
+}
+
+/**
+ * \brief  Encode the prefix chunks that can't depend on the variable part
+ * \param  tpl
+ * \return void
+ */
+static void
+EncodeTemplatePrefix(DmtxEncodeTemplate *tpl)
+{
+   int i, chunkCount;
+   DmtxEncode *enc;
+   DmtxEncodeStream stream;
+
+   enc = tpl->enc;
+   dmtxByteListClear(&(tpl->prefixOutput));
+   tpl->prefixStream = StreamInit(&(tpl->input), &(tpl->prefixOutput));
+
+   if(enc->scheme == DmtxSchemeAutoBest || enc->scheme == DmtxSchemeAutoFast)
+      return;
+
+   /*
+    * Count chunks ending far enough from the end of the prefix. Later chunks
+    * can revisit earlier output (e.g., Base 256 length headers), so the
+    * counted chunks are then encoded again from scratch.
+    */
+   stream = tpl->prefixStream;
+   for(chunkCount = 0; stream.status == DmtxStatusEncoding; chunkCount++) {
+      EncodeNextChunk(&stream, enc->scheme, DmtxEncodeNormal, enc->sizeIdxRequest);
+      if(stream.status != DmtxStatusEncoding ||
+            tpl->prefixSize - stream.inputNext < DmtxTemplateLookAhead)
+         break;
+   }
+
+   dmtxByteListClear(&(tpl->prefixOutput));
+   for(i = 0; i < chunkCount; i++)
+      EncodeNextChunk(&(tpl->prefixStream), enc->scheme, DmtxEncodeNormal, enc->sizeIdxRequest);
+}
+
+/**
+ * \brief  Encode current input into data codewords, resuming after prefix
+ * \param  tpl
+ * \param  output Receives data codewords
+ * \return Symbol size index, or DmtxUndefined if input does not fit
+ */
+static int
+EncodeTemplateCodewords(DmtxEncodeTemplate *tpl, DmtxByteList *output)
+{
+   int sizeIdx;
+   DmtxPassFail passFail;
+   DmtxEncode *enc;
+   DmtxEncodeStream stream;
+
+   enc = tpl->enc;
+
+   if(enc->scheme == DmtxSchemeAutoBest || enc->scheme == DmtxSchemeAutoFast) {
+      sizeIdx = EncodeDataCodewords(&(tpl->input), output, enc->sizeIdxRequest, enc->scheme,
+            &(enc->allocator));
+   }
+   else {
+      dmtxByteListCopy(output, &(tpl->prefixOutput), &passFail);
+      if(passFail == DmtxFail)
+         return DmtxUndefined;
+
+      stream = tpl->prefixStream;
+      stream.input = &(tpl->input);
+      stream.output = output;
+
+      while(stream.status == DmtxStatusEncoding)
+         EncodeNextChunk(&stream, enc->scheme, DmtxEncodeNormal, enc->sizeIdxRequest);
+
+      if(stream.status != DmtxStatusComplete || StreamInputHasNext(&stream))
+         return DmtxUndefined;
+
+      sizeIdx = stream.sizeIdx;
+   }
+
+   if(sizeIdx == DmtxUndefined || output->length <= 0)
+      return DmtxUndefined;
+
+   return sizeIdx;
+}
+
+/**
+ * \brief  Encode current input in full and cache tables for its symbol size
+ * \param  tpl
+ * \param  sizeIdx Symbol size expected for current input
+ * \return DmtxPass | DmtxFail
+ */
+static DmtxPassFail
+EncodeTemplateRebuild(DmtxEncodeTemplate *tpl, int sizeIdx)
+{
+   int *placement;
+   DmtxByte *parity;
+   const DmtxSymbolInfo *info;
+
+   tpl->sizeIdx = DmtxUndefined;
+
+   info = dmtxGetSymbolInfo(sizeIdx);
+   if(info == NULL)
+      return DmtxFail;
+
+   placement = (int *)AllocRealloc(&(tpl->enc->allocator), tpl->placement, sizeof(int) * 8 *
+         (info->symbolDataWords + info->symbolErrorWords));
+   if(placement == NULL)
+      return DmtxFail;
+   tpl->placement = placement;
+
+   parity = (DmtxByte *)AllocRealloc(&(tpl->enc->allocator), tpl->parity,
+         info->blockDataWords[0] * info->blockErrorWords);
+   if(parity == NULL)
+      return DmtxFail;
+   tpl->parity = parity;
+
+   ModulePlacementMap(tpl->placement, sizeIdx);
+   if(RsParityTable(tpl->parity, sizeIdx) == DmtxFail)
+      return DmtxFail;
+
+   if(dmtxEncodeDataMatrix(tpl->enc, tpl->input.length, tpl->input.b) == DmtxFail ||
+         tpl->enc->region.sizeIdx != sizeIdx) {
+      EncodeRelease(tpl->enc);
+      return DmtxFail;
+   }
+
+   tpl->sizeIdx = sizeIdx;
+
+   return DmtxPass;
+}
+
+/**
+ * \brief  Redraw a single data module
+ * \param  img Image rendered by RenderPatternRows()
+ * \param  pixel Pixel bytes from BuildPatternPixels() (unused for 1bpp)
+ * \param  moduleIdx Position of module in mapping matrix
+ * \param  moduleStatus DmtxModuleOnRGB or DmtxModuleOff
+ * \param  sizeIdx
+ * \param  moduleSize
+ * \param  marginSize
+ * \return void
+ */
+static void
+EncodeTemplateRenderModule(DmtxImage *img, unsigned char pixel[][4], int moduleIdx,
+      int moduleStatus, int sizeIdx, int moduleSize, int marginSize)
+{
+   int i, j;
+   int mappingRow, mappingCol;
+   int symbolRow, symbolCol;
+   int x, y, runBytes;
+   unsigned char *ptr, *run;
+   const DmtxSymbolInfo *info;
+
+   info = dmtxGetSymbolInfo(sizeIdx);
+
+   /* Inverse of the mapping in dmtxSymbolModuleStatus() */
+   mappingRow = moduleIdx / info->mappingCols;
+   mappingCol = moduleIdx % info->mappingCols;
+   symbolRow = info->symbolRows - 2 - mappingRow - 2 * (mappingRow / info->dataRegionRows);
+   symbolCol = mappingCol + 1 + 2 * (mappingCol / info->dataRegionCols);
+
+   x = marginSize + symbolCol * moduleSize;
+   y = marginSize + symbolRow * moduleSize;
+
+   if(img->bitsPerPixel == 1) {
+      for(i = y; i < y + moduleSize; i++) {
+         if(moduleStatus & DmtxModuleOnRed)
+            ClearBitRun(PatternRowPtr(img, i), x, moduleSize);
+         else
+            SetBitRun(PatternRowPtr(img, i), x, moduleSize);
+      }
+      return;
+   }
+
+   /* Compose first pixel row of module, then replicate it */
+   runBytes = moduleSize * img->bytesPerPixel;
+   run = PatternRowPtr(img, y) + x * img->bytesPerPixel;
+
+   if(memcmp(pixel[moduleStatus], pixel[moduleStatus] + 1, img->bytesPerPixel - 1) == 0) {
+      memset(run, pixel[moduleStatus][0], runBytes);
+   }
+   else {
+      for(j = 0, ptr = run; j < moduleSize; j++, ptr += img->bytesPerPixel)
+         memcpy(ptr, pixel[moduleStatus], img->bytesPerPixel);
+   }
+
+   for(i = y + 1; i < y + moduleSize; i++)
+      memcpy(PatternRowPtr(img, i) + x * img->bytesPerPixel, run, runBytes);
+}
@@ -0,0 +1,347 @@
+/**
+ * libdmtx - Data Matrix Encoding/Decoding Library
+ * Copyright 2011 Mike Laughton. All rights reserved.
+ *
+ * See LICENSE file in the main project directory for full
+ * terms of use and distribution.
+ *
+ * Contact: Mike Laughton <mike@dragonflylogic.com>
+ *
+ * \file dmtxencodewrite.c
+ * \brief Streaming symbols straight to PBM, PGM, and PNG files
+ */
+
+#if defined(HAVE_ZLIB_H)
+
+#include <zlib.h>
+
+#define DmtxPngChunkSize          8192 /* Deflated bytes per IDAT chunk */
+
+#endif
+
+/**
+ * \brief  Encode a message and stream it out as an image file
+ *
+ * The symbol is encoded into a packed module bitmap and written one scanline
+ * at a time, so memory use is a single scanline no matter how large the
+ * image. Each module row is composed once and repeated moduleSize times.
+ * Output uses the scheme, size request, module size, and margin size of enc;
+ * pixel packing and image flip don't apply since every format defines its
+ * own. PBM and PGM output is binary ("P4" and "P5"), and PNG output is 1-bit
+ * grayscale, which is only available when built with zlib.
+ *
+ * \param  enc
+ * \param  inputSize
+ * \param  inputString
+ * \param  format DmtxFormatPbm | DmtxFormatPgm | DmtxFormatPng
+ * \param  callback Receives output bytes in order
+ * \param  userData Passed to callback
+ * \return DmtxPass | DmtxFail
+ */
+DmtxPassFail
+dmtxEncodeWrite(DmtxEncode *enc, int inputSize, unsigned char *inputString,
+      int format, DmtxWriteCallback callback, void *userData)
+{
+   DmtxPassFail passFail;
+   DmtxImageWriter writer;
+
+   if(enc == NULL || callback == NULL || enc->moduleSize < 1 || enc->marginSize < 0)
+      return DmtxFail;
+
+#if !defined(HAVE_ZLIB_H)
+   if(format == DmtxFormatPng)
+      return DmtxFail;
+#endif
+
+   if(format != DmtxFormatPbm && format != DmtxFormatPgm && format != DmtxFormatPng)
+      return DmtxFail;
+
+   if(dmtxEncodeModules(enc, inputSize, inputString, writer.modules,
+         sizeof(writer.modules), &writer.rows, &writer.cols) == DmtxFail)
+      return DmtxFail;
+
+   writer.format = format;
+   writer.moduleSize = enc->moduleSize;
+   writer.marginSize = enc->marginSize;
+   writer.width = 2 * writer.marginSize + writer.cols * writer.moduleSize;
+   writer.height = 2 * writer.marginSize + writer.rows * writer.moduleSize;
+   writer.rowBytes = (format == DmtxFormatPgm) ? writer.width : (writer.width + 7)/8;
+   writer.callback = callback;
+   writer.userData = userData;
+
+   /* One extra byte in front holds the PNG filter type */
+   writer.row = (unsigned char *)AllocMalloc(&(enc->allocator), writer.rowBytes + 1);
+   if(writer.row == NULL)
+      return DmtxFail;
+
+   writer.row[0] = 0x00;
+
+#if defined(HAVE_ZLIB_H)
+   if(format == DmtxFormatPng)
+      passFail = WritePng(&writer);
+   else
+#endif
+      passFail = WritePnm(&writer);
+
+   AllocFree(&(enc->allocator), writer.row);
+
+   return passFail;
+}
+
+/**
+ * \brief  Encode a message and write it to an image file
+ * \param  enc
+ * \param  inputSize
+ * \param  inputString
+ * \param  format DmtxFormatPbm | DmtxFormatPgm | DmtxFormatPng
+ * \param  path Destination file, replaced if it exists
+ * \return DmtxPass | DmtxFail
+ */
+DmtxPassFail
+dmtxEncodeWriteFile(DmtxEncode *enc, int inputSize, unsigned char *inputString,
+      int format, const char *path)
+{
+   DmtxPassFail passFail;
+   FILE *fp;
+
+   if(path == NULL)
+      return DmtxFail;
+
+   fp = fopen(path, "wb");
+   if(fp == NULL)
+      return DmtxFail;
+
+   passFail = dmtxEncodeWrite(enc, inputSize, inputString, format, WriteFile, fp);
+
+   if(fclose(fp) != 0)
+      passFail = DmtxFail;
+
+   return passFail;
+}
+
+/**
+ * \brief  Write callback for dmtxEncodeWriteFile()
+ * \param  data
+ * \param  size
+ * \param  userData Destination FILE
+ * \return DmtxPass | DmtxFail
+ */
+static DmtxPassFail
+WriteFile(const unsigned char *data, int size, void *userData)
+{
+   if(fwrite(data, 1, size, (FILE *)userData) != (size_t)size)
+      return DmtxFail;
+
+   return DmtxPass;
+}
+
+/**
+ * \brief  Write symbol as binary PBM or PGM
+ * \param  writer
+ * \return DmtxPass | DmtxFail
+ */
+static DmtxPassFail
+WritePnm(DmtxImageWriter *writer)
+{
+   int ty, headerBytes;
+   char header[64];
+
+   headerBytes = sprintf(header, "%s\n%d %d\n%s", (writer->format == DmtxFormatPbm) ?
+         "P4" : "P5", writer->width, writer->height, (writer->format == DmtxFormatPbm) ?
+         "" : "255\n");
+
+   if((*writer->callback)((unsigned char *)header, headerBytes, writer->userData) == DmtxFail)
+      return DmtxFail;
+
+   for(ty = 0; ty < writer->height; ty++) {
+      WriteComposeRow(writer, ty);
+      if((*writer->callback)(writer->row + 1, writer->rowBytes, writer->userData) == DmtxFail)
+         return DmtxFail;
+   }
+
+   return DmtxPass;
+}
+
+#if defined(HAVE_ZLIB_H)
+
+/**
+ * \brief  Write symbol as 1-bit grayscale PNG
+ *
+ * Scanlines are deflated as they are produced and each full output buffer
+ * goes out as its own IDAT chunk, so the compressed image is never held in
+ * memory either.
+ *
+ * \param  writer
+ * \return DmtxPass | DmtxFail
+ */
+static DmtxPassFail
+WritePng(DmtxImageWriter *writer)
+{
+   int ty, err;
+   DmtxPassFail passFail;
+   z_stream stream;
+   unsigned char ihdr[13];
+   unsigned char chunk[DmtxPngChunkSize];
+   static const unsigned char signature[] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+
+   if((*writer->callback)(signature, sizeof(signature), writer->userData) == DmtxFail)
+      return DmtxFail;
+
+   WritePngUint32(ihdr, writer->width);
+   WritePngUint32(ihdr + 4, writer->height);
+   ihdr[8] = 1;  /* bit depth */
+   ihdr[9] = 0;  /* grayscale */
+   ihdr[10] = 0; /* deflate */
+   ihdr[11] = 0; /* adaptive filtering */
+   ihdr[12] = 0; /* no interlace */
+
+   if(WritePngChunk(writer, "IHDR", ihdr, sizeof(ihdr)) == DmtxFail)
+      return DmtxFail;
+
+   memset(&stream, 0x00, sizeof(z_stream));
+   if(deflateInit(&stream, Z_DEFAULT_COMPRESSION) != Z_OK)
+      return DmtxFail;
+
+   stream.next_out = chunk;
+   stream.avail_out = sizeof(chunk);
+   passFail = DmtxPass;
+
+   /* Each scanline is preceded by its filter type (none) */
+   for(ty = 0; ty <= writer->height && passFail == DmtxPass; ty++) {
+      if(ty < writer->height) {
+         WriteComposeRow(writer, ty);
+         stream.next_in = writer->row;
+         stream.avail_in = writer->rowBytes + 1;
+      }
+
+      do {
+         err = deflate(&stream, (ty < writer->height) ? Z_NO_FLUSH : Z_FINISH);
+         if(err == Z_STREAM_ERROR) {
+            passFail = DmtxFail;
+            break;
+         }
+
+         if(stream.avail_out == 0 || err == Z_STREAM_END) {
+            passFail = WritePngChunk(writer, "IDAT", chunk, sizeof(chunk) - stream.avail_out);
+            stream.next_out = chunk;
+            stream.avail_out = sizeof(chunk);
+         }
+      } while(passFail == DmtxPass && (stream.avail_in > 0 ||
+            (ty == writer->height && err != Z_STREAM_END)));
+   }
+
+   deflateEnd(&stream);
+
+   if(passFail == DmtxFail)
+      return DmtxFail;
+
+   return WritePngChunk(writer, "IEND", NULL, 0);
+}
+
+/**
+ * \brief  Write one PNG chunk with its length and CRC
+ * \param  writer
+ * \param  type Four character chunk type
+ * \param  data
+ * \param  size
+ * \return DmtxPass | DmtxFail
+ */
+static DmtxPassFail
+WritePngChunk(DmtxImageWriter *writer, const char *type, const unsigned char *data, int size)
+{
+   unsigned long crc;
+   unsigned char prefix[8], suffix[4];
+
+   WritePngUint32(prefix, size);
+   memcpy(prefix + 4, type, 4);
+
+   crc = crc32(0L, prefix + 4, 4);
+   if(size > 0)
+      crc = crc32(crc, data, size);
+   WritePngUint32(suffix, crc);
+
+   if((*writer->callback)(prefix, sizeof(prefix), writer->userData) == DmtxFail ||
+         (size > 0 && (*writer->callback)(data, size, writer->userData) == DmtxFail) ||
+         (*writer->callback)(suffix, sizeof(suffix), writer->userData) == DmtxFail)
+      return DmtxFail;
+
+   return DmtxPass;
+}
+
+/**
+ * \brief  Store 32-bit value in PNG (big-endian) byte order
+ * \param  buf
+ * \param  value
+ * \return void
+ */
+static void
+WritePngUint32(unsigned char *buf, unsigned long value)
+{
+   buf[0] = (unsigned char)((value >> 24) & 0xff);
+   buf[1] = (unsigned char)((value >> 16) & 0xff);
+   buf[2] = (unsigned char)((value >> 8) & 0xff);
+   buf[3] = (unsigned char)(value & 0xff);
+}
+
+#endif
+
+/**
+ * \brief  Compose scanline ty (counted from top) in writer->row
+ *
+ * Scanlines within the same module row, and all quiet zone scanlines, are
+ * identical, so the row is only rebuilt when ty starts a new one.
+ *
+ * \param  writer
+ * \param  ty
+ * \return void
+ */
+static void
+WriteComposeRow(DmtxImageWriter *writer, int ty)
+{
+   int col, x, moduleRow;
+   unsigned char *row, *modules;
+
+   moduleRow = WriteRowKey(writer, ty);
+   if(ty > 0 && moduleRow == WriteRowKey(writer, ty - 1))
+      return;
+
+   /* PBM marks dark pixels with set bits, PNG (grayscale) with clear bits */
+   row = writer->row + 1;
+   memset(row, (writer->format == DmtxFormatPbm) ? 0x00 : 0xff, writer->rowBytes);
+
+   if(moduleRow == DmtxUndefined)
+      return;
+
+   modules = writer->modules + moduleRow * ((writer->cols + 7)/8);
+   x = writer->marginSize;
+
+   for(col = 0; col < writer->cols; col++, x += writer->moduleSize) {
+      if(!(modules[col >> 3] & (0x80 >> (col & 0x07))))
+         continue;
+
+      if(writer->format == DmtxFormatPbm)
+         SetBitRun(row, x, writer->moduleSize);
+      else if(writer->format == DmtxFormatPng)
+         ClearBitRun(row, x, writer->moduleSize);
+      else
+         memset(row + x, 0x00, writer->moduleSize);
+   }
+}
+
+/**
+ * \brief  Find symbol module row shown by scanline ty (counted from top)
+ * \param  writer
+ * \param  ty
+ * \return Module row, or DmtxUndefined within quiet zone
+ */
+static int
+WriteRowKey(DmtxImageWriter *writer, int ty)
+{
+   int offset;
+
+   offset = ty - writer->marginSize;
+   if(offset < 0 || offset >= writer->rows * writer->moduleSize)
+      return DmtxUndefined;
+
+   return offset / writer->moduleSize;
+}
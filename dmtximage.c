@@ -44,6 +44,10 @@
  *
  *                    (0,0)              (WIDTH-1,0)
  *
+ * 1bpp images (DmtxPack1bppK) pack 8 pixels per byte with the leftmost pixel
+ * in the most significant bit. A set bit is white (255) and a clear bit is
+ * black (0). Each row starts on a byte boundary.
+ *
  * Notes:
  *   - OpenGL pixel arrays obtained with glReadPixels() are stored
  *     bottom-to-top; use DmtxFlipY
@@ -59,16 +63,59 @@
 DmtxImage *
 dmtxImageCreate(unsigned char *pxl, int width, int height, int pack)
 {
-   DmtxPassFail err;
+   return dmtxImageCreateWithAllocator(pxl, width, height, pack, NULL);
+}
+
+/**
+ * \brief  Create image struct through given allocator
+ * \param  pxl Pixels, still owned by caller
+ * \param  width
+ * \param  height
+ * \param  pack
+ * \param  allocator Used for the struct, or NULL for the global allocator
+ * \return Initialized DmtxImage struct
+ */
+DmtxImage *
+dmtxImageCreateWithAllocator(unsigned char *pxl, int width, int height, int pack,
+      const DmtxAllocator *allocator)
+{
    DmtxImage *img;
 
    if(pxl == NULL || width < 1 || height < 1)
       return NULL;
 
-   img = (DmtxImage *)calloc(1, sizeof(DmtxImage));
+   allocator = AllocSelect(allocator);
+
+   img = (DmtxImage *)AllocCalloc(allocator, 1, sizeof(DmtxImage));
    if(img == NULL)
       return NULL;
 
+   if(ImageInit(img, pxl, width, height, pack) == DmtxFail) {
+      AllocFree(allocator, img);
+      return NULL;
+   }
+
+   img->allocator = *allocator;
+
+   return img;
+}
+
+/**
+ * \brief  Initialize caller-owned image struct without allocating memory
+ * \param  img
+ * \param  pxl
+ * \param  width
+ * \param  height
+ * \param  pack
+ * \return DmtxPass | DmtxFail (unsupported packing order)
+ */
+static DmtxPassFail
+ImageInit(DmtxImage *img, unsigned char *pxl, int width, int height, int pack)
+{
+   DmtxPassFail err;
+
+   memset(img, 0x00, sizeof(DmtxImage));
+
    img->pxl = pxl;
    img->width = width;
    img->height = height;
@@ -76,10 +123,10 @@ dmtxImageCreate(unsigned char *pxl, int width, int height, int pack)
    img->bitsPerPixel = GetBitsPerPixel(pack);
    img->bytesPerPixel = img->bitsPerPixel/8;
    img->rowPadBytes = 0;
-   img->rowSizeBytes = img->width * img->bytesPerPixel + img->rowPadBytes;
+   img->rowSizeBytes = (img->width * img->bitsPerPixel + 7)/8 + img->rowPadBytes;
    img->imageFlip = DmtxFlipNone;
 
-   /* Leave channelStart[] and bitsPerChannel[] with zeros from calloc */
+   /* Leave channelStart[] and bitsPerChannel[] with zeros from memset */
    img->channelCount = 0;
 
    switch(pack) {
@@ -87,8 +134,7 @@ dmtxImageCreate(unsigned char *pxl, int width, int height, int pack)
          break;
       case DmtxPack1bppK:
          err = dmtxImageSetChannel(img, 0, 1);
-         return NULL; /* unsupported packing order */
-/*       break; */
+         break;
       case DmtxPack8bppK:
          err = dmtxImageSetChannel(img, 0, 8);
          break;
@@ -133,10 +179,10 @@ dmtxImageCreate(unsigned char *pxl, int width, int height, int pack)
          err = dmtxImageSetChannel(img, 24, 8);
          break;
       default:
-         return NULL;
+         return DmtxFail;
    }
 
-   return img;
+   return DmtxPass;
 }
 
 /**
@@ -150,7 +196,7 @@ dmtxImageDestroy(DmtxImage **img)
    if(img == NULL || *img == NULL)
       return DmtxFail;
 
-   free(*img);
+   AllocFree(&((*img)->allocator), *img);
 
    *img = NULL;
 
@@ -192,7 +238,7 @@ dmtxImageSetProp(DmtxImage *img, int prop, int value)
    switch(prop) {
       case DmtxPropRowPadBytes:
          img->rowPadBytes = value;
-         img->rowSizeBytes = img->width * (img->bitsPerPixel/8) + img->rowPadBytes;
+         img->rowSizeBytes = (img->width * img->bitsPerPixel + 7)/8 + img->rowPadBytes;
          break;
       case DmtxPropImageFlip:
          img->imageFlip = value;
@@ -257,6 +303,13 @@ dmtxImageGetByteOffset(DmtxImage *img, int x, int y)
    if(dmtxImageContainsInt(img, 0, x, y) == DmtxFalse)
       return DmtxUndefined;
 
+   if(img->bitsPerPixel == 1) {
+      if(img->imageFlip & DmtxFlipY)
+         return (y * img->rowSizeBytes + (x >> 3));
+
+      return ((img->height - y - 1) * img->rowSizeBytes + (x >> 3));
+   }
+
    if(img->imageFlip & DmtxFlipY)
       return (y * img->rowSizeBytes + x * img->bytesPerPixel);
 
@@ -285,9 +338,8 @@ dmtxImageGetPixelValue(DmtxImage *img, int x, int y, int channel, int *value)
 
    switch(img->bitsPerChannel[channel]) {
       case 1:
-/*       assert(img->bitsPerPixel == 1);
-         mask = 0x01 << (7 - offset%8);
-         *value = (img->pxl[offset/8] & mask) ? 255 : 0; */
+         assert(img->bitsPerPixel == 1);
+         *value = (img->pxl[offset] & (0x80 >> (x & 0x07))) ? 255 : 0;
          break;
       case 5:
          /* XXX might be expensive if we want to scale perfect 0-255 range */
@@ -301,7 +353,7 @@ dmtxImageGetPixelValue(DmtxImage *img, int x, int y, int channel, int *value)
       case 8:
          assert(img->channelStart[channel] % 8 == 0);
          assert(img->bitsPerPixel % 8 == 0);
-         *value = img->pxl[offset + channel];
+         *value = img->pxl[offset + img->channelStart[channel]/8];
          break;
    }
 
@@ -330,9 +382,11 @@ dmtxImageSetPixelValue(DmtxImage *img, int x, int y, int channel, int value)
 
    switch(img->bitsPerChannel[channel]) {
       case 1:
-/*       assert(img->bitsPerPixel == 1);
-         mask = 0x01 << (7 - offset%8);
-         *value = (img->pxl[offset/8] & mask) ? 255 : 0; */
+         assert(img->bitsPerPixel == 1);
+         if(value >= 128)
+            img->pxl[offset] |= (0x80 >> (x & 0x07));
+         else
+            img->pxl[offset] &= ~(0x80 >> (x & 0x07));
          break;
       case 5:
          /* XXX might be expensive if we want to scale perfect 0-255 range */
@@ -346,7 +400,7 @@ dmtxImageSetPixelValue(DmtxImage *img, int x, int y, int channel, int value)
       case 8:
          assert(img->channelStart[channel] % 8 == 0);
          assert(img->bitsPerPixel % 8 == 0);
-         img->pxl[offset + channel] = value;
+         img->pxl[offset + img->channelStart[channel]/8] = value;
          break;
    }
 
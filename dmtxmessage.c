@@ -19,79 +19,150 @@
  */
 DmtxMessage *
 dmtxMessageCreate(int sizeIdx, int symbolFormat)
+{
+   return MessageCreate(sizeIdx, symbolFormat, NULL, NULL);
+}
+
+/**
+ * \brief  Free memory previously allocated for message
+ * \param  message
+ * \return void
+ */
+DmtxPassFail
+dmtxMessageDestroy(DmtxMessage **msg)
+{
+   DmtxAllocator allocator;
+
+   if(msg == NULL || *msg == NULL)
+      return DmtxFail;
+
+   /* Arena messages are a single block */
+   if((*msg)->arena != NULL) {
+      ArenaFree((*msg)->arena, *msg, sizeof(DmtxMessage) + (*msg)->arraySize +
+            (*msg)->codeSize + (*msg)->outputSize);
+      *msg = NULL;
+      return DmtxPass;
+   }
+
+   allocator = (*msg)->allocator;
+
+   AllocFree(&allocator, (*msg)->array);
+   AllocFree(&allocator, (*msg)->code);
+   AllocFree(&allocator, (*msg)->output);
+   AllocFree(&allocator, *msg);
+
+   *msg = NULL;
+
+   return DmtxPass;
+}
+
+/**
+ * \brief  Prepare a matrix message over caller-provided storage
+ * \param  message
+ * \param  sizeIdx
+ * \param  array Module storage of at least DmtxMaxMappingArea bytes
+ * \param  code Codeword storage of at least DmtxMaxCodeWords bytes
+ * \return DmtxPass | DmtxFail
+ */
+static DmtxPassFail
+MessageInit(DmtxMessage *message, int sizeIdx, unsigned char *array, unsigned char *code)
+{
+   const DmtxSymbolInfo *info;
+
+   info = dmtxGetSymbolInfo(sizeIdx);
+   if(info == NULL)
+      return DmtxFail;
+
+   memset(message, 0x00, sizeof(DmtxMessage));
+   message->arraySize = info->mappingRows * info->mappingCols;
+   message->codeSize = info->symbolDataWords + info->symbolErrorWords;
+   message->array = array;
+   message->code = code;
+   memset(message->array, 0x00, message->arraySize);
+   memset(message->code, 0x00, message->codeSize);
+
+   return DmtxPass;
+}
+
+/**
+ * \brief  Allocate message in arena as one block, or on heap if arena has no room
+ * \param  sizeIdx
+ * \param  symbolFormat DmtxFormatMatrix | DmtxFormatMosaic
+ * \param  arena Decode session arena, or NULL
+ * \param  allocator Used if arena has no room, or NULL for global allocator
+ * \return Address of allocated message
+ */
+static DmtxMessage *
+MessageCreate(int sizeIdx, int symbolFormat, DmtxArena *arena, const DmtxAllocator *allocator)
 {
    DmtxMessage *message;
-   int mappingRows, mappingCols;
+   size_t arraySize, codeSize, outputSize;
+   unsigned char *block;
+   const DmtxSymbolInfo *info;
 
    assert(symbolFormat == DmtxFormatMatrix || symbolFormat == DmtxFormatMosaic);
 
-   mappingRows = dmtxGetSymbolAttribute(DmtxSymAttribMappingMatrixRows, sizeIdx);
-   mappingCols = dmtxGetSymbolAttribute(DmtxSymAttribMappingMatrixCols, sizeIdx);
+   info = dmtxGetSymbolInfo(sizeIdx);
+   if(info == NULL)
+      return NULL;
+
+   arraySize = sizeof(unsigned char) * info->mappingRows * info->mappingCols;
+   codeSize = sizeof(unsigned char) * (info->symbolDataWords + info->symbolErrorWords);
+
+   /* Decoder never writes past outputSize and terminates output itself, so
+      size for the longest possible message and skip zeroing */
+   outputSize = sizeof(unsigned char) * DmtxMaxOutputLength(info->symbolDataWords);
+
+   if(symbolFormat == DmtxFormatMosaic) {
+      codeSize *= 3;
+      outputSize *= 3;
+   }
+
+   block = (unsigned char *)ArenaAlloc(arena, sizeof(DmtxMessage) +
+         arraySize + codeSize + outputSize);
+   if(block != NULL) {
+      message = (DmtxMessage *)block;
+      memset(block, 0x00, sizeof(DmtxMessage) + arraySize + codeSize);
+      message->array = block + sizeof(DmtxMessage);
+      message->code = message->array + arraySize;
+      message->output = message->code + codeSize;
+      message->arraySize = arraySize;
+      message->codeSize = codeSize;
+      message->outputSize = outputSize;
+      message->arena = arena;
+      return message;
+   }
+
+   allocator = AllocSelect(allocator);
 
-   message = (DmtxMessage *)calloc(1, sizeof(DmtxMessage));
+   message = (DmtxMessage *)AllocCalloc(allocator, 1, sizeof(DmtxMessage));
    if(message == NULL)
       return NULL;
 
-   message->arraySize = sizeof(unsigned char) * mappingRows * mappingCols;
-
-   message->array = (unsigned char *)calloc(1, message->arraySize);
+   message->allocator = *allocator;
+   message->arraySize = arraySize;
+   message->array = (unsigned char *)AllocCalloc(allocator, 1, message->arraySize);
    if(message->array == NULL) {
       perror("Calloc failed");
       dmtxMessageDestroy(&message);
       return NULL;
    }
 
-   message->codeSize = sizeof(unsigned char) *
-         dmtxGetSymbolAttribute(DmtxSymAttribSymbolDataWords, sizeIdx) +
-         dmtxGetSymbolAttribute(DmtxSymAttribSymbolErrorWords, sizeIdx);
-
-   if(symbolFormat == DmtxFormatMosaic)
-      message->codeSize *= 3;
-
-   message->code = (unsigned char *)calloc(message->codeSize, sizeof(unsigned char));
+   message->codeSize = codeSize;
+   message->code = (unsigned char *)AllocCalloc(allocator, message->codeSize, sizeof(unsigned char));
    if(message->code == NULL) {
       perror("Calloc failed");
       dmtxMessageDestroy(&message);
       return NULL;
    }
 
-   /* XXX not sure if this is the right place or even the right approach.
-      Trying to allocate memory for the decoded data stream and will
-      initially assume that decoded data will not be larger than 2x encoded data */
-   message->outputSize = sizeof(unsigned char) * message->codeSize * 10;
-   message->output = (unsigned char *)calloc(message->outputSize, sizeof(unsigned char));
+   message->outputSize = outputSize;
+   message->output = (unsigned char *)AllocMalloc(allocator, message->outputSize);
    if(message->output == NULL) {
-      perror("Calloc failed");
+      perror("Malloc failed");
       dmtxMessageDestroy(&message);
       return NULL;
    }
 
    return message;
 }
-
-/**
- * \brief  Free memory previously allocated for message
- * \param  message
- * \return void
- */
-DmtxPassFail
-dmtxMessageDestroy(DmtxMessage **msg)
-{
-   if(msg == NULL || *msg == NULL)
-      return DmtxFail;
-
-   if((*msg)->array != NULL)
-      free((*msg)->array);
-
-   if((*msg)->code != NULL)
-      free((*msg)->code);
-
-   if((*msg)->output != NULL)
-      free((*msg)->output);
-
-   free(*msg);
-
-   *msg = NULL;
-
-   return DmtxPass;
-}
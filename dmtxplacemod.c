@@ -26,11 +26,13 @@ dmtxSymbolModuleStatus(DmtxMessage *message, int sizeIdx, int symbolRow, int sym
    int mappingRow, mappingCol;
    int dataRegionRows, dataRegionCols;
    int symbolRows, mappingCols;
+   const DmtxSymbolInfo *info;
 
-   dataRegionRows = dmtxGetSymbolAttribute(DmtxSymAttribDataRegionRows, sizeIdx);
-   dataRegionCols = dmtxGetSymbolAttribute(DmtxSymAttribDataRegionCols, sizeIdx);
-   symbolRows = dmtxGetSymbolAttribute(DmtxSymAttribSymbolRows, sizeIdx);
-   mappingCols = dmtxGetSymbolAttribute(DmtxSymAttribMappingMatrixCols, sizeIdx);
+   info = dmtxGetSymbolInfo(sizeIdx);
+   dataRegionRows = info->dataRegionRows;
+   dataRegionCols = info->dataRegionCols;
+   symbolRows = info->symbolRows;
+   mappingCols = info->mappingCols;
 
    symbolRowReverse = symbolRows - symbolRow - 1;
    mappingRow = symbolRowReverse - 1 - 2 * (symbolRowReverse / (dataRegionRows+2));
@@ -66,11 +68,13 @@ ModulePlacementEcc200(unsigned char *modules, unsigned char *codewords, int size
 {
    int row, col, chr;
    int mappingRows, mappingCols;
+   const DmtxSymbolInfo *info;
 
    assert(moduleOnColor & (DmtxModuleOnRed | DmtxModuleOnGreen | DmtxModuleOnBlue));
 
-   mappingRows = dmtxGetSymbolAttribute(DmtxSymAttribMappingMatrixRows, sizeIdx);
-   mappingCols = dmtxGetSymbolAttribute(DmtxSymAttribMappingMatrixCols, sizeIdx);
+   info = dmtxGetSymbolInfo(sizeIdx);
+   mappingRows = info->mappingRows;
+   mappingCols = info->mappingCols;
 
    /* Start in the nominal location for the 8th bit of the first character */
    chr = 0;
@@ -124,6 +128,47 @@ ModulePlacementEcc200(unsigned char *modules, unsigned char *codewords, int size
    return chr; /* XXX number of codewords read off */
 }
 
+/**
+ * \brief  Find mapping matrix position of every codeword bit
+ * \param  map Receives 8 positions per codeword, one per bit (LSB first)
+ * \param  sizeIdx
+ * \return void
+ *
+ * Placement reads codewords back out of modules that are already assigned.
+ * Lighting only the modules whose position has bit p set therefore reads bit
+ * p of every codeword bit's position, and one pass per position bit recovers
+ * the whole map.
+ */
+static void
+ModulePlacementMap(int *map, int sizeIdx)
+{
+   int i, bit, pass;
+   int mappingArea, codeSize;
+   unsigned char modules[DmtxMaxMappingArea];
+   unsigned char codewords[DmtxMaxCodeWords];
+   const DmtxSymbolInfo *info;
+
+   info = dmtxGetSymbolInfo(sizeIdx);
+   mappingArea = info->mappingRows * info->mappingCols;
+   codeSize = info->symbolDataWords + info->symbolErrorWords;
+
+   memset(map, 0x00, sizeof(int) * codeSize * 8);
+
+   for(pass = 0; (1 << pass) < mappingArea; pass++) {
+      for(i = 0; i < mappingArea; i++)
+         modules[i] = DmtxModuleAssigned | (((i >> pass) & 0x01) ? DmtxModuleOnRed : 0);
+
+      ModulePlacementEcc200(modules, codewords, sizeIdx, DmtxModuleOnRed);
+
+      for(i = 0; i < codeSize; i++) {
+         for(bit = 0; bit < 8; bit++) {
+            if(codewords[i] & (0x01 << bit))
+               map[i * 8 + bit] |= (1 << pass);
+         }
+      }
+   }
+}
+
 /**
  * \brief  XXX
  * \param  modules
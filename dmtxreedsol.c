@@ -93,13 +93,15 @@ RsEncode(DmtxMessage *message, int sizeIdx)
    DmtxByte val, *eccPtr;
    DmtxByte genStorage[MAX_ERROR_WORD_COUNT];
    DmtxByte eccStorage[MAX_ERROR_WORD_COUNT];
+   const DmtxSymbolInfo *info;
    DmtxByteList gen = dmtxByteListBuild(genStorage, sizeof(genStorage));
    DmtxByteList ecc = dmtxByteListBuild(eccStorage, sizeof(eccStorage));
 
-   blockStride = dmtxGetSymbolAttribute(DmtxSymAttribInterleavedBlocks, sizeIdx);
-   blockErrorWords = dmtxGetSymbolAttribute(DmtxSymAttribBlockErrorWords, sizeIdx);
-   symbolDataWords = dmtxGetSymbolAttribute(DmtxSymAttribSymbolDataWords, sizeIdx);
-   symbolErrorWords = dmtxGetSymbolAttribute(DmtxSymAttribSymbolErrorWords, sizeIdx);
+   info = dmtxGetSymbolInfo(sizeIdx);
+   blockStride = info->interleavedBlocks;
+   blockErrorWords = info->blockErrorWords;
+   symbolDataWords = info->symbolDataWords;
+   symbolErrorWords = info->symbolErrorWords;
    symbolTotalWords = symbolDataWords + symbolErrorWords;
 
    /* Populate generator polynomial */
@@ -134,6 +136,89 @@ RsEncode(DmtxMessage *message, int sizeIdx)
    return DmtxPass;
 }
 
+/**
+ * \brief  Build error word contributions of a unit data word
+ * \param  parity Receives one row of blockErrorWords values per block position
+ * \param  sizeIdx
+ * \return Function success (DmtxPass|DmtxFail)
+ *
+ * Error words are linear in the data words, so changing one data word by
+ * delta changes its block's error words by delta times one row of this table.
+ * Row m holds the error words of a block whose only nonzero data word is a 1
+ * followed by m more data words.
+ */
+static DmtxPassFail
+RsParityTable(DmtxByte *parity, int sizeIdx)
+{
+   int i, j;
+   int blockErrorWords, blockDataWords;
+   DmtxByte val, *row, *prev;
+   DmtxByte genStorage[MAX_ERROR_WORD_COUNT];
+   const DmtxSymbolInfo *info;
+   DmtxByteList gen = dmtxByteListBuild(genStorage, sizeof(genStorage));
+
+   info = dmtxGetSymbolInfo(sizeIdx);
+   if(info == NULL)
+      return DmtxFail;
+
+   blockErrorWords = info->blockErrorWords;
+   blockDataWords = info->blockDataWords[0];
+
+   if(RsGenPoly(&gen, blockErrorWords) == DmtxFail)
+      return DmtxFail;
+
+   /* Each following data word shifts the encoder state once more */
+   memcpy(parity, gen.b, blockErrorWords);
+   for(i = 1; i < blockDataWords; i++)
+   {
+      prev = parity + (i - 1) * blockErrorWords;
+      row = prev + blockErrorWords;
+      val = prev[blockErrorWords-1];
+
+      for(j = blockErrorWords - 1; j > 0; j--)
+         row[j] = GfAdd(prev[j-1], GfMult(gen.b[j], val));
+
+      row[0] = GfMult(gen.b[0], val);
+   }
+
+   return DmtxPass;
+}
+
+/**
+ * \brief  Update error codewords for a change in one data codeword
+ * \param  message Message holding error codewords of previous data
+ * \param  sizeIdx
+ * \param  parity Table built by RsParityTable()
+ * \param  index Position of changed data codeword
+ * \param  delta Old value added to new value of data codeword
+ * \return void
+ */
+static void
+RsUpdateParity(DmtxMessage *message, int sizeIdx, const DmtxByte *parity, int index, DmtxByte delta)
+{
+   int j, deltaLog;
+   int blockStride, blockIdx, blockErrorWords;
+   DmtxByte *code;
+   const DmtxByte *row;
+   const DmtxSymbolInfo *info;
+
+   if(delta == 0)
+      return;
+
+   info = dmtxGetSymbolInfo(sizeIdx);
+   deltaLog = log301[delta];
+   blockStride = info->interleavedBlocks;
+   blockErrorWords = info->blockErrorWords;
+   blockIdx = index % blockStride;
+
+   row = parity + (info->blockDataWords[blockIdx] - 1 - index / blockStride) * blockErrorWords;
+
+   /* Error words are interleaved like data words, highest term first */
+   code = message->code + info->symbolDataWords + blockIdx + (blockErrorWords - 1) * blockStride;
+   for(j = 0; j < blockErrorWords; j++, code -= blockStride)
+      *code = GfAdd(*code, GfMultAntilog(row[j], deltaLog));
+}
+
 /**
  * Decode xyz.
  * More detailed description.
@@ -142,8 +227,6 @@ RsEncode(DmtxMessage *message, int sizeIdx)
  * \param fix
  * \return Function success (DmtxPass|DmtxFail)
  */
-#undef CHKPASS
-#define CHKPASS { if(passFail == DmtxFail) return DmtxFail; }
 static DmtxPassFail
 RsDecode(unsigned char *code, int sizeIdx, int fix)
 {
@@ -152,39 +235,42 @@ RsDecode(unsigned char *code, int sizeIdx, int fix)
    int blockDataWords, blockErrorWords, blockTotalWords, blockMaxCorrectable;
    int symbolDataWords, symbolErrorWords, symbolTotalWords;
    DmtxBoolean error, repairable;
-   DmtxPassFail passFail;
    unsigned char *word;
    DmtxByte elpStorage[MAX_ERROR_WORD_COUNT];
    DmtxByte synStorage[MAX_ERROR_WORD_COUNT+1];
    DmtxByte recStorage[NN];
    DmtxByte locStorage[NN];
+   const DmtxSymbolInfo *info;
    DmtxByteList elp = dmtxByteListBuild(elpStorage, sizeof(elpStorage));
    DmtxByteList syn = dmtxByteListBuild(synStorage, sizeof(synStorage));
    DmtxByteList rec = dmtxByteListBuild(recStorage, sizeof(recStorage));
    DmtxByteList loc = dmtxByteListBuild(locStorage, sizeof(locStorage));
 
-   blockStride = dmtxGetSymbolAttribute(DmtxSymAttribInterleavedBlocks, sizeIdx);
-   blockErrorWords = dmtxGetSymbolAttribute(DmtxSymAttribBlockErrorWords, sizeIdx);
-   blockMaxCorrectable = dmtxGetSymbolAttribute(DmtxSymAttribBlockMaxCorrectable, sizeIdx);
-   symbolDataWords = dmtxGetSymbolAttribute(DmtxSymAttribSymbolDataWords, sizeIdx);
-   symbolErrorWords = dmtxGetSymbolAttribute(DmtxSymAttribSymbolErrorWords, sizeIdx);
+   info = dmtxGetSymbolInfo(sizeIdx);
+   blockStride = info->interleavedBlocks;
+   blockErrorWords = info->blockErrorWords;
+   blockMaxCorrectable = info->blockMaxCorrectable;
+   symbolDataWords = info->symbolDataWords;
+   symbolErrorWords = info->symbolErrorWords;
    symbolTotalWords = symbolDataWords + symbolErrorWords;
 
    /* For each interleaved block */
    for(blockIdx = 0; blockIdx < blockStride; blockIdx++)
    {
       /* Data word count depends on blockIdx due to special case at 144x144 */
-      blockDataWords = dmtxGetBlockDataSize(sizeIdx, blockIdx);
+      blockDataWords = info->blockDataWords[blockIdx];
       blockTotalWords = blockErrorWords + blockDataWords;
 
       /* Populate received list (rec) with data and error codewords */
-      dmtxByteListInit(&rec, 0, 0, &passFail); CHKPASS;
+      if(blockTotalWords > rec.capacity)
+         return DmtxFail;
+      rec.length = 0;
 
       /* Start with final error word and work backward */
       word = code + symbolTotalWords + blockIdx - blockStride;
       for(i = 0; i < blockErrorWords; i++)
       {
-         dmtxByteListPush(&rec, *word, &passFail); CHKPASS;
+         DMTX_BYTELIST_PUSH(&rec, *word);
          word -= blockStride;
       }
 
@@ -192,7 +278,7 @@ RsDecode(unsigned char *code, int sizeIdx, int fix)
       word = code + blockIdx + (blockStride * (blockDataWords - 1));
       for(i = 0; i < blockDataWords; i++)
       {
-         dmtxByteListPush(&rec, *word, &passFail); CHKPASS;
+         DMTX_BYTELIST_PUSH(&rec, *word);
          word -= blockStride;
       }
 
@@ -224,7 +310,7 @@ RsDecode(unsigned char *code, int sizeIdx, int fix)
       word = code + blockIdx;
       for(i = 0; i < blockDataWords; i++)
       {
-         *word = dmtxByteListPop(&rec, &passFail); CHKPASS;
+         *word = DMTX_BYTELIST_POP(&rec);
          word += blockStride;
       }
 
@@ -232,7 +318,7 @@ RsDecode(unsigned char *code, int sizeIdx, int fix)
       word = code + symbolDataWords + blockIdx;
       for(i = 0; i < blockErrorWords; i++)
       {
-         *word = dmtxByteListPop(&rec, &passFail); CHKPASS;
+         *word = DMTX_BYTELIST_POP(&rec);
          word += blockStride;
       }
    }
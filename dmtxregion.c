@@ -21,15 +21,7 @@
 DmtxRegion *
 dmtxRegionCreate(DmtxRegion *reg)
 {
-   DmtxRegion *regCopy;
-
-   regCopy = (DmtxRegion *)malloc(sizeof(DmtxRegion));
-   if(regCopy == NULL)
-      return NULL;
-
-   memcpy(regCopy, reg, sizeof(DmtxRegion));
-
-   return regCopy;
+   return RegionCopy(reg, NULL, NULL);
 }
 
 /**
@@ -43,7 +35,10 @@ dmtxRegionDestroy(DmtxRegion **reg)
    if(reg == NULL || *reg == NULL)
       return DmtxFail;
 
-   free(*reg);
+   if((*reg)->arena != NULL)
+      ArenaFree((*reg)->arena, *reg, sizeof(DmtxRegion));
+   else
+      AllocFree(&((*reg)->allocator), *reg);
 
    *reg = NULL;
 
@@ -69,6 +64,9 @@ dmtxRegionFindNext(DmtxDecode *dec, DmtxTime *timeout)
       if(locStatus == DmtxRangeEnd)
          break;
 
+      if(dec->statsFlags != DmtxStatsNone)
+         dec->stats.gridLocations++;
+
       /* Scan location for presence of valid barcode region */
       reg = dmtxRegionScanPixel(dec, loc.X, loc.Y);
       if(reg != NULL)
@@ -95,6 +93,8 @@ dmtxRegionScanPixel(DmtxDecode *dec, int x, int y)
    DmtxRegion reg;
    DmtxPointFlow flowBegin;
    DmtxPixelLoc loc;
+   DmtxTime start;
+   DmtxPassFail passFail;
 
    loc.X = x;
    loc.Y = y;
@@ -103,42 +103,85 @@ dmtxRegionScanPixel(DmtxDecode *dec, int x, int y)
    if(cache == NULL)
       return NULL;
 
-   if((int)(*cache & 0x80) != 0x00)
+   if((int)(*cache & 0x80) != 0x00) {
+      if(dec->statsFlags != DmtxStatsNone)
+         dec->stats.visitedSkips++;
       return NULL;
+   }
 
    /* Test for presence of any reasonable edge at this location */
+   start = StatsStart(dec);
    flowBegin = MatrixRegionSeekEdge(dec, loc);
-   if(flowBegin.mag < (int)(dec->edgeThresh * 7.65 + 0.5))
+   passFail = (flowBegin.mag < (int)(dec->edgeThresh * 7.65 + 0.5)) ? DmtxFail : DmtxPass;
+   if(StatsStop(dec, DmtxStageSeekEdge, start, passFail) == DmtxFail)
       return NULL;
 
    memset(&reg, 0x00, sizeof(DmtxRegion));
 
    /* Determine barcode orientation */
-   if(MatrixRegionOrientation(dec, &reg, flowBegin) == DmtxFail)
-      return NULL;
-   if(dmtxRegionUpdateXfrms(dec, &reg) == DmtxFail)
+   start = StatsStart(dec);
+   passFail = MatrixRegionOrientation(dec, &reg, flowBegin);
+   if(passFail == DmtxPass)
+      passFail = dmtxRegionUpdateXfrms(dec, &reg);
+   if(StatsStop(dec, DmtxStageOrientation, start, passFail) == DmtxFail)
       return NULL;
 
-   /* Define top edge */
-   if(MatrixRegionAlignCalibEdge(dec, &reg, DmtxEdgeTop) == DmtxFail)
-      return NULL;
-   if(dmtxRegionUpdateXfrms(dec, &reg) == DmtxFail)
-      return NULL;
-
-   /* Define right edge */
-   if(MatrixRegionAlignCalibEdge(dec, &reg, DmtxEdgeRight) == DmtxFail)
-      return NULL;
-   if(dmtxRegionUpdateXfrms(dec, &reg) == DmtxFail)
+   /* Define top edge, then right edge */
+   start = StatsStart(dec);
+   passFail = MatrixRegionAlignCalibEdge(dec, &reg, DmtxEdgeTop);
+   if(passFail == DmtxPass)
+      passFail = dmtxRegionUpdateXfrms(dec, &reg);
+   if(passFail == DmtxPass)
+      passFail = MatrixRegionAlignCalibEdge(dec, &reg, DmtxEdgeRight);
+   if(passFail == DmtxPass)
+      passFail = dmtxRegionUpdateXfrms(dec, &reg);
+   if(StatsStop(dec, DmtxStageAlignCalibEdge, start, passFail) == DmtxFail)
       return NULL;
 
-   CALLBACK_MATRIX(&reg);
+   TraceRegion(dec, DmtxTraceRegion, &reg);
 
    /* Calculate the best fitting symbol size */
-   if(MatrixRegionFindSize(dec, &reg) == DmtxFail)
+   start = StatsStart(dec);
+   passFail = MatrixRegionFindSize(dec, &reg);
+   if(StatsStop(dec, DmtxStageFindSize, start, passFail) == DmtxFail)
       return NULL;
 
+   TraceRegion(dec, DmtxTraceSize, &reg);
+
+   if(dec->statsFlags != DmtxStatsNone)
+      dec->stats.regionsFound++;
+
    /* Found a valid matrix region */
-   return dmtxRegionCreate(&reg);
+   return RegionCopy(&reg, &(dec->arena), &(dec->allocator));
+}
+
+/**
+ * \brief  Copy region struct into arena, or onto heap if arena has no room
+ * \param  reg
+ * \param  arena Decode session arena, or NULL
+ * \param  allocator Used if arena has no room, or NULL for global allocator
+ * \return Copy of reg
+ */
+static DmtxRegion *
+RegionCopy(DmtxRegion *reg, DmtxArena *arena, const DmtxAllocator *allocator)
+{
+   DmtxRegion *regCopy;
+
+   allocator = AllocSelect(allocator);
+
+   regCopy = (DmtxRegion *)ArenaAlloc(arena, sizeof(DmtxRegion));
+   if(regCopy == NULL) {
+      arena = NULL;
+      regCopy = (DmtxRegion *)AllocMalloc(allocator, sizeof(DmtxRegion));
+      if(regCopy == NULL)
+         return NULL;
+   }
+
+   memcpy(regCopy, reg, sizeof(DmtxRegion));
+   regCopy->arena = arena;
+   regCopy->allocator = *allocator;
+
+   return regCopy;
 }
 
 /**
@@ -178,7 +221,7 @@ MatrixRegionSeekEdge(DmtxDecode *dec, DmtxPixelLoc loc)
       if(flowPos.arrive == (flowPosBack.arrive+4)%8 &&
             flowNeg.arrive == (flowNegBack.arrive+4)%8) {
          flow.arrive = dmtxNeighborNone;
-         CALLBACK_POINT_PLOT(flow.loc, 1, 1, 1);
+         TracePoint(dec, DmtxTraceSeed, flow.loc);
          return flow;
       }
    }
@@ -253,6 +296,7 @@ MatrixRegionOrientation(DmtxDecode *dec, DmtxRegion *reg, DmtxPointFlow begin)
    }
 
    err = FindTravelLimits(dec, reg, &line1x);
+   TraceLine(dec, &line1x);
    if(line1x.distSq < 100 || line1x.devn * 10 >= sqrt((double)line1x.distSq)) {
       TrailClear(dec, reg, 0x40);
       return DmtxFail;
@@ -270,6 +314,7 @@ MatrixRegionOrientation(DmtxDecode *dec, DmtxRegion *reg, DmtxPointFlow begin)
    if(line2p.mag > line2n.mag) {
       line2x = line2p;
       err = FindTravelLimits(dec, reg, &line2x);
+      TraceLine(dec, &line2x);
       if(line2x.distSq < 100 || line2x.devn * 10 >= sqrt((double)line2x.distSq))
          return DmtxFail;
 
@@ -341,9 +386,6 @@ MatrixRegionOrientation(DmtxDecode *dec, DmtxRegion *reg, DmtxPointFlow begin)
          reg->bottomLine = line1x;
       }
    }
-/* CALLBACK_POINT_PLOT(reg->locR, 2, 1, 1);
-   CALLBACK_POINT_PLOT(reg->locT, 2, 1, 1); */
-
    reg->leftKnown = reg->bottomKnown = 1;
 
    return DmtxPass;
@@ -582,29 +624,29 @@ RightAngleTrueness(DmtxVector2 c0, DmtxVector2 c1, DmtxVector2 c2, double angle)
  * \param  reg
  * \param  symbolRow
  * \param  symbolCol
- * \param  sizeIdx
+ * \param  info Symbol attributes for the region's size
  * \return Averaged module color
  */
 static int
 ReadModuleColor(DmtxDecode *dec, DmtxRegion *reg, int symbolRow, int symbolCol,
-      int sizeIdx, int colorPlane)
+      const DmtxSymbolInfo *info, int colorPlane)
 {
    int err;
    int i;
-   int symbolRows, symbolCols;
    int color, colorTmp;
+   double colScale, rowScale;
    double sampleX[] = { 0.5, 0.4, 0.5, 0.6, 0.5 };
    double sampleY[] = { 0.5, 0.5, 0.4, 0.5, 0.6 };
    DmtxVector2 p;
 
-   symbolRows = dmtxGetSymbolAttribute(DmtxSymAttribSymbolRows, sizeIdx);
-   symbolCols = dmtxGetSymbolAttribute(DmtxSymAttribSymbolCols, sizeIdx);
+   colScale = 1.0/info->symbolCols;
+   rowScale = 1.0/info->symbolRows;
 
    color = 0;
    for(i = 0; i < 5; i++) {
 
-      p.X = (1.0/symbolCols) * (symbolCol + sampleX[i]);
-      p.Y = (1.0/symbolRows) * (symbolRow + sampleY[i]);
+      p.X = colScale * (symbolCol + sampleX[i]);
+      p.Y = rowScale * (symbolRow + sampleY[i]);
 
       dmtxMatrix3VMultiplyBy(&p, reg->fit2raw);
 
@@ -634,6 +676,7 @@ MatrixRegionFindSize(DmtxDecode *dec, DmtxRegion *reg)
    int colorOnAvg, bestColorOnAvg;
    int colorOffAvg, bestColorOffAvg;
    int contrast, bestContrast;
+   const DmtxSymbolInfo *info;
    DmtxImage *img;
 
    img = dec->image;
@@ -661,14 +704,15 @@ MatrixRegionFindSize(DmtxDecode *dec, DmtxRegion *reg)
    /* Test each barcode size to find best contrast in calibration modules */
    for(sizeIdx = sizeIdxBeg; sizeIdx < sizeIdxEnd; sizeIdx++) {
 
-      symbolRows = dmtxGetSymbolAttribute(DmtxSymAttribSymbolRows, sizeIdx);
-      symbolCols = dmtxGetSymbolAttribute(DmtxSymAttribSymbolCols, sizeIdx);
+      info = dmtxGetSymbolInfo(sizeIdx);
+      symbolRows = info->symbolRows;
+      symbolCols = info->symbolCols;
       colorOnAvg = colorOffAvg = 0;
 
       /* Sum module colors along horizontal calibration bar */
       row = symbolRows - 1;
       for(col = 0; col < symbolCols; col++) {
-         color = ReadModuleColor(dec, reg, row, col, sizeIdx, reg->flowBegin.plane);
+         color = ReadModuleColor(dec, reg, row, col, info, reg->flowBegin.plane);
          if((col & 0x01) != 0x00)
             colorOffAvg += color;
          else
@@ -678,7 +722,7 @@ MatrixRegionFindSize(DmtxDecode *dec, DmtxRegion *reg)
       /* Sum module colors along vertical calibration bar */
       col = symbolCols - 1;
       for(row = 0; row < symbolRows; row++) {
-         color = ReadModuleColor(dec, reg, row, col, sizeIdx, reg->flowBegin.plane);
+         color = ReadModuleColor(dec, reg, row, col, info, reg->flowBegin.plane);
          if((row & 0x01) != 0x00)
             colorOffAvg += color;
          else
@@ -708,10 +752,11 @@ MatrixRegionFindSize(DmtxDecode *dec, DmtxRegion *reg)
    reg->onColor = bestColorOnAvg;
    reg->offColor = bestColorOffAvg;
 
-   reg->symbolRows = dmtxGetSymbolAttribute(DmtxSymAttribSymbolRows, reg->sizeIdx);
-   reg->symbolCols = dmtxGetSymbolAttribute(DmtxSymAttribSymbolCols, reg->sizeIdx);
-   reg->mappingRows = dmtxGetSymbolAttribute(DmtxSymAttribMappingMatrixRows, reg->sizeIdx);
-   reg->mappingCols = dmtxGetSymbolAttribute(DmtxSymAttribMappingMatrixCols, reg->sizeIdx);
+   info = dmtxGetSymbolInfo(reg->sizeIdx);
+   reg->symbolRows = info->symbolRows;
+   reg->symbolCols = info->symbolCols;
+   reg->mappingRows = info->mappingRows;
+   reg->mappingCols = info->mappingCols;
 
    /* Tally jumps on horizontal calibration bar to verify sizeIdx */
    jumpCount = CountJumpTally(dec, reg, 0, reg->symbolRows - 1, DmtxDirRight);
@@ -775,10 +820,13 @@ CountJumpTally(DmtxDecode *dec, DmtxRegion *reg, int xStart, int yStart, DmtxDir
    int tModule, tPrev;
    int darkOnLight;
    int color;
+   const DmtxSymbolInfo *info;
 
    assert(xStart == 0 || yStart == 0);
    assert(dir == DmtxDirRight || dir == DmtxDirUp);
 
+   info = dmtxGetSymbolInfo(reg->sizeIdx);
+
    if(dir == DmtxDirRight)
       xInc = 1;
    else
@@ -790,7 +838,7 @@ CountJumpTally(DmtxDecode *dec, DmtxRegion *reg, int xStart, int yStart, DmtxDir
 
    darkOnLight = (int)(reg->offColor > reg->onColor);
    jumpThreshold = abs((int)(0.4 * (reg->onColor - reg->offColor) + 0.5));
-   color = ReadModuleColor(dec, reg, yStart, xStart, reg->sizeIdx, reg->flowBegin.plane);
+   color = ReadModuleColor(dec, reg, yStart, xStart, info, reg->flowBegin.plane);
    tModule = (darkOnLight) ? reg->offColor - color : color - reg->offColor;
 
    for(x = xStart + xInc, y = yStart + yInc;
@@ -799,7 +847,7 @@ CountJumpTally(DmtxDecode *dec, DmtxRegion *reg, int xStart, int yStart, DmtxDir
          x += xInc, y += yInc) {
 
       tPrev = tModule;
-      color = ReadModuleColor(dec, reg, y, x, reg->sizeIdx, reg->flowBegin.plane);
+      color = ReadModuleColor(dec, reg, y, x, info, reg->flowBegin.plane);
       tModule = (darkOnLight) ? reg->offColor - color : color - reg->offColor;
 
       if(state == DmtxModuleOff) {
@@ -1130,7 +1178,7 @@ TrailBlazeContinuous(DmtxDecode *dec, DmtxRegion *reg, DmtxPointFlow flowBegin,
          else if(flow.loc.Y < boundMin.Y)
             boundMin.Y = flow.loc.Y;
 
-/*       CALLBACK_POINT_PLOT(flow.loc, (sign > 0) ? 2 : 3, 1, 2); */
+         TracePoint(dec, DmtxTraceTrail, flow.loc);
       }
 
       if(sign > 0) {
@@ -1381,8 +1429,6 @@ FindBestSolidLine(DmtxDecode *dec, DmtxRegion *reg, int step0, int step1, int st
          }
       }
 
-/*    CALLBACK_POINT_PLOT(follow.loc, (sign > 1) ? 4 : 3, 1, 2); */
-
       follow = FollowStep(dec, reg, follow, sign);
    }
 
@@ -1469,8 +1515,6 @@ FindBestSolidLine2(DmtxDecode *dec, DmtxPixelLoc loc0, int tripSteps, int sign,
          }
       }
 
-/*    CALLBACK_POINT_PLOT(follow.loc, (sign > 1) ? 4 : 3, 1, 2); */
-
       follow = FollowStep2(dec, follow, sign);
    }
 
@@ -1570,18 +1614,12 @@ FindTravelLimits(DmtxDecode *dec, DmtxRegion *reg, DmtxBestLine *line)
          break;
       }
 
-/*  CALLBACK_POINT_PLOT(followPos.loc, 2, 1, 2);
-    CALLBACK_POINT_PLOT(followNeg.loc, 4, 1, 2); */
-
       followPos = FollowStep(dec, reg, followPos, +1);
       followNeg = FollowStep(dec, reg, followNeg, -1);
    }
    line->devn = max(posWanderMaxLock - posWanderMinLock, negWanderMaxLock - negWanderMinLock)/256;
    line->distSq = distSqMax;
 
-/* CALLBACK_POINT_PLOT(posMax, 2, 1, 1);
-   CALLBACK_POINT_PLOT(negMax, 2, 1, 1); */
-
    return DmtxPass;
 }
 
@@ -1650,6 +1688,8 @@ MatrixRegionAlignCalibEdge(DmtxDecode *dec, DmtxRegion *reg, int edgeLoc)
       ;
    }
 
+   TraceLine(dec, &bestLine);
+
    if(edgeLoc == DmtxEdgeTop) {
       reg->topKnown = 1;
       reg->topAngle = bestLine.angle;
@@ -1726,9 +1766,6 @@ BresLineInit(DmtxPixelLoc loc0, DmtxPixelLoc loc1, DmtxPixelLoc locInside)
    line.outward = 0;
    line.error = (line.steep) ? line.yDelta/2 : line.xDelta/2;
 
-/* CALLBACK_POINT_PLOT(loc0, 3, 1, 1);
-   CALLBACK_POINT_PLOT(loc1, 3, 1, 1); */
-
    return line;
 }
 
@@ -42,9 +42,27 @@
 #define DmtxC40TextShift2              2
 #define DmtxC40TextShift3              3
 
+#define DmtxCTXDecodeShift1          257 /* Decode table actions, beyond any byte */
+#define DmtxCTXDecodeShift2          258
+#define DmtxCTXDecodeShift3          259
+#define DmtxCTXDecodeFnc1            260
+#define DmtxCTXDecodeUpperShift      261
+#define DmtxCTXDecodeNone            262
+
 #define DmtxUnlatchExplicit            0
 #define DmtxUnlatchImplicit            1
 
+#define DmtxMaxMappingArea         17424 /* 132x132 mapping matrix of 144x144 symbol */
+#define DmtxMaxCodeWords            2178 /* 1558 data + 620 error words of 144x144 */
+#define DmtxMaxRunsPerRow             72 /* Alternating modules across 144 columns */
+#define DmtxMaxModuleBytes          2592 /* Packed module bitmap of 144x144 symbol */
+#define DmtxAllocAlign                64 /* Alignment requested for pixel buffers */
+
+/* Longest decoded message from n data words: 2 digits per ASCII codeword,
+   plus 7 byte macro header (from 1 codeword) and 2 byte trailer, plus 1 for
+   terminating zero */
+#define DmtxMaxOutputLength(n)    (2 * (n) + 8)
+
 #define DmtxChannelValid            0x00
 #define DmtxChannelUnsupportedChar  0x01 << 0
 #define DmtxChannelCannotUnlatch    0x01 << 1
@@ -61,6 +79,110 @@ typedef enum {
    DmtxEncodeFull     /* Use only fully expanded format within scheme */
 } DmtxEncodeOption;
 
+/**
+ * One EncodeNextChunk() call in the optimizer's shared encoding chain. Each
+ * node points back to the node it extends, so a stream's full output can be
+ * rebuilt by replaying the calls from the root node forward.
+ */
+typedef struct DmtxEncodeNode_struct {
+   int             parent;  /* Index of node being extended (DmtxUndefined for root) */
+   int             scheme;  /* Scheme passed to EncodeNextChunk() */
+   int             option;  /* DmtxEncodeOption passed to EncodeNextChunk() */
+} DmtxEncodeNode;
+
+/**
+ * Append-only node arena plus the single full-length output buffer that
+ * optimizer streams are expanded into while a chunk is being encoded
+ */
+typedef struct DmtxEncodeArena_struct {
+   DmtxEncodeNode *node;
+   int             length;
+   int             capacity;
+   DmtxByteList    scratch;
+} DmtxEncodeArena;
+
+/**
+ * Optimizer stream state. Only the trailing output words that a later chunk
+ * may still revisit are kept in tail (the last Edifact word, or the whole
+ * chain while in Base256); everything earlier is represented by node.
+ */
+typedef struct DmtxOptimizeStream_struct {
+   DmtxEncodeStream stream;       /* Scalar progress (stream.output unused) */
+   int             outputLength;  /* Length of the output this stream represents */
+   int             node;          /* Arena node whose replay reproduces this stream */
+   DmtxByteList    tail;          /* Final tail.length words of output */
+} DmtxOptimizeStream;
+
+/**
+ * One cell of a label sheet, holding its symbol as a packed module bitmap
+ * (top row first) so the sheet can be drawn scanline by scanline
+ */
+typedef struct DmtxSheetCell_struct {
+   int             rows;    /* Symbol rows (0 for a blank cell) */
+   int             cols;    /* Symbol columns */
+   unsigned char  *modules; /* Bitmap from dmtxEncodeModules() */
+} DmtxSheetCell;
+
+/**
+ * Symbol being streamed out by dmtxEncodeWrite(), as its packed module bitmap
+ * along with the image geometry and the one scanline kept in memory
+ */
+typedef struct DmtxImageWriter_struct {
+   int             format;     /* DmtxFormatPbm | DmtxFormatPgm | DmtxFormatPng */
+   int             rows;       /* Symbol rows */
+   int             cols;       /* Symbol columns */
+   int             width;      /* Image width in pixels */
+   int             height;     /* Image height in pixels */
+   int             rowBytes;   /* Bytes per scanline, excluding PNG filter type */
+   int             moduleSize;
+   int             marginSize;
+   unsigned char  *row;        /* PNG filter type followed by current scanline */
+   unsigned char   modules[DmtxMaxModuleBytes];
+   DmtxWriteCallback callback;
+   void           *userData;
+} DmtxImageWriter;
+
+/**
+ * One symbol held by DmtxEncodeCache. Storage holds the payload, then its
+ * codewords (data and error), then its packed module bitmap, and image holds
+ * the last rendering made with the settings recorded alongside it.
+ */
+typedef struct DmtxEncodeCacheEntry_struct {
+   unsigned long   hash;
+   int             scheme;
+   int             sizeIdxRequest;
+   int             inputSize;
+   int             sizeIdx;
+   int             rows;
+   int             cols;
+   int             codeSize;
+   unsigned char  *storage;
+   int             storageCapacity;
+   unsigned char  *image;         /* Pixels without row padding */
+   int             imageSize;     /* 0 if no image is held */
+   int             imageCapacity;
+   int             moduleSize;    /* Settings image was rendered with */
+   int             marginSize;
+   int             pixelPacking;
+   int             imageFlip;
+   int             next;          /* Next entry in same hash bucket */
+   int             newer;         /* Neighbors in most-recently-used list */
+   int             older;
+} DmtxEncodeCacheEntry;
+
+/**
+ * Copy of a cached symbol taken under the cache lock, so it can be rendered
+ * after the lock is released
+ */
+typedef struct DmtxEncodeCacheSymbol_struct {
+   int             sizeIdx;
+   int             rows;
+   int             cols;
+   int             codeSize;
+   unsigned char   code[DmtxMaxCodeWords];
+   unsigned char   modules[DmtxMaxModuleBytes];
+} DmtxEncodeCacheSymbol;
+
 typedef enum {
    DmtxRangeGood,
    DmtxRangeBad,
@@ -116,17 +238,63 @@ typedef struct DmtxBresLine_struct {
    DmtxPixelLoc    loc1;
 } DmtxBresLine;
 
-typedef struct C40TextState_struct {
-   int             shift;
-   DmtxBoolean     upperShift;
-} C40TextState;
+/**
+ * @struct DmtxSegmentSink
+ * @brief DmtxSegmentSink
+ * Receiver of decoded segments, and the data segment still being collected
+ */
+typedef struct DmtxSegmentSink_struct {
+   DmtxSegmentCallback callback;
+   void           *userData;
+   int             scheme;        /* Scheme of data being collected */
+   int             dataStart;     /* Output position where collected data begins */
+   int             eci;
+   int             macro;
+   DmtxPassFail    passFail;      /* DmtxFail once delivery has stopped */
+} DmtxSegmentSink;
+
+typedef enum {
+   DmtxGs1CheckNone,         /* Any characters */
+   DmtxGs1CheckNumeric,      /* Digits only */
+   DmtxGs1CheckDigit,        /* Digits ending with mod 10 check digit */
+   DmtxGs1CheckDate          /* YYMMDD */
+} DmtxGs1Check;
+
+/**
+ * @struct DmtxGs1Prefix
+ * @brief DmtxGs1Prefix
+ * AIs sharing a range of two-digit prefixes and their field rules
+ */
+typedef struct DmtxGs1Prefix_struct {
+   int             first;         /* First two-digit prefix in range */
+   int             last;          /* Last two-digit prefix in range */
+   int             aiLength;      /* Digits in AI */
+   int             dataLength;    /* Predefined data length, or 0 if variable */
+   int             dataMax;       /* Longest data allowed */
+   int             check;         /* DmtxGs1Check */
+} DmtxGs1Prefix;
+
+/**
+ * @struct DmtxGs1Parser
+ * @brief DmtxGs1Parser
+ * GS1 field collection state, advanced one decoded byte at a time
+ */
+typedef struct DmtxGs1Parser_struct {
+   DmtxGs1Field   *field;
+   int             fieldSize;
+   int             fieldCount;    /* Completed fields */
+   int             aiDigits;      /* AI digits read for field in progress */
+   const DmtxGs1Prefix *prefix;   /* Prefix of field in progress, once known */
+   DmtxBoolean     started;       /* Leading FNC1 seen */
+} DmtxGs1Parser;
 
 /* dmtxregion.c */
+static DmtxRegion *RegionCopy(DmtxRegion *reg, DmtxArena *arena, const DmtxAllocator *allocator);
 static double RightAngleTrueness(DmtxVector2 c0, DmtxVector2 c1, DmtxVector2 c2, double angle);
 static DmtxPointFlow MatrixRegionSeekEdge(DmtxDecode *dec, DmtxPixelLoc loc0);
 static DmtxPassFail MatrixRegionOrientation(DmtxDecode *dec, DmtxRegion *reg, DmtxPointFlow flowBegin);
 static long DistanceSquared(DmtxPixelLoc a, DmtxPixelLoc b);
-static int ReadModuleColor(DmtxDecode *dec, DmtxRegion *reg, int symbolRow, int symbolCol, int sizeIdx, int colorPlane);
+static int ReadModuleColor(DmtxDecode *dec, DmtxRegion *reg, int symbolRow, int symbolCol, const DmtxSymbolInfo *info, int colorPlane);
 
 static DmtxPassFail MatrixRegionFindSize(DmtxDecode *dec, DmtxRegion *reg);
 static int CountJumpTally(DmtxDecode *dec, DmtxRegion *reg, int xStart, int yStart, DmtxDirection dir);
@@ -150,27 +318,63 @@ static DmtxPassFail BresLineStep(DmtxBresLine *line, int travel, int outward);
 
 /* dmtxdecode.c */
 static void TallyModuleJumps(DmtxDecode *dec, DmtxRegion *reg, int tally[][24], int xOrigin, int yOrigin, int mapWidth, int mapHeight, DmtxDirection dir);
+static DmtxPassFail DecodeMatrixRegionMessage(DmtxDecode *dec, DmtxRegion *reg, int fix, DmtxMessage *msg, DmtxSegmentSink *sink);
 static DmtxPassFail PopulateArrayFromMatrix(DmtxDecode *dec, DmtxRegion *reg, DmtxMessage *msg);
+static DmtxTime StatsStart(DmtxDecode *dec);
+static DmtxPassFail StatsStop(DmtxDecode *dec, int stage, DmtxTime start, DmtxPassFail passFail);
+static void TracePoint(DmtxDecode *dec, int type, DmtxPixelLoc loc);
+static void TraceLine(DmtxDecode *dec, const DmtxBestLine *line);
+static void TraceRegion(DmtxDecode *dec, int type, const DmtxRegion *reg);
 
 /* dmtxdecodescheme.c */
-static void DecodeDataStream(DmtxMessage *msg, int sizeIdx, unsigned char *outputStart);
+static void DecodeDataStream(DmtxMessage *msg, int sizeIdx, unsigned char *outputStart, DmtxSegmentSink *sink);
 static int GetEncodationScheme(unsigned char cw);
 static void PushOutputWord(DmtxMessage *msg, int value);
-static void PushOutputC40TextWord(DmtxMessage *msg, C40TextState *state, int value);
 static void PushOutputMacroHeader(DmtxMessage *msg, int macroType);
 static void PushOutputMacroTrailer(DmtxMessage *msg);
-static unsigned char *DecodeSchemeAscii(DmtxMessage *msg, unsigned char *ptr, unsigned char *dataEnd);
-static unsigned char *DecodeSchemeC40Text(DmtxMessage *msg, unsigned char *ptr, unsigned char *dataEnd, DmtxScheme encScheme);
+static void PushOutputFnc1(DmtxMessage *msg, DmtxSegmentSink *sink);
+static void SegmentFlush(DmtxMessage *msg, DmtxSegmentSink *sink);
+static void SegmentDeliver(DmtxMessage *msg, DmtxSegmentSink *sink, int type, int start);
+static unsigned char *DecodeEci(DmtxMessage *msg, unsigned char *ptr, unsigned char *dataEnd, DmtxSegmentSink *sink);
+static unsigned char *DecodeSchemeAscii(DmtxMessage *msg, unsigned char *ptr, unsigned char *dataEnd, DmtxSegmentSink *sink);
+static unsigned char *DecodeSchemeC40Text(DmtxMessage *msg, unsigned char *ptr, unsigned char *dataEnd, DmtxScheme encScheme, DmtxSegmentSink *sink);
 static unsigned char *DecodeSchemeX12(DmtxMessage *msg, unsigned char *ptr, unsigned char *dataEnd);
 static unsigned char *DecodeSchemeEdifact(DmtxMessage *msg, unsigned char *ptr, unsigned char *dataEnd);
 static unsigned char *DecodeSchemeBase256(DmtxMessage *msg, unsigned char *ptr, unsigned char *dataEnd);
 
+/* dmtxdecodegs1.c */
+static DmtxPassFail Gs1Segment(const DmtxDecodeSegment *segment, void *userData);
+static DmtxPassFail Gs1PushByte(DmtxGs1Parser *parser, const unsigned char *ptr, int offset);
+static DmtxPassFail Gs1FieldEnd(DmtxGs1Parser *parser);
+static DmtxPassFail Gs1Finish(DmtxGs1Parser *parser);
+static const DmtxGs1Prefix *Gs1FindPrefix(int prefix);
+static DmtxPassFail Gs1CheckDigit(const unsigned char *data, int length);
+static DmtxPassFail Gs1CheckDate(const unsigned char *data);
+
 /* dmtxencode.c */
+static void EncodeDefaults(DmtxEncode *enc);
+static void EncodeCopySettings(DmtxEncode *dst, DmtxEncode *src);
+static void EncodeRelease(DmtxEncode *enc);
+static DmtxPassFail EncodePrepareMessage(DmtxEncode *enc, int sizeIdx);
+static DmtxPassFail EncodePrepareImage(DmtxEncode *enc, int width, int height, int rowSizeBytes);
+static int EncodeSymbolCodewords(DmtxEncode *enc, int inputSize, unsigned char *inputString,
+      DmtxByteList *output, DmtxRegion *region);
+static DmtxPassFail RenderSymbolBuffer(DmtxEncode *enc, DmtxByteList *output, int sizeIdx,
+      unsigned char *pxl, int width, int height, int rowSizeBytes);
+static void BuildModuleBitmap(DmtxMessage *message, int sizeIdx, unsigned char *modules);
+static void PlaceSymbolModules(DmtxMessage *message, DmtxByteList *output, int sizeIdx);
 static void PrintPattern(DmtxEncode *encode);
-static int EncodeDataCodewords(DmtxByteList *input, DmtxByteList *output, int sizeIdxRequest, DmtxScheme scheme);
+static DmtxPassFail RenderPattern(DmtxImage *img, DmtxMessage *message, int sizeIdx, int moduleSize, int marginSize);
+static DmtxPassFail BuildPatternPixels(DmtxImage *img, unsigned char pixel[][4]);
+static DmtxPassFail RenderPatternRows(DmtxImage *img, DmtxMessage *message, int sizeIdx, int moduleSize, int marginSize);
+static unsigned char *PatternRowPtr(DmtxImage *img, int y);
+static void ClearBitRun(unsigned char *row, int start, int count);
+static void SetBitRun(unsigned char *row, int start, int count);
+static int EncodeDataCodewords(DmtxByteList *input, DmtxByteList *output, int sizeIdxRequest, DmtxScheme scheme, const DmtxAllocator *allocator);
 
 /* dmtxplacemod.c */
 static int ModulePlacementEcc200(unsigned char *modules, unsigned char *codewords, int sizeIdx, int moduleOnColor);
+static void ModulePlacementMap(int *map, int sizeIdx);
 static void PatternShapeStandard(unsigned char *modules, int mappingRows, int mappingCols, int row, int col, unsigned char *codeword, int moduleOnColor);
 static void PatternShapeSpecial1(unsigned char *modules, int mappingRows, int mappingCols, unsigned char *codeword, int moduleOnColor);
 static void PatternShapeSpecial2(unsigned char *modules, int mappingRows, int mappingCols, unsigned char *codeword, int moduleOnColor);
@@ -181,6 +385,8 @@ static void PlaceModule(unsigned char *modules, int mappingRows, int mappingCols
 
 /* dmtxreedsol.c */
 static DmtxPassFail RsEncode(DmtxMessage *message, int sizeIdx);
+static DmtxPassFail RsParityTable(DmtxByte *parity, int sizeIdx);
+static void RsUpdateParity(DmtxMessage *message, int sizeIdx, const DmtxByte *parity, int index, DmtxByte delta);
 static DmtxPassFail RsDecode(unsigned char *code, int sizeIdx, int fix);
 static DmtxPassFail RsGenPoly(DmtxByteList *gen, int errorWordCount);
 static DmtxBoolean RsComputeSyndromes(DmtxByteList *syn, const DmtxByteList *rec, int blockErrorWords);
@@ -197,16 +403,41 @@ static void SetDerivedFields(DmtxScanGrid *grid);
 /* dmtxsymbol.c */
 static int FindSymbolSize(int dataWords, int sizeIdxRequest);
 
+/* dmtxmessage.c */
+static DmtxMessage *MessageCreate(int sizeIdx, int symbolFormat, DmtxArena *arena, const DmtxAllocator *allocator);
+static DmtxPassFail MessageInit(DmtxMessage *message, int sizeIdx, unsigned char *array, unsigned char *code);
+
+/* dmtxalloc.c */
+static const DmtxAllocator *AllocSelect(const DmtxAllocator *allocator);
+static void *AllocMalloc(const DmtxAllocator *allocator, size_t size);
+static void *AllocCalloc(const DmtxAllocator *allocator, size_t count, size_t size);
+static void *AllocRealloc(const DmtxAllocator *allocator, void *ptr, size_t size);
+static void *AllocAligned(const DmtxAllocator *allocator, size_t size);
+static void AllocFree(const DmtxAllocator *allocator, void *ptr);
+static void *DefaultMalloc(size_t size, void *userData);
+static void *DefaultRealloc(void *ptr, size_t size, void *userData);
+static void DefaultFree(void *ptr, void *userData);
+
+/* dmtxarena.c */
+static void ArenaInit(DmtxArena *arena, unsigned char *storage, size_t size);
+static void *ArenaAlloc(DmtxArena *arena, size_t size);
+static void ArenaFree(DmtxArena *arena, void *ptr, size_t size);
+static void ArenaRelease(DmtxArena *arena, const DmtxAllocator *allocator);
+
+/* dmtxtime.c */
+static double TimeElapsedNsec(DmtxTime start);
+
 /* dmtximage.c */
+static DmtxPassFail ImageInit(DmtxImage *img, unsigned char *pxl, int width, int height, int pack);
 static int GetBitsPerPixel(int pack);
 
 /* dmtxencodestream.c */
 static DmtxEncodeStream StreamInit(DmtxByteList *input, DmtxByteList *output);
-static void StreamCopy(DmtxEncodeStream *dst, DmtxEncodeStream *src);
 static void StreamMarkComplete(DmtxEncodeStream *stream, int sizeIdx);
 static void StreamMarkInvalid(DmtxEncodeStream *stream, int reasonIdx);
 static void StreamMarkFatal(DmtxEncodeStream *stream, int reasonIdx);
 static void StreamOutputChainAppend(DmtxEncodeStream *stream, DmtxByte value);
+static DmtxByte *StreamOutputChainReserve(DmtxEncodeStream *stream, int count);
 static DmtxByte StreamOutputChainRemoveLast(DmtxEncodeStream *stream);
 static void StreamOutputSet(DmtxEncodeStream *stream, int index, DmtxByte value);
 static DmtxBoolean StreamInputHasNext(DmtxEncodeStream *stream);
@@ -221,18 +452,94 @@ static void EncodeChangeScheme(DmtxEncodeStream *stream, DmtxScheme targetScheme
 static int GetRemainingSymbolCapacity(int outputLength, int sizeIdx);
 
 /* dmtxencodeoptimize.c */
-static int EncodeOptimizeBest(DmtxByteList *input, DmtxByteList *output, int sizeIdxRequest);
-static void StreamAdvanceFromBest(DmtxEncodeStream *streamNext,
-      DmtxEncodeStream *streamList, int targeteState, int sizeIdxRequest);
-static void AdvanceAsciiCompact(DmtxEncodeStream *streamNext, DmtxEncodeStream *streamList,
-      int state, int inputNext, int sizeIdxRequest);
-static void AdvanceCTX(DmtxEncodeStream *streamNext, DmtxEncodeStream *streamList,
-      int state, int inputNext, int ctxValueCount, int sizeIdxRequest);
-static void AdvanceEdifact(DmtxEncodeStream *streamNext, DmtxEncodeStream *streamList,
-      int state, int inputNext, int sizeIdxRequest);
+static int EncodeOptimizeBest(DmtxByteList *input, DmtxByteList *output, int sizeIdxRequest, const DmtxAllocator *allocator);
+static void StreamAdvanceFromBest(DmtxOptimizeStream *streamNext, DmtxOptimizeStream *streamList,
+      int targeteState, DmtxEncodeArena *arena, int sizeIdxRequest);
+static void AdvanceAsciiCompact(DmtxOptimizeStream *streamNext, DmtxOptimizeStream *streamList,
+      int state, int inputNext, DmtxEncodeArena *arena, int sizeIdxRequest);
+static void AdvanceCTX(DmtxOptimizeStream *streamNext, DmtxOptimizeStream *streamList,
+      int state, int inputNext, int ctxValueCount, DmtxEncodeArena *arena, int sizeIdxRequest);
+static void AdvanceEdifact(DmtxOptimizeStream *streamNext, DmtxOptimizeStream *streamList,
+      int state, int inputNext, DmtxEncodeArena *arena, int sizeIdxRequest);
+static void OptimizeStreamInit(DmtxOptimizeStream *ostream, DmtxByteList *input,
+      DmtxByte *tailStorage, int tailCapacity);
+static void OptimizeStreamCopy(DmtxOptimizeStream *dst, DmtxOptimizeStream *src);
+static void OptimizeStreamExpand(DmtxEncodeStream *stream, DmtxOptimizeStream *ostream,
+      DmtxEncodeArena *arena);
+static void OptimizeStreamCollapse(DmtxOptimizeStream *ostream, DmtxEncodeStream *stream);
+static int ArenaAppendNode(DmtxEncodeArena *arena, int parent, int scheme, int option);
+static int ArenaReplay(DmtxEncodeArena *arena, int node, DmtxByteList *input,
+      DmtxByteList *output, int sizeIdxRequest);
 static int GetScheme(int state);
 static DmtxBoolean ValidStateSwitch(int fromState, int targetState);
 
+/* dmtxencodelookahead.c */
+static int EncodeAutoFast(DmtxByteList *input, DmtxByteList *output, int sizeIdxRequest);
+static int LookAheadScheme(DmtxByteList *input, int inputNext, int currentScheme);
+static int LookAheadDecide(int *count, DmtxByteList *input, int inputNext, DmtxBoolean endOfInput);
+static int LookAheadCostCTX(DmtxByte value, int scheme);
+static int LookAheadRoundUp(int count);
+static DmtxBoolean LookAheadChunkFits(DmtxByteList *input, int inputNext, int scheme);
+
+/* dmtxencodetemplate.c */
+static void EncodeTemplatePrefix(DmtxEncodeTemplate *tpl);
+static int EncodeTemplateCodewords(DmtxEncodeTemplate *tpl, DmtxByteList *output);
+static DmtxPassFail EncodeTemplateRebuild(DmtxEncodeTemplate *tpl, int sizeIdx);
+static void EncodeTemplateRenderModule(DmtxImage *img, unsigned char pixel[][4], int moduleIdx,
+      int moduleStatus, int sizeIdx, int moduleSize, int marginSize);
+
+/* dmtxencodebatch.c */
+static DmtxPassFail EncodeBatchSerial(DmtxEncode *enc, DmtxEncodeJob *jobs, int jobCount,
+      DmtxEncodeJobCallback callback, void *userData);
+#if defined(HAVE_PTHREAD_H)
+static DmtxPassFail EncodeBatchThreads(DmtxEncode *enc, DmtxEncodeJob *jobs, int jobCount,
+      int threadCount, DmtxEncodeJobCallback callback, void *userData);
+static void *EncodeBatchWorker(void *arg);
+#endif
+static void EncodeBatchJob(DmtxEncode *enc, DmtxEncodeJob *job);
+
+/* dmtxencodesheet.c */
+static DmtxPassFail SheetEncodeCell(DmtxEncode *enc, const DmtxSheetLayout *layout, int cellIdx,
+      int inputSize, unsigned char *inputString, DmtxSheetCell *cell, int width, int height);
+static void SheetRowKey(DmtxEncode *enc, const DmtxSheetLayout *layout, int ty, int *band, int *moduleRow);
+static void SheetComposeRow(DmtxImage *img, unsigned char *rowPtr, unsigned char pixel[][4],
+      DmtxEncode *enc, const DmtxSheetLayout *layout, DmtxSheetCell *cells, int moduleRow);
+
+/* dmtxencodewrite.c */
+static DmtxPassFail WriteFile(const unsigned char *data, int size, void *userData);
+static DmtxPassFail WritePnm(DmtxImageWriter *writer);
+#if defined(HAVE_ZLIB_H)
+static DmtxPassFail WritePng(DmtxImageWriter *writer);
+static DmtxPassFail WritePngChunk(DmtxImageWriter *writer, const char *type, const unsigned char *data, int size);
+static void WritePngUint32(unsigned char *buf, unsigned long value);
+#endif
+static void WriteComposeRow(DmtxImageWriter *writer, int ty);
+static int WriteRowKey(DmtxImageWriter *writer, int ty);
+
+/* dmtxencodecache.c */
+static DmtxPassFail CacheFetch(DmtxEncodeCache *cache, DmtxEncode *enc, int inputSize,
+      unsigned char *inputString, DmtxEncodeCacheSymbol *symbol);
+static DmtxPassFail CacheEncode(DmtxEncode *enc, int inputSize, unsigned char *inputString,
+      DmtxEncodeCacheSymbol *symbol);
+static DmtxPassFail CacheRender(DmtxEncode *enc, DmtxEncodeCacheSymbol *symbol, unsigned char *pxl,
+      int width, int height, int rowSizeBytes);
+static DmtxPassFail CacheCopyImage(DmtxEncodeCache *cache, DmtxEncode *enc, int inputSize,
+      unsigned char *inputString, unsigned char *pxl, int height, int rowSizeBytes);
+static void CacheStoreImage(DmtxEncodeCache *cache, DmtxEncode *enc, int inputSize,
+      unsigned char *inputString, unsigned char *pxl, int height, int rowSizeBytes,
+      int imageRowBytes);
+static DmtxBoolean CacheImageMatches(DmtxEncodeCacheEntry *entry, DmtxEncode *enc);
+static int CacheFind(DmtxEncodeCache *cache, unsigned long hash, DmtxEncode *enc,
+      int inputSize, unsigned char *inputString);
+static void CacheInsert(DmtxEncodeCache *cache, unsigned long hash, DmtxEncode *enc,
+      int inputSize, unsigned char *inputString, DmtxEncodeCacheSymbol *symbol);
+static void CacheTouch(DmtxEncodeCache *cache, int entryIdx);
+static void CacheUnlink(DmtxEncodeCache *cache, int entryIdx);
+static void CacheLinkNewest(DmtxEncodeCache *cache, int entryIdx);
+static unsigned long CacheHash(DmtxEncode *enc, int inputSize, unsigned char *inputString);
+static void CacheLock(DmtxEncodeCache *cache);
+static void CacheUnlock(DmtxEncodeCache *cache);
+
 /* dmtxencodeascii.c */
 static void EncodeNextChunkAscii(DmtxEncodeStream *stream, int option);
 static void AppendValueAscii(DmtxEncodeStream *stream, DmtxByte value);
@@ -250,6 +557,9 @@ static void CompletePartialC40Text(DmtxEncodeStream *stream, DmtxByteList *value
 static void CompletePartialX12(DmtxEncodeStream *stream, DmtxByteList *valueList, int sizeIdxRequest);
 static DmtxBoolean PartialX12ChunkRemains(DmtxEncodeStream *stream);
 static void PushCTXValues(DmtxByteList *valueList, DmtxByte inputValue, int targetScheme, DmtxPassFail *passFail);
+static int GetCTXValueCount(DmtxByte inputValue, int targetScheme);
+static DmtxBoolean ExpandCTXBasicTriplet(DmtxEncodeStream *stream, DmtxByteList *valueList);
+static const DmtxByte *GetCTXTable(int scheme);
 static DmtxBoolean IsCTX(int scheme);
 static void ShiftValueListBy3(DmtxByteList *list, DmtxPassFail *passFail);
 
@@ -11,6 +11,62 @@
  * \brief Data Matrix symbol attributes
  */
 
+/**
+ * Constant attributes for every symbol size, indexed by sizeIdx. Columns
+ * follow the field order of DmtxSymbolInfo:
+ *
+ *   symbol rows/cols, data region rows/cols, horiz/vert data regions,
+ *   mapping matrix rows/cols, interleaved blocks, block error words,
+ *   block max correctable, symbol data words, symbol error words,
+ *   symbol max correctable, { data words per interleaved block }
+ */
+static const DmtxSymbolInfo dmtxSymbolInfo[DmtxSymbolSquareCount + DmtxSymbolRectCount] = {
+   {  10,  10,   8,   8,   1,   1,   8,   8,   1,   5,   2,   3,   5,   2, { 3 } }, /* 10x10 */
+   {  12,  12,  10,  10,   1,   1,  10,  10,   1,   7,   3,   5,   7,   3, { 5 } }, /* 12x12 */
+   {  14,  14,  12,  12,   1,   1,  12,  12,   1,  10,   5,   8,  10,   5, { 8 } }, /* 14x14 */
+   {  16,  16,  14,  14,   1,   1,  14,  14,   1,  12,   6,  12,  12,   6, { 12 } }, /* 16x16 */
+   {  18,  18,  16,  16,   1,   1,  16,  16,   1,  14,   7,  18,  14,   7, { 18 } }, /* 18x18 */
+   {  20,  20,  18,  18,   1,   1,  18,  18,   1,  18,   9,  22,  18,   9, { 22 } }, /* 20x20 */
+   {  22,  22,  20,  20,   1,   1,  20,  20,   1,  20,  10,  30,  20,  10, { 30 } }, /* 22x22 */
+   {  24,  24,  22,  22,   1,   1,  22,  22,   1,  24,  12,  36,  24,  12, { 36 } }, /* 24x24 */
+   {  26,  26,  24,  24,   1,   1,  24,  24,   1,  28,  14,  44,  28,  14, { 44 } }, /* 26x26 */
+   {  32,  32,  14,  14,   2,   2,  28,  28,   1,  36,  18,  62,  36,  18, { 62 } }, /* 32x32 */
+   {  36,  36,  16,  16,   2,   2,  32,  32,   1,  42,  21,  86,  42,  21, { 86 } }, /* 36x36 */
+   {  40,  40,  18,  18,   2,   2,  36,  36,   1,  48,  24, 114,  48,  24, { 114 } }, /* 40x40 */
+   {  44,  44,  20,  20,   2,   2,  40,  40,   1,  56,  28, 144,  56,  28, { 144 } }, /* 44x44 */
+   {  48,  48,  22,  22,   2,   2,  44,  44,   1,  68,  34, 174,  68,  34, { 174 } }, /* 48x48 */
+   {  52,  52,  24,  24,   2,   2,  48,  48,   2,  42,  21, 204,  84,  42, { 102, 102 } }, /* 52x52 */
+   {  64,  64,  14,  14,   4,   4,  56,  56,   2,  56,  28, 280, 112,  56, { 140, 140 } }, /* 64x64 */
+   {  72,  72,  16,  16,   4,   4,  64,  64,   4,  36,  18, 368, 144,  72, { 92, 92, 92, 92 } }, /* 72x72 */
+   {  80,  80,  18,  18,   4,   4,  72,  72,   4,  48,  24, 456, 192,  96, { 114, 114, 114, 114 } }, /* 80x80 */
+   {  88,  88,  20,  20,   4,   4,  80,  80,   4,  56,  28, 576, 224, 112, { 144, 144, 144, 144 } }, /* 88x88 */
+   {  96,  96,  22,  22,   4,   4,  88,  88,   4,  68,  34, 696, 272, 136, { 174, 174, 174, 174 } }, /* 96x96 */
+   { 104, 104,  24,  24,   4,   4,  96,  96,   6,  56,  28, 816, 336, 168, { 136, 136, 136, 136, 136, 136 } }, /* 104x104 */
+   { 120, 120,  18,  18,   6,   6, 108, 108,   6,  68,  34, 1050, 408, 204, { 175, 175, 175, 175, 175, 175 } }, /* 120x120 */
+   { 132, 132,  20,  20,   6,   6, 120, 120,   8,  62,  31, 1304, 496, 248, { 163, 163, 163, 163, 163, 163, 163, 163 } }, /* 132x132 */
+   { 144, 144,  22,  22,   6,   6, 132, 132,  10,  62,  31, 1558, 620, 310, { 156, 156, 156, 156, 156, 156, 156, 156, 155, 155 } }, /* 144x144 */
+   {   8,  18,   6,  16,   1,   1,   6,  16,   1,   7,   3,   5,   7,   3, { 5 } }, /* 8x18 */
+   {   8,  32,   6,  14,   2,   1,   6,  28,   1,  11,   5,  10,  11,   5, { 10 } }, /* 8x32 */
+   {  12,  26,  10,  24,   1,   1,  10,  24,   1,  14,   7,  16,  14,   7, { 16 } }, /* 12x26 */
+   {  12,  36,  10,  16,   2,   1,  10,  32,   1,  18,   9,  22,  18,   9, { 22 } }, /* 12x36 */
+   {  16,  36,  14,  16,   2,   1,  14,  32,   1,  24,  12,  32,  24,  12, { 32 } }, /* 16x36 */
+   {  16,  48,  14,  22,   2,   1,  14,  44,   1,  28,  14,  49,  28,  14, { 49 } }  /* 16x48 */
+};
+
+/**
+ * \brief  Retrieve all attributes for a symbol size in a single lookup
+ * \param  sizeIdx
+ * \return Pointer to constant attribute struct (or NULL if sizeIdx is invalid)
+ */
+const DmtxSymbolInfo *
+dmtxGetSymbolInfo(int sizeIdx)
+{
+   if(sizeIdx < 0 || sizeIdx >= DmtxSymbolSquareCount + DmtxSymbolRectCount)
+      return NULL;
+
+   return &dmtxSymbolInfo[sizeIdx];
+}
+
 /**
  * \brief  Retrieve property based on symbol size
  * \param  attribute
@@ -20,93 +76,41 @@
 int
 dmtxGetSymbolAttribute(int attribute, int sizeIdx)
 {
-   static const int symbolRows[] = { 10, 12, 14, 16, 18, 20,  22,  24,  26,
-                                                 32, 36, 40,  44,  48,  52,
-                                                 64, 72, 80,  88,  96, 104,
-                                                        120, 132, 144,
-                                                  8,  8, 12,  12,  16,  16 };
-
-   static const int symbolCols[] = { 10, 12, 14, 16, 18, 20,  22,  24,  26,
-                                                 32, 36, 40,  44,  48,  52,
-                                                 64, 72, 80,  88,  96, 104,
-                                                        120, 132, 144,
-                                                 18, 32, 26,  36,  36,  48 };
-
-   static const int dataRegionRows[] = { 8, 10, 12, 14, 16, 18, 20, 22, 24,
-                                                    14, 16, 18, 20, 22, 24,
-                                                    14, 16, 18, 20, 22, 24,
-                                                            18, 20, 22,
-                                                     6,  6, 10, 10, 14, 14 };
-
-   static const int dataRegionCols[] = { 8, 10, 12, 14, 16, 18, 20, 22, 24,
-                                                    14, 16, 18, 20, 22, 24,
-                                                    14, 16, 18, 20, 22, 24,
-                                                            18, 20, 22,
-                                                    16, 14, 24, 16, 16, 22 };
-
-   static const int horizDataRegions[] = { 1, 1, 1, 1, 1, 1, 1, 1, 1,
-                                                    2, 2, 2, 2, 2, 2,
-                                                    4, 4, 4, 4, 4, 4,
-                                                          6, 6, 6,
-                                                    1, 2, 1, 2, 2, 2 };
-
-   static const int interleavedBlocks[] = { 1, 1, 1, 1, 1, 1, 1,  1, 1,
-                                                     1, 1, 1, 1,  1, 2,
-                                                     2, 4, 4, 4,  4, 6,
-                                                           6, 8, 10,
-                                                     1, 1, 1, 1,  1, 1 };
-
-   static const int symbolDataWords[] = { 3, 5, 8,  12,   18,   22,   30,   36,  44,
-                                                    62,   86,  114,  144,  174, 204,
-                                                   280,  368,  456,  576,  696, 816,
-                                                              1050, 1304, 1558,
-                                                     5,   10,   16,   22,   32,  49 };
-
-   static const int blockErrorWords[] = { 5, 7, 10, 12, 14, 18, 20, 24, 28,
-                                                    36, 42, 48, 56, 68, 42,
-                                                    56, 36, 48, 56, 68, 56,
-                                                            68, 62, 62,
-                                                     7, 11, 14, 18, 24, 28 };
-
-   static const int blockMaxCorrectable[] = { 2, 3, 5,  6,  7,  9,  10,  12,  14,
-                                                       18, 21, 24,  28,  34,  21,
-                                                       28, 18, 24,  28,  34,  28,
-                                                               34,  31,  31,
-                                                   3,  5,  7,   9,  12,  14 };
+   const DmtxSymbolInfo *info;
 
-   if(sizeIdx < 0 || sizeIdx >= DmtxSymbolSquareCount + DmtxSymbolRectCount)
+   info = dmtxGetSymbolInfo(sizeIdx);
+   if(info == NULL)
       return DmtxUndefined;
 
    switch(attribute) {
       case DmtxSymAttribSymbolRows:
-         return symbolRows[sizeIdx];
+         return info->symbolRows;
       case DmtxSymAttribSymbolCols:
-         return symbolCols[sizeIdx];
+         return info->symbolCols;
       case DmtxSymAttribDataRegionRows:
-         return dataRegionRows[sizeIdx];
+         return info->dataRegionRows;
       case DmtxSymAttribDataRegionCols:
-         return dataRegionCols[sizeIdx];
+         return info->dataRegionCols;
       case DmtxSymAttribHorizDataRegions:
-         return horizDataRegions[sizeIdx];
+         return info->horizDataRegions;
       case DmtxSymAttribVertDataRegions:
-         return (sizeIdx < DmtxSymbolSquareCount) ? horizDataRegions[sizeIdx] : 1;
+         return info->vertDataRegions;
       case DmtxSymAttribMappingMatrixRows:
-         return dataRegionRows[sizeIdx] *
-               dmtxGetSymbolAttribute(DmtxSymAttribVertDataRegions, sizeIdx);
+         return info->mappingRows;
       case DmtxSymAttribMappingMatrixCols:
-         return dataRegionCols[sizeIdx] * horizDataRegions[sizeIdx];
+         return info->mappingCols;
       case DmtxSymAttribInterleavedBlocks:
-         return interleavedBlocks[sizeIdx];
+         return info->interleavedBlocks;
       case DmtxSymAttribBlockErrorWords:
-         return blockErrorWords[sizeIdx];
+         return info->blockErrorWords;
       case DmtxSymAttribBlockMaxCorrectable:
-         return blockMaxCorrectable[sizeIdx];
+         return info->blockMaxCorrectable;
       case DmtxSymAttribSymbolDataWords:
-         return symbolDataWords[sizeIdx];
+         return info->symbolDataWords;
       case DmtxSymAttribSymbolErrorWords:
-         return blockErrorWords[sizeIdx] * interleavedBlocks[sizeIdx];
+         return info->symbolErrorWords;
       case DmtxSymAttribSymbolMaxCorrectable:
-         return blockMaxCorrectable[sizeIdx] * interleavedBlocks[sizeIdx];
+         return info->symbolMaxCorrectable;
    }
 
    return DmtxUndefined;
@@ -121,17 +125,18 @@ dmtxGetSymbolAttribute(int attribute, int sizeIdx)
 int
 dmtxGetBlockDataSize(int sizeIdx, int blockIdx)
 {
-   int symbolDataWords;
-   int interleavedBlocks;
    int count;
+   const DmtxSymbolInfo *info;
 
-   symbolDataWords = dmtxGetSymbolAttribute(DmtxSymAttribSymbolDataWords, sizeIdx);
-   interleavedBlocks = dmtxGetSymbolAttribute(DmtxSymAttribInterleavedBlocks, sizeIdx);
-
-   if(symbolDataWords < 1 || interleavedBlocks < 1)
+   info = dmtxGetSymbolInfo(sizeIdx);
+   if(info == NULL)
       return DmtxUndefined;
 
-   count = (int)(symbolDataWords/interleavedBlocks);
+   if(blockIdx >= 0 && blockIdx < info->interleavedBlocks)
+      return info->blockDataWords[blockIdx];
+
+   /* Blocks outside the symbol get an even share, as they always have */
+   count = info->symbolDataWords / info->interleavedBlocks;
 
    return (sizeIdx == DmtxSymbol144x144 && blockIdx < 8) ? count + 1 : count;
 }
@@ -163,7 +168,7 @@ FindSymbolSize(int dataWords, int sizeIdxRequest)
       }
 
       for(sizeIdx = idxBeg; sizeIdx < idxEnd; sizeIdx++) {
-         if(dmtxGetSymbolAttribute(DmtxSymAttribSymbolDataWords, sizeIdx) >= dataWords)
+         if(dmtxSymbolInfo[sizeIdx].symbolDataWords >= dataWords)
             break;
       }
 
@@ -174,7 +179,8 @@ FindSymbolSize(int dataWords, int sizeIdxRequest)
       sizeIdx = sizeIdxRequest;
    }
 
-   if(dataWords > dmtxGetSymbolAttribute(DmtxSymAttribSymbolDataWords, sizeIdx))
+   if(sizeIdx < 0 || sizeIdx >= DmtxSymbolSquareCount + DmtxSymbolRectCount ||
+         dataWords > dmtxSymbolInfo[sizeIdx].symbolDataWords)
       return DmtxUndefined;
 
    return sizeIdx;
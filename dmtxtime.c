@@ -141,5 +141,25 @@ dmtxTimeExceeded(DmtxTime timeout)
    return (now.sec > timeout.sec || (now.sec == timeout.sec && now.usec > timeout.usec));
 }
 
+/**
+ * \brief  Measure time passed since start
+ *
+ * Resolution is that of dmtxTimeNow(), so short intervals only add up to the
+ * right total over many measurements.
+ *
+ * \param  start
+ * \return Nanoseconds since start
+ */
+static double
+TimeElapsedNsec(DmtxTime start)
+{
+   DmtxTime now;
+
+   now = dmtxTimeNow();
+
+   return (double)(now.sec - start.sec) * 1e9 +
+         ((double)now.usec - (double)start.usec) * 1e3;
+}
+
 #undef DMTX_TIME_PREC_USEC
 #undef DMTX_USEC_PER_SEC
@@ -0,0 +1,593 @@
+/**
+ * libdmtx - Data Matrix Encoding/Decoding Library
+ * Copyright 2011 Mike Laughton. All rights reserved.
+ *
+ * See LICENSE file in the main project directory for full
+ * terms of use and distribution.
+ *
+ * Contact: Mike Laughton <mike@dragonflylogic.com>
+ *
+ * \file decode_bench.c
+ *
+ * Measures decode throughput, latency, and success rate without a display.
+ * The corpus is built with the library's own encoder: one symbol for each
+ * of the 30 symbol sizes in each encodation scheme, filled close to
+ * capacity with pseudo-random data. Every symbol is then rendered under a
+ * series of synthetic conditions (rotation, perspective, blur, noise,
+ * contrast loss, and clutter) and decoded. A decode only counts as a success
+ * if it returns the original payload.
+ *
+ * Latency covers decoder setup, region search, and decoding of one image,
+ * measured with clock(). Each image gets the same search timeout an
+ * application would pass to dmtxRegionFindNext(), since an unreadable image
+ * can otherwise keep the search busy for many seconds. The corpus is
+ * generated from a fixed seed, so runs of different library versions see
+ * identical images.
+ *
+ * Usage: decode_bench [-n iterations] [-t timeout_msec] [-o results.csv]
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "../../dmtx.h"
+
+#define PAYLOAD_MAX      4096
+#define MODULE_SIZE         4
+#define MARGIN_SIZE         8
+#define CONDITION_COUNT     (int)(sizeof(conditions)/sizeof(conditions[0]))
+#define SCHEME_COUNT        (int)(sizeof(schemes)/sizeof(schemes[0]))
+#define SYMBOL_COUNT        (DmtxSymbolSquareCount + DmtxSymbolRectCount)
+
+#ifndef M_PI
+#define M_PI      3.14159265358979323846
+#endif
+
+typedef struct {
+   const char     *name;
+   double          angle;       /* Rotation in degrees */
+   double          perspective; /* Keystone strength, 0 for none */
+   int             blurPasses;  /* 3x3 box blur passes */
+   double          noise;       /* Standard deviation of added noise */
+   double          contrast;    /* Fraction of original contrast kept */
+   int             clutter;     /* Dark shapes scattered around symbol */
+} Condition;
+
+typedef struct {
+   int             scheme;
+   const char     *name;
+   const char     *charset;     /* Payload characters, or NULL for any byte */
+   int             charsPerWord2; /* Twice the characters per data codeword */
+} Scheme;
+
+typedef struct {
+   long            images;
+   long            decoded;
+   long            timeouts;
+   long            samples;
+   double         *msec;        /* Latency of every decode */
+   double          totalMsec;
+} ConditionResult;
+
+typedef struct {
+   unsigned char  *pxl;
+   int             width;
+   int             height;
+} GrayImage;
+
+static const Condition conditions[] = {
+   /*  name           angle  persp  blur  noise  contrast  clutter */
+   { "clean",           0.0,  0.00,   0,    0.0,   1.00,      0 },
+   { "rotate-17",      17.0,  0.00,   0,    0.0,   1.00,      0 },
+   { "rotate-45",      45.0,  0.00,   0,    0.0,   1.00,      0 },
+   { "perspective",     5.0,  0.30,   0,    0.0,   1.00,      0 },
+   { "blur",            0.0,  0.00,   2,    0.0,   1.00,      0 },
+   { "noise",           0.0,  0.00,   0,   24.0,   1.00,      0 },
+   { "low-contrast",    0.0,  0.00,   0,    0.0,   0.25,      0 },
+   { "clutter",         0.0,  0.00,   0,    0.0,   1.00,     24 },
+   { "combined",       30.0,  0.15,   1,   12.0,   0.50,     12 }
+};
+
+static const Scheme schemes[] = {
+   { DmtxSchemeAscii,   "ascii",   "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz !?-.", 2 },
+   { DmtxSchemeC40,     "c40",     "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789 ", 3 },
+   { DmtxSchemeText,    "text",    "abcdefghijklmnopqrstuvwxyz0123456789 ", 3 },
+   { DmtxSchemeX12,     "x12",     "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789 *>\r", 3 },
+   { DmtxSchemeEdifact, "edifact", "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ !?-./:;<=>@[]^", 3 },
+   { DmtxSchemeBase256, "base256", NULL, 2 }
+};
+
+static unsigned long randState;
+
+static DmtxEncode *encodeSymbol(const Scheme *scheme, int sizeIdx,
+      unsigned char *payload, int *payloadSize);
+static void fillPayload(const Scheme *scheme, unsigned char *payload, int payloadSize);
+static DmtxPassFail renderCondition(DmtxImage *src, const Condition *cond, GrayImage *dst);
+static void addClutter(GrayImage *img, int count, double radius);
+static void blurImage(GrayImage *img, int passes);
+static void adjustImage(GrayImage *img, double contrast, double noise);
+static DmtxBoolean decodeImage(GrayImage *img, unsigned char *payload, int payloadSize,
+      int timeoutMsec, double *msec, DmtxBoolean *timedOut);
+static double percentile(double *sorted, long count, double fraction);
+static int compareDouble(const void *a, const void *b);
+static void seedRandom(unsigned long seed);
+static double nextRandom(void);
+
+int
+main(int argc, char *argv[])
+{
+   int i, c, s, sizeIdx, iterations, timeoutMsec, payloadSize;
+   int symbolCount, skipCount;
+   double msec;
+   const char *outPath;
+   unsigned char payload[PAYLOAD_MAX];
+   DmtxBoolean success, timedOut;
+   DmtxEncode *enc;
+   GrayImage img;
+   ConditionResult result[CONDITION_COUNT];
+   ConditionResult *r;
+   FILE *fp;
+
+   iterations = 1;
+   timeoutMsec = 500;
+   outPath = NULL;
+   for(i = 1; i < argc; i++)
+   {
+      if(strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+         iterations = atoi(argv[++i]);
+      else if(strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+         timeoutMsec = atoi(argv[++i]);
+      else if(strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+         outPath = argv[++i];
+      else
+         iterations = 0;
+   }
+
+   if(iterations < 1 || timeoutMsec < 1)
+   {
+      fprintf(stderr, "usage: %s [-n iterations] [-t timeout_msec] [-o results.csv]\n", argv[0]);
+      exit(1);
+   }
+
+   memset(result, 0x00, sizeof(result));
+   for(c = 0; c < CONDITION_COUNT; c++)
+   {
+      result[c].msec = (double *)malloc(SYMBOL_COUNT * SCHEME_COUNT * iterations * sizeof(double));
+      if(result[c].msec == NULL)
+      {
+         fprintf(stderr, "out of memory\n");
+         exit(1);
+      }
+   }
+
+   img.pxl = NULL;
+   symbolCount = skipCount = 0;
+
+   for(s = 0; s < SCHEME_COUNT; s++)
+   {
+      for(sizeIdx = 0; sizeIdx < SYMBOL_COUNT; sizeIdx++)
+      {
+         enc = encodeSymbol(&schemes[s], sizeIdx, payload, &payloadSize);
+         if(enc == NULL)
+         {
+            skipCount++;
+            continue;
+         }
+         symbolCount++;
+
+         for(c = 0; c < CONDITION_COUNT; c++)
+         {
+            seedRandom((unsigned long)((s * SYMBOL_COUNT + sizeIdx) * CONDITION_COUNT + c + 1));
+            if(renderCondition(enc->image, &conditions[c], &img) == DmtxFail)
+            {
+               fprintf(stderr, "out of memory\n");
+               exit(1);
+            }
+
+            r = &result[c];
+            r->images++;
+            for(i = 0; i < iterations; i++)
+            {
+               success = decodeImage(&img, payload, payloadSize, timeoutMsec,
+                     &msec, &timedOut);
+               r->msec[r->samples++] = msec;
+               r->totalMsec += msec;
+               if(i == 0 && success == DmtxTrue)
+                  r->decoded++;
+               if(i == 0 && timedOut == DmtxTrue)
+                  r->timeouts++;
+            }
+         }
+
+         dmtxEncodeDestroy(&enc);
+      }
+   }
+
+   free(img.pxl);
+
+   fp = NULL;
+   if(outPath != NULL)
+   {
+      fp = fopen(outPath, "w");
+      if(fp == NULL)
+      {
+         fprintf(stderr, "%s: unable to open for writing\n", outPath);
+         exit(1);
+      }
+      fprintf(fp, "version,condition,timeout_msec,images,decoded,timeouts,success_rate,"
+            "images_per_sec,p50_msec,p90_msec,p99_msec,max_msec\n");
+   }
+
+   fprintf(stdout, "libdmtx %s: %d symbols (%d size/scheme combinations skipped), "
+         "%d iteration(s), %d msec timeout\n\n", dmtxVersion(), symbolCount, skipCount,
+         iterations, timeoutMsec);
+   fprintf(stdout, "%-14s %6s %8s %8s %10s %9s %9s %9s %9s\n", "condition", "images",
+         "success", "timeouts", "images/s", "p50 ms", "p90 ms", "p99 ms", "max ms");
+
+   for(c = 0; c < CONDITION_COUNT; c++)
+   {
+      r = &result[c];
+      qsort(r->msec, r->samples, sizeof(double), compareDouble);
+
+      fprintf(stdout, "%-14s %6ld %7.1f%% %8ld %10.1f %9.3f %9.3f %9.3f %9.3f\n",
+            conditions[c].name, r->images,
+            (r->images > 0) ? 100.0 * r->decoded / r->images : 0.0, r->timeouts,
+            (r->totalMsec > 0.0) ? 1000.0 * r->samples / r->totalMsec : 0.0,
+            percentile(r->msec, r->samples, 0.50), percentile(r->msec, r->samples, 0.90),
+            percentile(r->msec, r->samples, 0.99), percentile(r->msec, r->samples, 1.00));
+
+      if(fp != NULL)
+         fprintf(fp, "%s,%s,%d,%ld,%ld,%ld,%.4f,%.2f,%.4f,%.4f,%.4f,%.4f\n", dmtxVersion(),
+               conditions[c].name, timeoutMsec, r->images, r->decoded, r->timeouts,
+               (r->images > 0) ? (double)r->decoded / r->images : 0.0,
+               (r->totalMsec > 0.0) ? 1000.0 * r->samples / r->totalMsec : 0.0,
+               percentile(r->msec, r->samples, 0.50), percentile(r->msec, r->samples, 0.90),
+               percentile(r->msec, r->samples, 0.99), percentile(r->msec, r->samples, 1.00));
+
+      free(r->msec);
+   }
+
+   if(fp != NULL)
+      fclose(fp);
+
+   exit(0);
+}
+
+/**
+ * Encode the longest payload of the scheme's characters that fits the
+ * requested symbol size. Returns NULL if none fits (e.g. EDIFACT in the
+ * smallest sizes).
+ */
+static DmtxEncode *
+encodeSymbol(const Scheme *scheme, int sizeIdx, unsigned char *payload, int *payloadSize)
+{
+   int size;
+   DmtxEncode *enc;
+
+   size = dmtxGetSymbolAttribute(DmtxSymAttribSymbolDataWords, sizeIdx) *
+         scheme->charsPerWord2 / 2;
+   if(size > PAYLOAD_MAX)
+      size = PAYLOAD_MAX;
+
+   seedRandom((unsigned long)(scheme->scheme * 1000 + sizeIdx + 1));
+   fillPayload(scheme, payload, size);
+
+   for(; size > 0; size--)
+   {
+      enc = dmtxEncodeCreate();
+      if(enc == NULL)
+         return NULL;
+
+      dmtxEncodeSetProp(enc, DmtxPropScheme, scheme->scheme);
+      dmtxEncodeSetProp(enc, DmtxPropSizeRequest, sizeIdx);
+      dmtxEncodeSetProp(enc, DmtxPropModuleSize, MODULE_SIZE);
+      dmtxEncodeSetProp(enc, DmtxPropMarginSize, MARGIN_SIZE);
+      dmtxEncodeSetProp(enc, DmtxPropPixelPacking, DmtxPack8bppK);
+
+      if(dmtxEncodeDataMatrix(enc, size, payload) == DmtxPass)
+      {
+         *payloadSize = size;
+         return enc;
+      }
+
+      dmtxEncodeDestroy(&enc);
+   }
+
+   return NULL;
+}
+
+/**
+ *
+ *
+ */
+static void
+fillPayload(const Scheme *scheme, unsigned char *payload, int payloadSize)
+{
+   int i, charsetSize;
+
+   charsetSize = (scheme->charset == NULL) ? 256 : (int)strlen(scheme->charset);
+
+   for(i = 0; i < payloadSize; i++)
+   {
+      if(scheme->charset == NULL)
+         payload[i] = (unsigned char)(nextRandom() * charsetSize);
+      else
+         payload[i] = (unsigned char)scheme->charset[(int)(nextRandom() * charsetSize)];
+   }
+}
+
+/**
+ * Draw the encoded symbol into a square canvas under one condition. The
+ * canvas leaves room around the symbol for any rotation, and each canvas
+ * pixel is mapped back through the perspective and rotation onto the
+ * source, which is sampled bilinearly.
+ */
+static DmtxPassFail
+renderCondition(DmtxImage *src, const Condition *cond, GrayImage *dst)
+{
+   int x, y, sx, sy, side;
+   double radius, half, cosA, sinA, denom;
+   double dx, dy, px, py, fx, fy, value;
+   unsigned char background, *srcPxl;
+
+   radius = 0.5 * sqrt((double)(src->width * src->width + src->height * src->height));
+   side = (int)(2.0 * radius * 1.2) + 32;
+   half = side / 2.0;
+
+   free(dst->pxl);
+   dst->pxl = (unsigned char *)malloc(side * side);
+   if(dst->pxl == NULL)
+      return DmtxFail;
+   dst->width = dst->height = side;
+
+   srcPxl = src->pxl;
+   background = srcPxl[0];
+   cosA = cos(cond->angle * M_PI / 180.0);
+   sinA = sin(cond->angle * M_PI / 180.0);
+
+   for(y = 0; y < side; y++)
+   {
+      for(x = 0; x < side; x++)
+      {
+         /* Undo perspective, then rotation */
+         dx = x + 0.5 - half;
+         dy = y + 0.5 - half;
+         denom = 1.0 - cond->perspective * dy / half;
+         dx /= denom;
+         dy /= denom;
+
+         px = cosA * dx + sinA * dy + src->width / 2.0 - 0.5;
+         py = -sinA * dx + cosA * dy + src->height / 2.0 - 0.5;
+
+         sx = (int)floor(px);
+         sy = (int)floor(py);
+         if(denom <= 0.0 || sx < 0 || sy < 0 || sx + 1 >= src->width || sy + 1 >= src->height)
+         {
+            dst->pxl[y * side + x] = background;
+            continue;
+         }
+
+         fx = px - sx;
+         fy = py - sy;
+         value = (1.0 - fy) * ((1.0 - fx) * srcPxl[sy * src->rowSizeBytes + sx] +
+               fx * srcPxl[sy * src->rowSizeBytes + sx + 1]) +
+               fy * ((1.0 - fx) * srcPxl[(sy + 1) * src->rowSizeBytes + sx] +
+               fx * srcPxl[(sy + 1) * src->rowSizeBytes + sx + 1]);
+         dst->pxl[y * side + x] = (unsigned char)(value + 0.5);
+      }
+   }
+
+   if(cond->clutter > 0)
+      addClutter(dst, cond->clutter, radius / (1.0 - cond->perspective));
+   if(cond->blurPasses > 0)
+      blurImage(dst, cond->blurPasses);
+   if(cond->contrast < 1.0 || cond->noise > 0.0)
+      adjustImage(dst, cond->contrast, cond->noise);
+
+   return DmtxPass;
+}
+
+/**
+ * Scatter dark rectangles and lines outside the circle that holds the
+ * symbol, giving the region search edges to reject.
+ */
+static void
+addClutter(GrayImage *img, int count, double radius)
+{
+   int x, y, x0, y0, w, h, placed, attempts;
+   double half, cx, cy;
+
+   half = img->width / 2.0;
+   placed = attempts = 0;
+
+   while(placed < count && attempts++ < count * 100)
+   {
+      w = 2 + (int)(nextRandom() * 24);
+      h = (nextRandom() < 0.5) ? 2 + (int)(nextRandom() * 4) : 2 + (int)(nextRandom() * 24);
+      if(nextRandom() < 0.5)
+      {
+         x = w;
+         w = h;
+         h = x;
+      }
+      x0 = (int)(nextRandom() * (img->width - w));
+      y0 = (int)(nextRandom() * (img->height - h));
+
+      /* Farthest corner from center must stay clear of the symbol */
+      cx = (x0 + w / 2.0 < half) ? x0 + w : x0;
+      cy = (y0 + h / 2.0 < half) ? y0 + h : y0;
+      if(sqrt((cx - half) * (cx - half) + (cy - half) * (cy - half)) < radius + 4.0)
+         continue;
+
+      for(y = y0; y < y0 + h; y++)
+         for(x = x0; x < x0 + w; x++)
+            img->pxl[y * img->width + x] = (unsigned char)(nextRandom() * 64);
+
+      placed++;
+   }
+}
+
+/**
+ *
+ *
+ */
+static void
+blurImage(GrayImage *img, int passes)
+{
+   int i, x, y, sx, sy, count, sum;
+   unsigned char *tmp;
+
+   tmp = (unsigned char *)malloc(img->width * img->height);
+   if(tmp == NULL)
+      return;
+
+   for(i = 0; i < passes; i++)
+   {
+      memcpy(tmp, img->pxl, img->width * img->height);
+      for(y = 0; y < img->height; y++)
+      {
+         for(x = 0; x < img->width; x++)
+         {
+            sum = count = 0;
+            for(sy = y - 1; sy <= y + 1; sy++)
+            {
+               for(sx = x - 1; sx <= x + 1; sx++)
+               {
+                  if(sx < 0 || sy < 0 || sx >= img->width || sy >= img->height)
+                     continue;
+                  sum += tmp[sy * img->width + sx];
+                  count++;
+               }
+            }
+            img->pxl[y * img->width + x] = (unsigned char)((sum + count / 2) / count);
+         }
+      }
+   }
+
+   free(tmp);
+}
+
+/**
+ * Compress contrast around mid-gray, then add roughly Gaussian noise (sum
+ * of four uniform samples).
+ */
+static void
+adjustImage(GrayImage *img, double contrast, double noise)
+{
+   int i;
+   double value;
+
+   for(i = 0; i < img->width * img->height; i++)
+   {
+      value = 128.0 + (img->pxl[i] - 128.0) * contrast;
+      if(noise > 0.0)
+         value += noise * sqrt(3.0) *
+               (nextRandom() + nextRandom() + nextRandom() + nextRandom() - 2.0);
+
+      img->pxl[i] = (unsigned char)((value < 0.0) ? 0 : (value > 255.0) ? 255 : value + 0.5);
+   }
+}
+
+/**
+ * Search the image for regions until one decodes to the payload, none are
+ * left, or the search times out.
+ */
+static DmtxBoolean
+decodeImage(GrayImage *img, unsigned char *payload, int payloadSize, int timeoutMsec,
+      double *msec, DmtxBoolean *timedOut)
+{
+   clock_t start;
+   DmtxTime timeout;
+   DmtxBoolean match;
+   DmtxImage *dimg;
+   DmtxDecode *dec;
+   DmtxRegion *reg;
+   DmtxMessage *msg;
+
+   match = DmtxFalse;
+   *timedOut = DmtxFalse;
+   start = clock();
+   timeout = dmtxTimeAdd(dmtxTimeNow(), timeoutMsec);
+
+   dimg = dmtxImageCreate(img->pxl, img->width, img->height, DmtxPack8bppK);
+   dec = (dimg == NULL) ? NULL : dmtxDecodeCreate(dimg, 1);
+   if(dec != NULL)
+   {
+      while(match == DmtxFalse && (reg = dmtxRegionFindNext(dec, &timeout)) != NULL)
+      {
+         msg = dmtxDecodeMatrixRegion(dec, reg, DmtxUndefined);
+         if(msg != NULL)
+         {
+            if(msg->outputIdx == payloadSize &&
+                  memcmp(msg->output, payload, payloadSize) == 0)
+               match = DmtxTrue;
+            dmtxMessageDestroy(&msg);
+         }
+         dmtxRegionDestroy(&reg);
+      }
+      if(match == DmtxFalse && dmtxTimeExceeded(timeout))
+         *timedOut = DmtxTrue;
+      dmtxDecodeDestroy(&dec);
+   }
+   dmtxImageDestroy(&dimg);
+
+   *msec = 1000.0 * (clock() - start) / CLOCKS_PER_SEC;
+
+   return match;
+}
+
+/**
+ *
+ *
+ */
+static double
+percentile(double *sorted, long count, double fraction)
+{
+   long idx;
+
+   if(count < 1)
+      return 0.0;
+
+   idx = (long)ceil(fraction * count) - 1;
+
+   return sorted[(idx < 0) ? 0 : idx];
+}
+
+/**
+ *
+ *
+ */
+static int
+compareDouble(const void *a, const void *b)
+{
+   double da, db;
+
+   da = *(const double *)a;
+   db = *(const double *)b;
+
+   return (da < db) ? -1 : (da > db) ? 1 : 0;
+}
+
+/**
+ * Linear congruential generator, so the corpus doesn't depend on the C
+ * library's rand()
+ */
+static void
+seedRandom(unsigned long seed)
+{
+   randState = seed;
+}
+
+/**
+ *
+ *
+ */
+static double
+nextRandom(void)
+{
+   randState = (randState * 1103515245UL + 12345UL) & 0x7fffffffUL;
+
+   return (double)(randState >> 8) / (double)0x800000UL;
+}
@@ -0,0 +1,299 @@
+/**
+ * libdmtx - Data Matrix Encoding/Decoding Library
+ * Copyright 2011 Mike Laughton. All rights reserved.
+ *
+ * See LICENSE file in the main project directory for full
+ * terms of use and distribution.
+ *
+ * Contact: Mike Laughton <mike@dragonflylogic.com>
+ *
+ * \file encode_batch.c
+ *
+ * Encodes every line of a text file as its own Data Matrix symbol using
+ * dmtxEncodeBatch(), optionally writing each one to a binary PPM file named
+ * from a printf-style pattern and the line number. Lines are read and encoded
+ * in blocks so memory use stays flat for files of any length. Lines longer
+ * than PAYLOAD_MAX - 1 bytes are reported as failures rather than encoded.
+ *
+ * Usage: encode_batch [-t threads] [-e scheme] [-d module] [-m margin]
+ *                     [-o pattern] file
+ *   e.g. encode_batch -t 8 -e f -o labels/label%06d.ppm serials.txt
+ *
+ * Scheme is one of b (auto-best), f (auto-fast), a (ASCII), c (C40),
+ * t (Text), x (X12), e (EDIFACT), or 8 (Base 256).
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "../../dmtx.h"
+
+#define PAYLOAD_MAX 4096
+#define BLOCK_JOBS  1024
+#define PATH_SIZE   1024
+#define LINE_DIGITS 10
+
+typedef struct {
+   DmtxEncode     *enc;
+   const char     *pattern;
+   unsigned char  *tooLong;
+   long            firstLine;
+   long            passCount;
+   long            failCount;
+} WriteContext;
+
+static int readBlock(FILE *fp, unsigned char *storage, DmtxEncodeJob *jobs,
+      unsigned char *tooLong);
+static DmtxPassFail writeJob(DmtxEncodeJob *job, int jobIdx, void *userData);
+static DmtxPassFail writePpm(const char *path, DmtxEncodeJob *job);
+static int schemeFromChar(char c);
+static void usage(const char *name);
+
+int
+main(int argc, char *argv[])
+{
+   int i, jobCount, threadCount;
+   double seconds;
+   unsigned char *storage, *tooLong;
+   FILE *fp;
+   DmtxTime start, stop;
+   DmtxEncode *enc;
+   DmtxEncodeJob *jobs;
+   WriteContext ctx;
+
+   enc = dmtxEncodeCreate();
+   if(enc == NULL)
+      exit(1);
+
+   threadCount = 4;
+   ctx.pattern = NULL;
+
+   for(i = 1; i + 1 < argc && argv[i][0] == '-'; i += 2)
+   {
+      switch(argv[i][1])
+      {
+         case 't':
+            threadCount = atoi(argv[i+1]);
+            break;
+         case 'e':
+            if(schemeFromChar(argv[i+1][0]) == DmtxUndefined)
+               usage(argv[0]);
+            dmtxEncodeSetProp(enc, DmtxPropScheme, schemeFromChar(argv[i+1][0]));
+            break;
+         case 'd':
+            dmtxEncodeSetProp(enc, DmtxPropModuleSize, atoi(argv[i+1]));
+            break;
+         case 'm':
+            dmtxEncodeSetProp(enc, DmtxPropMarginSize, atoi(argv[i+1]));
+            break;
+         case 'o':
+            ctx.pattern = argv[i+1];
+            break;
+         default:
+            usage(argv[0]);
+            break;
+      }
+   }
+
+   if(i != argc - 1 || threadCount < 1)
+      usage(argv[0]);
+
+   /* Paths are built with sprintf(), so leave room for any line number */
+   if(ctx.pattern != NULL && strlen(ctx.pattern) + LINE_DIGITS >= PATH_SIZE)
+   {
+      fprintf(stderr, "%s: output pattern too long\n", argv[0]);
+      exit(1);
+   }
+
+   fp = fopen(argv[i], "rb");
+   if(fp == NULL)
+   {
+      fprintf(stderr, "%s: unable to open\n", argv[i]);
+      exit(1);
+   }
+
+   storage = (unsigned char *)malloc(BLOCK_JOBS * PAYLOAD_MAX);
+   jobs = (DmtxEncodeJob *)malloc(BLOCK_JOBS * sizeof(DmtxEncodeJob));
+   tooLong = (unsigned char *)malloc(BLOCK_JOBS);
+   if(storage == NULL || jobs == NULL || tooLong == NULL)
+   {
+      fprintf(stderr, "out of memory\n");
+      exit(1);
+   }
+
+   ctx.enc = enc;
+   ctx.tooLong = tooLong;
+   ctx.firstLine = 1;
+   ctx.passCount = ctx.failCount = 0;
+
+   start = dmtxTimeNow();
+   while((jobCount = readBlock(fp, storage, jobs, tooLong)) > 0)
+   {
+      if(dmtxEncodeBatch(enc, jobs, jobCount, threadCount, writeJob, &ctx) == DmtxFail)
+         break;
+      ctx.firstLine += jobCount;
+   }
+   stop = dmtxTimeNow();
+
+   fclose(fp);
+   free(tooLong);
+   free(jobs);
+   free(storage);
+   dmtxEncodeDestroy(&enc);
+
+   seconds = ((double)stop.sec - (double)start.sec) +
+         ((double)stop.usec - (double)start.usec) / 1000000.0;
+   fprintf(stdout, "%ld symbol(s), %ld failure(s), %.2f sec", ctx.passCount,
+         ctx.failCount, seconds);
+   if(seconds > 0.0)
+      fprintf(stdout, " (%.0f symbols/sec)", ctx.passCount / seconds);
+   fprintf(stdout, "\n");
+
+   exit((ctx.failCount == 0) ? 0 : 1);
+}
+
+/**
+ * Read up to BLOCK_JOBS lines, dropping line endings, and set up one job for
+ * each. Jobs ask the library to allocate their pixels. A line too long for
+ * its slot is skipped to its end and flagged in tooLong, so it still takes
+ * one job and later line numbers stay right.
+ */
+static int
+readBlock(FILE *fp, unsigned char *storage, DmtxEncodeJob *jobs,
+      unsigned char *tooLong)
+{
+   int c, jobCount, length;
+   char *line;
+
+   for(jobCount = 0; jobCount < BLOCK_JOBS; jobCount++)
+   {
+      line = (char *)storage + jobCount * PAYLOAD_MAX;
+      if(fgets(line, PAYLOAD_MAX, fp) == NULL)
+         break;
+
+      length = (int)strlen(line);
+      tooLong[jobCount] = 0;
+      if(length > 0 && line[length-1] != '\n' && (c = getc(fp)) != EOF)
+      {
+         if(c != '\n')
+         {
+            tooLong[jobCount] = 1;
+            while((c = getc(fp)) != '\n' && c != EOF)
+               ;
+         }
+      }
+
+      while(length > 0 && (line[length-1] == '\n' || line[length-1] == '\r'))
+         length--;
+
+      memset(&jobs[jobCount], 0x00, sizeof(DmtxEncodeJob));
+      jobs[jobCount].inputSize = tooLong[jobCount] ? 0 : length;
+      jobs[jobCount].inputString = (unsigned char *)line;
+   }
+
+   return jobCount;
+}
+
+/**
+ * Batch callback: receives finished jobs in input order
+ */
+static DmtxPassFail
+writeJob(DmtxEncodeJob *job, int jobIdx, void *userData)
+{
+   char path[PATH_SIZE];
+   long lineNumber;
+   DmtxPassFail passFail;
+   WriteContext *ctx;
+
+   ctx = (WriteContext *)userData;
+   lineNumber = ctx->firstLine + jobIdx;
+
+   passFail = job->passFail;
+   if(ctx->tooLong[jobIdx])
+   {
+      fprintf(stderr, "line %ld: longer than %d bytes\n", lineNumber, PAYLOAD_MAX - 1);
+      passFail = DmtxFail;
+   }
+   else if(passFail == DmtxFail)
+   {
+      fprintf(stderr, "line %ld: unable to encode\n", lineNumber);
+   }
+   else if(ctx->pattern != NULL)
+   {
+      sprintf(path, ctx->pattern, (int)lineNumber);
+      passFail = writePpm(path, job);
+      if(passFail == DmtxFail)
+         fprintf(stderr, "%s: unable to write\n", path);
+   }
+
+   if(passFail == DmtxPass)
+      ctx->passCount++;
+   else
+      ctx->failCount++;
+
+   dmtxEncodeJobRelease(ctx->enc, job);
+
+   return DmtxPass;
+}
+
+/**
+ *
+ *
+ */
+static DmtxPassFail
+writePpm(const char *path, DmtxEncodeJob *job)
+{
+   int row;
+   FILE *fp;
+
+   fp = fopen(path, "wb");
+   if(fp == NULL)
+      return DmtxFail;
+
+   fprintf(fp, "P6\n%d %d\n255\n", job->width, job->height);
+   for(row = 0; row < job->height; row++)
+   {
+      if(fwrite(job->pxl + row * job->rowSizeBytes, 3, job->width, fp) != (size_t)job->width)
+      {
+         fclose(fp);
+         return DmtxFail;
+      }
+   }
+
+   return (fclose(fp) == 0) ? DmtxPass : DmtxFail;
+}
+
+/**
+ *
+ *
+ */
+static int
+schemeFromChar(char c)
+{
+   switch(c)
+   {
+      case 'b': return DmtxSchemeAutoBest;
+      case 'f': return DmtxSchemeAutoFast;
+      case 'a': return DmtxSchemeAscii;
+      case 'c': return DmtxSchemeC40;
+      case 't': return DmtxSchemeText;
+      case 'x': return DmtxSchemeX12;
+      case 'e': return DmtxSchemeEdifact;
+      case '8': return DmtxSchemeBase256;
+      default: break;
+   }
+
+   return DmtxUndefined;
+}
+
+/**
+ *
+ *
+ */
+static void
+usage(const char *name)
+{
+   fprintf(stderr, "usage: %s [-t threads] [-e b|f|a|c|t|x|e|8] [-d module] "
+         "[-m margin] [-o pattern] file\n", name);
+   exit(1);
+}
@@ -0,0 +1,274 @@
+/**
+ * libdmtx - Data Matrix Encoding/Decoding Library
+ * Copyright 2011 Mike Laughton. All rights reserved.
+ *
+ * See LICENSE file in the main project directory for full
+ * terms of use and distribution.
+ *
+ * Contact: Mike Laughton <mike@dragonflylogic.com>
+ *
+ * \file encode_bench.c
+ *
+ * Compares --auto-fast against --auto-best on a set of payload files,
+ * reporting data codewords (padding excluded) and average encode time
+ * for each. Times cover the whole create/encode/destroy cycle and use
+ * clock() so they stay meaningful on builds without gettimeofday().
+ * Every auto-fast symbol is decoded again to confirm it holds the
+ * original payload.
+ *
+ * Usage: encode_bench [-n iterations] file...
+ *   e.g. encode_bench ../compare_test/input_messages/message_*.dat
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "../../dmtx.h"
+
+#define PAYLOAD_MAX 4096
+
+typedef struct {
+   int             sizeIdx;
+   int             dataWords;
+   double          usec;
+} EncodeResult;
+
+static int readPayload(const char *path, unsigned char *buf, int bufSize);
+static DmtxPassFail benchScheme(unsigned char *payload, int payloadSize,
+      int scheme, int iterations, EncodeResult *result);
+static int countDataWords(DmtxEncode *enc);
+static DmtxBoolean verifyRoundTrip(unsigned char *payload, int payloadSize);
+static const char *baseName(const char *path);
+
+int
+main(int argc, char *argv[])
+{
+   int i, argStart, iterations, payloadSize;
+   int fileCount, failCount;
+   long wordsBest, wordsFast;
+   double usecBest, usecFast;
+   unsigned char payload[PAYLOAD_MAX];
+   EncodeResult best, fast;
+
+   iterations = 20;
+   argStart = 1;
+   if(argc > 2 && strcmp(argv[1], "-n") == 0)
+   {
+      iterations = atoi(argv[2]);
+      argStart = 3;
+   }
+
+   if(argStart >= argc || iterations < 1)
+   {
+      fprintf(stderr, "usage: %s [-n iterations] file...\n", argv[0]);
+      exit(1);
+   }
+
+   fileCount = failCount = 0;
+   wordsBest = wordsFast = 0;
+   usecBest = usecFast = 0.0;
+
+   fprintf(stdout, "%-20s %5s %9s %9s %11s %11s\n", "payload", "bytes",
+         "best cw", "fast cw", "best usec", "fast usec");
+
+   for(i = argStart; i < argc; i++)
+   {
+      payloadSize = readPayload(argv[i], payload, sizeof(payload));
+      if(payloadSize < 1)
+      {
+         fprintf(stderr, "%s: unable to read payload\n", argv[i]);
+         failCount++;
+         continue;
+      }
+
+      if(benchScheme(payload, payloadSize, DmtxSchemeAutoBest, iterations, &best) == DmtxFail ||
+            benchScheme(payload, payloadSize, DmtxSchemeAutoFast, iterations, &fast) == DmtxFail)
+      {
+         fprintf(stdout, "%-20s %5d  (encode failed)\n", baseName(argv[i]), payloadSize);
+         failCount++;
+         continue;
+      }
+
+      if(verifyRoundTrip(payload, payloadSize) == DmtxFalse)
+      {
+         fprintf(stdout, "%-20s %5d  (auto-fast round trip failed)\n", baseName(argv[i]), payloadSize);
+         failCount++;
+         continue;
+      }
+
+      fprintf(stdout, "%-20s %5d %9d %9d %11.1f %11.1f\n", baseName(argv[i]), payloadSize,
+            best.dataWords, fast.dataWords, best.usec, fast.usec);
+
+      fileCount++;
+      wordsBest += best.dataWords;
+      wordsFast += fast.dataWords;
+      usecBest += best.usec;
+      usecFast += fast.usec;
+   }
+
+   fprintf(stdout, "\n%d payload(s), %d failure(s)\n", fileCount, failCount);
+   if(fileCount > 0)
+   {
+      fprintf(stdout, "data codewords: best %ld, fast %ld (%+.2f%%)\n", wordsBest,
+            wordsFast, 100.0 * (wordsFast - wordsBest) / wordsBest);
+      fprintf(stdout, "encode time:    best %.1f usec, fast %.1f usec (%.1fx faster)\n",
+            usecBest, usecFast, (usecFast > 0.0) ? usecBest / usecFast : 0.0);
+   }
+
+   exit((failCount == 0) ? 0 : 1);
+}
+
+/**
+ *
+ *
+ */
+static int
+readPayload(const char *path, unsigned char *buf, int bufSize)
+{
+   int size;
+   FILE *fp;
+
+   fp = fopen(path, "rb");
+   if(fp == NULL)
+      return -1;
+
+   size = (int)fread(buf, sizeof(unsigned char), bufSize, fp);
+   fclose(fp);
+
+   return size;
+}
+
+/**
+ *
+ *
+ */
+static DmtxPassFail
+benchScheme(unsigned char *payload, int payloadSize, int scheme, int iterations,
+      EncodeResult *result)
+{
+   int i;
+   clock_t start;
+   DmtxEncode *enc;
+
+   start = clock();
+   for(i = 0; i < iterations; i++)
+   {
+      enc = dmtxEncodeCreate();
+      if(enc == NULL)
+         return DmtxFail;
+
+      dmtxEncodeSetProp(enc, DmtxPropScheme, scheme);
+      dmtxEncodeSetProp(enc, DmtxPropModuleSize, 1);
+      dmtxEncodeSetProp(enc, DmtxPropMarginSize, 0);
+
+      if(dmtxEncodeDataMatrix(enc, payloadSize, payload) == DmtxFail)
+      {
+         dmtxEncodeDestroy(&enc);
+         return DmtxFail;
+      }
+
+      if(i == iterations - 1)
+      {
+         result->sizeIdx = enc->region.sizeIdx;
+         result->dataWords = countDataWords(enc);
+      }
+
+      dmtxEncodeDestroy(&enc);
+   }
+
+   result->usec = 1000000.0 * (clock() - start) / CLOCKS_PER_SEC / iterations;
+
+   return DmtxPass;
+}
+
+/**
+ * Count data codewords that precede the symbol's padding. The first pad
+ * codeword is always 129 and the rest follow the 253-state randomizing
+ * sequence, so trailing pads can be recognized and skipped.
+ */
+static int
+countDataWords(DmtxEncode *enc)
+{
+   int i, pad, dataWords;
+
+   dataWords = dmtxGetSymbolAttribute(DmtxSymAttribSymbolDataWords, enc->region.sizeIdx);
+
+   for(i = dataWords - 1; i > 0; i--)
+   {
+      pad = 129 + ((149 * (i + 1)) % 253) + 1;
+      if(pad > 254)
+         pad -= 254;
+      if(enc->message->code[i] != pad)
+         break;
+   }
+
+   return (enc->message->code[i] == 129) ? i : i + 1;
+}
+
+/**
+ *
+ *
+ */
+static DmtxBoolean
+verifyRoundTrip(unsigned char *payload, int payloadSize)
+{
+   DmtxBoolean match;
+   DmtxEncode *enc;
+   DmtxImage *img;
+   DmtxDecode *dec;
+   DmtxRegion *reg;
+   DmtxMessage *msg;
+
+   enc = dmtxEncodeCreate();
+   if(enc == NULL)
+      return DmtxFalse;
+
+   dmtxEncodeSetProp(enc, DmtxPropScheme, DmtxSchemeAutoFast);
+   dmtxEncodeSetProp(enc, DmtxPropModuleSize, 4);
+   dmtxEncodeSetProp(enc, DmtxPropMarginSize, 8);
+   if(dmtxEncodeDataMatrix(enc, payloadSize, payload) == DmtxFail)
+   {
+      dmtxEncodeDestroy(&enc);
+      return DmtxFalse;
+   }
+
+   match = DmtxFalse;
+   img = enc->image;
+   dec = dmtxDecodeCreate(img, 1);
+   if(dec != NULL)
+   {
+      reg = dmtxRegionFindNext(dec, NULL);
+      if(reg != NULL)
+      {
+         msg = dmtxDecodeMatrixRegion(dec, reg, DmtxUndefined);
+         if(msg != NULL)
+         {
+            if(msg->outputIdx == payloadSize &&
+                  memcmp(msg->output, payload, payloadSize) == 0)
+               match = DmtxTrue;
+            dmtxMessageDestroy(&msg);
+         }
+         dmtxRegionDestroy(&reg);
+      }
+      dmtxDecodeDestroy(&dec);
+   }
+
+   dmtxEncodeDestroy(&enc);
+
+   return match;
+}
+
+/**
+ *
+ *
+ */
+static const char *
+baseName(const char *path)
+{
+   const char *slash;
+
+   slash = strrchr(path, '/');
+
+   return (slash == NULL) ? path : slash + 1;
+}
@@ -0,0 +1,454 @@
+/**
+ * libdmtx - Data Matrix Encoding/Decoding Library
+ * Copyright 2011 Mike Laughton. All rights reserved.
+ *
+ * See LICENSE file in the main project directory for full
+ * terms of use and distribution.
+ *
+ * Contact: Mike Laughton <mike@dragonflylogic.com>
+ *
+ * \file kernel_bench.c
+ *
+ * Times the library's hot internal functions one at a time. The library is
+ * compiled into this program (see the include of dmtx.c below) so its static
+ * functions can be called directly, without exporting anything from
+ * libdmtx itself.
+ *
+ * All inputs come from one fixed symbol, encoded and located once at
+ * startup. Each kernel is called repeatedly for a warm-up round and then for
+ * a number of timed rounds, and the median and fastest round are reported
+ * per call. Cycle counts are read from the time stamp counter on x86 and are
+ * omitted elsewhere. Kernels that modify their input (module placement when
+ * reading, Reed-Solomon repair) restore it with a memcpy() on each call,
+ * and that copy is included in their time.
+ *
+ * Usage: kernel_bench [-r rounds] [kernel...]
+ */
+
+#include "../../dmtx.c"
+
+#define ROUNDS_DEFAULT      9
+#define ROUNDS_MAX        101
+
+typedef struct {
+   DmtxEncode     *enc;
+   DmtxDecode     *dec;         /* Decoder holding fitted region */
+   DmtxRegion     *reg;
+   DmtxDecode     *trailDec;    /* Decoder holding a live edge trail */
+   DmtxRegion      trailReg;
+   DmtxPointFlow   flowBegin;   /* Strong edge at start of trail */
+   const DmtxSymbolInfo *info;
+   DmtxMessage    *msg;
+   unsigned char  *arrayRead;   /* Module array as read from the image */
+   unsigned char  *codeClean;   /* Codewords with error words */
+   unsigned char  *codeDamaged; /* Same with correctable errors */
+   unsigned char  *codeWork;
+   int             moduleIdx;
+   DmtxByte        inputStorage[256];
+   DmtxByte        outputStorage[4096];
+   DmtxByteList    input;
+   DmtxByteList    output;
+   long            sink;        /* Keeps results alive */
+} BenchContext;
+
+typedef struct {
+   const char     *name;
+   long            calls;       /* Calls per round */
+   void          (*run)(BenchContext *ctx);
+} Kernel;
+
+static DmtxPassFail benchSetup(BenchContext *ctx);
+static void benchKernel(BenchContext *ctx, const Kernel *kernel, int rounds);
+static double readCycles(void);
+static int compareDouble(const void *a, const void *b);
+static void runGetPointFlow(BenchContext *ctx);
+static void runFindBestSolidLine(BenchContext *ctx);
+static void runReadModuleColor(BenchContext *ctx);
+static void runPopulateArrayFromMatrix(BenchContext *ctx);
+static void runModulePlacementRead(BenchContext *ctx);
+static void runModulePlacementWrite(BenchContext *ctx);
+static void runRsEncode(BenchContext *ctx);
+static void runRsDecodeClean(BenchContext *ctx);
+static void runRsDecodeErrors(BenchContext *ctx);
+static void runDecodeDataStream(BenchContext *ctx);
+static void runEncodeOptimizeBest(BenchContext *ctx);
+
+static const Kernel kernels[] = {
+   { "GetPointFlow",             2000000, runGetPointFlow },
+   { "FindBestSolidLine",           1000, runFindBestSolidLine },
+   { "ReadModuleColor",          1000000, runReadModuleColor },
+   { "PopulateArrayFromMatrix",      300, runPopulateArrayFromMatrix },
+   { "ModulePlacementEcc200/read", 50000, runModulePlacementRead },
+   { "ModulePlacementEcc200/write", 50000, runModulePlacementWrite },
+   { "RsEncode",                   20000, runRsEncode },
+   { "RsDecode/clean",             20000, runRsDecodeClean },
+   { "RsDecode/errors",            10000, runRsDecodeErrors },
+   { "DecodeDataStream",          500000, runDecodeDataStream },
+   { "EncodeOptimizeBest",           300, runEncodeOptimizeBest }
+};
+
+static const char *payload =
+      "Kernel benchmark 2011-06-01: LIBDMTX 0123456789 abcdefghijklmnop "
+      "QRSTUVWXYZ 9876543210 data matrix ECC200 *>* 31415926535897932384";
+
+int
+main(int argc, char *argv[])
+{
+   int i, k, rounds, selected, matched;
+   BenchContext ctx;
+
+   rounds = ROUNDS_DEFAULT;
+   selected = 0;
+   for(i = 1; i < argc; i++)
+   {
+      if(strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+      {
+         rounds = atoi(argv[++i]);
+         argv[i - 1] = argv[i] = NULL;
+      }
+      else
+      {
+         selected++;
+      }
+   }
+
+   if(rounds < 1 || rounds > ROUNDS_MAX)
+   {
+      fprintf(stderr, "usage: %s [-r rounds] [kernel...]\n", argv[0]);
+      exit(1);
+   }
+
+   if(benchSetup(&ctx) == DmtxFail)
+   {
+      fprintf(stderr, "unable to prepare benchmark symbol\n");
+      exit(1);
+   }
+
+   fprintf(stdout, "libdmtx %s, %dx%d symbol, %d round(s)\n\n", dmtxVersion(),
+         ctx.info->symbolRows, ctx.info->symbolCols, rounds);
+   fprintf(stdout, "%-28s %9s %11s %11s %11s\n", "kernel", "calls", "median ns",
+         "min ns", "cycles");
+
+   for(k = 0; k < (int)(sizeof(kernels)/sizeof(kernels[0])); k++)
+   {
+      matched = (selected == 0);
+      for(i = 1; i < argc && !matched; i++)
+      {
+         if(argv[i] != NULL && strncmp(kernels[k].name, argv[i], strlen(argv[i])) == 0)
+            matched = 1;
+      }
+
+      if(matched)
+         benchKernel(&ctx, &kernels[k], rounds);
+   }
+
+   dmtxMessageDestroy(&ctx.msg);
+   dmtxRegionDestroy(&ctx.reg);
+   dmtxDecodeDestroy(&ctx.trailDec);
+   dmtxDecodeDestroy(&ctx.dec);
+   dmtxEncodeDestroy(&ctx.enc);
+   free(ctx.arrayRead);
+   free(ctx.codeClean);
+   free(ctx.codeDamaged);
+   free(ctx.codeWork);
+
+   exit((ctx.sink == 0) ? 1 : 0);
+}
+
+/**
+ * Encode the fixed payload, fit its region, and derive every kernel's
+ * input from it, checking along the way that the symbol reads back
+ * correctly.
+ */
+static DmtxPassFail
+benchSetup(BenchContext *ctx)
+{
+   int i, x, y, payloadSize, codeSize;
+   DmtxPixelLoc loc;
+
+   memset(ctx, 0x00, sizeof(BenchContext));
+   payloadSize = (int)strlen(payload);
+
+   ctx->enc = dmtxEncodeCreate();
+   if(ctx->enc == NULL)
+      return DmtxFail;
+
+   dmtxEncodeSetProp(ctx->enc, DmtxPropModuleSize, 6);
+   dmtxEncodeSetProp(ctx->enc, DmtxPropMarginSize, 12);
+   if(dmtxEncodeDataMatrix(ctx->enc, payloadSize, (unsigned char *)payload) == DmtxFail)
+      return DmtxFail;
+
+   ctx->dec = dmtxDecodeCreate(ctx->enc->image, 1);
+   ctx->trailDec = dmtxDecodeCreate(ctx->enc->image, 1);
+   if(ctx->dec == NULL || ctx->trailDec == NULL)
+      return DmtxFail;
+
+   ctx->reg = dmtxRegionFindNext(ctx->dec, NULL);
+   if(ctx->reg == NULL)
+      return DmtxFail;
+
+   ctx->info = dmtxGetSymbolInfo(ctx->reg->sizeIdx);
+   ctx->msg = dmtxMessageCreate(ctx->reg->sizeIdx, DmtxFormatMatrix);
+   if(ctx->msg == NULL)
+      return DmtxFail;
+
+   codeSize = ctx->info->symbolDataWords + ctx->info->symbolErrorWords;
+   ctx->arrayRead = (unsigned char *)malloc(ctx->msg->arraySize);
+   ctx->codeClean = (unsigned char *)malloc(codeSize);
+   ctx->codeDamaged = (unsigned char *)malloc(codeSize);
+   ctx->codeWork = (unsigned char *)malloc(codeSize);
+   if(ctx->arrayRead == NULL || ctx->codeClean == NULL || ctx->codeDamaged == NULL ||
+         ctx->codeWork == NULL)
+      return DmtxFail;
+
+   /* Read symbol the way dmtxDecodeMatrixRegion() does */
+   if(PopulateArrayFromMatrix(ctx->dec, ctx->reg, ctx->msg) == DmtxFail)
+      return DmtxFail;
+   memcpy(ctx->arrayRead, ctx->msg->array, ctx->msg->arraySize);
+
+   ModulePlacementEcc200(ctx->msg->array, ctx->msg->code, ctx->reg->sizeIdx, DmtxModuleOnRGB);
+   if(RsDecode(ctx->msg->code, ctx->reg->sizeIdx, DmtxUndefined) == DmtxFail)
+      return DmtxFail;
+   memcpy(ctx->codeClean, ctx->msg->code, codeSize);
+
+   DecodeDataStream(ctx->msg, ctx->reg->sizeIdx, NULL, NULL);
+   if(ctx->msg->outputIdx != payloadSize || memcmp(ctx->msg->output, payload, payloadSize) != 0)
+      return DmtxFail;
+
+   /* Damage a quarter of the error words' worth of leading codewords, which
+      interleaving spreads evenly over the blocks so each stays correctable */
+   memcpy(ctx->codeDamaged, ctx->codeClean, codeSize);
+   for(i = 0; i < ctx->info->symbolErrorWords / 4; i++)
+      ctx->codeDamaged[i] ^= 0x5a;
+
+   /* Find a strong edge and blaze its trail, which then stays in the cache */
+   loc.Y = ctx->enc->image->height / 2;
+   for(x = 0; x < ctx->enc->image->width; x++)
+   {
+      loc.X = x;
+      ctx->flowBegin = MatrixRegionSeekEdge(ctx->trailDec, loc);
+      if(ctx->flowBegin.mag >= (int)(ctx->trailDec->edgeThresh * 7.65 + 0.5))
+         break;
+   }
+   if(x == ctx->enc->image->width)
+      return DmtxFail;
+
+   if(TrailBlazeContinuous(ctx->trailDec, &ctx->trailReg, ctx->flowBegin,
+         DmtxUndefined) == DmtxFail || ctx->trailReg.stepsTotal < 40)
+      return DmtxFail;
+
+   /* Mixed payload that keeps every scheme in play */
+   ctx->input = dmtxByteListBuild(ctx->inputStorage, sizeof(ctx->inputStorage));
+   ctx->output = dmtxByteListBuild(ctx->outputStorage, sizeof(ctx->outputStorage));
+   for(y = 0; y < payloadSize && y < ctx->input.capacity; y++)
+      ctx->input.b[y] = (DmtxByte)payload[y];
+   ctx->input.length = y;
+
+   return DmtxPass;
+}
+
+/**
+ *
+ *
+ */
+static void
+benchKernel(BenchContext *ctx, const Kernel *kernel, int rounds)
+{
+   int r;
+   long i;
+   double cycleStart;
+   double nsec[ROUNDS_MAX], cycles[ROUNDS_MAX];
+   DmtxTime start;
+
+   /* Warm-up fills caches and settles clock frequency */
+   for(i = 0; i < kernel->calls; i++)
+      (*kernel->run)(ctx);
+
+   for(r = 0; r < rounds; r++)
+   {
+      start = dmtxTimeNow();
+      cycleStart = readCycles();
+
+      for(i = 0; i < kernel->calls; i++)
+         (*kernel->run)(ctx);
+
+      cycles[r] = (readCycles() - cycleStart) / kernel->calls;
+      nsec[r] = TimeElapsedNsec(start) / kernel->calls;
+   }
+
+   qsort(nsec, rounds, sizeof(double), compareDouble);
+   qsort(cycles, rounds, sizeof(double), compareDouble);
+
+   if(cycles[rounds/2] > 0.0)
+      fprintf(stdout, "%-28s %9ld %11.1f %11.1f %11.0f\n", kernel->name, kernel->calls,
+            nsec[rounds/2], nsec[0], cycles[rounds/2]);
+   else
+      fprintf(stdout, "%-28s %9ld %11.1f %11.1f %11s\n", kernel->name, kernel->calls,
+            nsec[rounds/2], nsec[0], "n/a");
+}
+
+/**
+ * Read the time stamp counter, or return 0 where there isn't one
+ */
+static double
+readCycles(void)
+{
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+   unsigned int lo, hi;
+
+   __asm__ __volatile__ ("rdtsc" : "=a" (lo), "=d" (hi));
+
+   return (double)hi * 4294967296.0 + (double)lo;
+#else
+   return 0.0;
+#endif
+}
+
+/**
+ *
+ *
+ */
+static int
+compareDouble(const void *a, const void *b)
+{
+   double da, db;
+
+   da = *(const double *)a;
+   db = *(const double *)b;
+
+   return (da < db) ? -1 : (da > db) ? 1 : 0;
+}
+
+/**
+ *
+ *
+ */
+static void
+runGetPointFlow(BenchContext *ctx)
+{
+   DmtxPointFlow flow;
+
+   flow = GetPointFlow(ctx->trailDec, ctx->flowBegin.plane, ctx->flowBegin.loc, dmtxNeighborNone);
+   ctx->sink += flow.mag;
+}
+
+/**
+ *
+ *
+ */
+static void
+runFindBestSolidLine(BenchContext *ctx)
+{
+   DmtxBestLine line;
+
+   line = FindBestSolidLine(ctx->trailDec, &ctx->trailReg, 0, 0, +1, DmtxUndefined);
+   ctx->sink += line.mag;
+}
+
+/**
+ * Steps through every module of the symbol, one per call
+ */
+static void
+runReadModuleColor(BenchContext *ctx)
+{
+   int row, col;
+
+   row = ctx->moduleIdx / ctx->info->symbolCols;
+   col = ctx->moduleIdx % ctx->info->symbolCols;
+   ctx->moduleIdx = (ctx->moduleIdx + 1) % (ctx->info->symbolRows * ctx->info->symbolCols);
+
+   ctx->sink += ReadModuleColor(ctx->dec, ctx->reg, row, col, ctx->info,
+         ctx->reg->flowBegin.plane);
+}
+
+/**
+ *
+ *
+ */
+static void
+runPopulateArrayFromMatrix(BenchContext *ctx)
+{
+   ctx->sink += PopulateArrayFromMatrix(ctx->dec, ctx->reg, ctx->msg);
+}
+
+/**
+ * Reading marks modules visited, so each call starts from the array as read
+ */
+static void
+runModulePlacementRead(BenchContext *ctx)
+{
+   memcpy(ctx->msg->array, ctx->arrayRead, ctx->msg->arraySize);
+   ctx->sink += ModulePlacementEcc200(ctx->msg->array, ctx->msg->code,
+         ctx->reg->sizeIdx, DmtxModuleOnRGB);
+}
+
+/**
+ *
+ *
+ */
+static void
+runModulePlacementWrite(BenchContext *ctx)
+{
+   memset(ctx->msg->array, 0x00, ctx->msg->arraySize);
+   ctx->sink += ModulePlacementEcc200(ctx->msg->array, ctx->codeClean,
+         ctx->reg->sizeIdx, DmtxModuleOnRGB);
+}
+
+/**
+ *
+ *
+ */
+static void
+runRsEncode(BenchContext *ctx)
+{
+   memcpy(ctx->msg->code, ctx->codeClean, ctx->info->symbolDataWords);
+   ctx->sink += RsEncode(ctx->msg, ctx->reg->sizeIdx);
+}
+
+/**
+ *
+ *
+ */
+static void
+runRsDecodeClean(BenchContext *ctx)
+{
+   memcpy(ctx->codeWork, ctx->codeClean,
+         ctx->info->symbolDataWords + ctx->info->symbolErrorWords);
+   ctx->sink += RsDecode(ctx->codeWork, ctx->reg->sizeIdx, DmtxUndefined);
+}
+
+/**
+ *
+ *
+ */
+static void
+runRsDecodeErrors(BenchContext *ctx)
+{
+   memcpy(ctx->codeWork, ctx->codeDamaged,
+         ctx->info->symbolDataWords + ctx->info->symbolErrorWords);
+   ctx->sink += RsDecode(ctx->codeWork, ctx->reg->sizeIdx, DmtxUndefined);
+}
+
+/**
+ *
+ *
+ */
+static void
+runDecodeDataStream(BenchContext *ctx)
+{
+   memcpy(ctx->msg->code, ctx->codeClean, ctx->info->symbolDataWords);
+   DecodeDataStream(ctx->msg, ctx->reg->sizeIdx, NULL, NULL);
+   ctx->sink += ctx->msg->outputIdx;
+}
+
+/**
+ *
+ *
+ */
+static void
+runEncodeOptimizeBest(BenchContext *ctx)
+{
+   ctx->output.length = 0;
+   ctx->sink += EncodeOptimizeBest(&ctx->input, &ctx->output, DmtxSymbolSquareAuto,
+         AllocSelect(NULL));
+}
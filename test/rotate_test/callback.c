@@ -392,3 +392,21 @@ void FinalCallback(DmtxDecode *decode, DmtxRegion *region)
       }
    }
 }
+
+/**
+ * Route decoder trace events to the matching plot callbacks
+ *
+ */
+void TraceCallback(const DmtxTraceEvent *event, void *userData)
+{
+   switch(event->type) {
+      case DmtxTraceSeed:
+         PlotPointCallback(event->loc, 1, 1, 1);
+         break;
+      case DmtxTraceRegion:
+         BuildMatrixCallback2((DmtxRegion *)event->reg);
+         break;
+      default:
+         break;
+   }
+}
@@ -108,6 +108,8 @@ int main(int argc, char *argv[])
       dec = dmtxDecodeCreate(gImage, 1);
       assert(dec != NULL);
 
+      dmtxDecodeSetTrace(dec, TraceCallback, DmtxTraceSeed | DmtxTraceRegion, NULL);
+
       for(;;) {
          timeout = dmtxTimeAdd(dmtxTimeNow(), 500);
 
@@ -19,7 +19,8 @@
 int
 main(int argc, char *argv[])
 {
-   size_t          width, height, bytesPerPixel;
+   int             i;
+   size_t          width, height, bytesPerPixel, arenaUsed;
    unsigned char   str[] = "30Q324343430794<OQQ";
    unsigned char  *pxl;
    DmtxEncode     *enc;
@@ -68,6 +69,29 @@ main(int argc, char *argv[])
       dmtxRegionDestroy(&reg);
    }
 
+   dmtxDecodeDestroy(&dec);
+
+   /* 4) DECODE again from an arena, checking that destroying each message
+         and then its region gives all of their memory back */
+
+   dec = dmtxDecodeCreate(img, 1);
+   assert(dec != NULL);
+   assert(dmtxDecodeSetArena(dec, NULL, 65536) == DmtxPass);
+   arenaUsed = dec->arena.used;
+
+   reg = dmtxRegionFindNext(dec, NULL);
+   assert(reg != NULL && reg->arena != NULL);
+   for(i = 0; i < 5; i++) {
+      msg = dmtxDecodeMatrixRegion(dec, reg, DmtxUndefined);
+      assert(msg != NULL && msg->arena != NULL);
+      assert(msg->outputIdx == (int)strlen((const char *)str));
+      dmtxMessageDestroy(&msg);
+   }
+   dmtxRegionDestroy(&reg);
+   assert(dec->arena.used == arenaUsed);
+   fprintf(stdout, "arena:  %d bytes held after 5 decodes\n",
+         (int)(dec->arena.used - arenaUsed));
+
    dmtxDecodeDestroy(&dec);
    dmtxImageDestroy(&img);
    free(pxl);